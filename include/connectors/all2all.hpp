@@ -38,6 +38,7 @@ template <
     Policy_t POLICY_T,
     int N,
     int M,
+    typename HASH_T = modulo_hash_t,
     typename STREAM_IN,
     typename STREAM_OUT,
     typename KEY_EXTRACTOR_T = int
@@ -59,18 +60,19 @@ void Emitter(
     );
 
 #pragma HLS dataflow
+    FX_DATAFLOW;
 
 Emitter:
     for (int i = 0; i < N; ++i) {
     #pragma HLS unroll
         if (POLICY_T == RR) {
-            fx::StoSN_RR<M>(istrms[i], ostrms[i], "Emitter_RR");
+            FX_PROCESS_I(i, fx::StoSN_RR<M>(istrms[i], ostrms[i], "Emitter_RR"));
         } else if (POLICY_T == LB) {
-            fx::StoSN_LB<M>(istrms[i], ostrms[i], "Emitter_LB");
+            FX_PROCESS_I(i, fx::StoSN_LB<M>(istrms[i], ostrms[i], "Emitter_LB"));
         } else if (POLICY_T == KB) {
-            fx::StoSN_KB<M>(istrms[i], ostrms[i], std::forward<KEY_EXTRACTOR_T>(key_extractor), "Emitter_KB");
+            FX_PROCESS_I(i, fx::StoSN_KB<M, HASH_T>(istrms[i], ostrms[i], std::forward<KEY_EXTRACTOR_T>(key_extractor), "Emitter_KB"));
         } else if (POLICY_T == BR) {
-            fx::StoSN_BR<M>(istrms[i], ostrms[i], "Emitter_BR");
+            FX_PROCESS_I(i, fx::StoSN_BR<M>(istrms[i], ostrms[i], "Emitter_BR"));
         }
     }
 }
@@ -90,6 +92,7 @@ template <
     int N,
     int M,
     int K,
+    typename HASH_T = modulo_hash_t,
     typename STREAM_IN,
     typename STREAM_OUT,
     typename KEY_EXTRACTOR_T = int,
@@ -136,31 +139,32 @@ void ReplicateOperator(
     // TODO: chose the right depth for the streams
     fx::stream<typename STREAM_IN::data_t, 16> snm_to_op;
     fx::stream<typename STREAM_OUT::data_t, 16> op_to_smk;
+    FX_DATAFLOW;
 
     if (IN_POLICY_T == RR) {
-        fx::SNMtoS_RR<N, M>(istrms, snm_to_op, i, "ReplicateOperator_IN_POLICY_RR");
+        FX_PROCESS(fx::SNMtoS_RR<N, M>(istrms, snm_to_op, i, "ReplicateOperator_IN_POLICY_RR"));
     } else if (IN_POLICY_T == LB) {
-        fx::SNMtoS_LB<N, M>(istrms, snm_to_op, i, "ReplicateOperator_IN_POLICY_LB");
+        FX_PROCESS(fx::SNMtoS_LB<N, M>(istrms, snm_to_op, i, "ReplicateOperator_IN_POLICY_LB"));
     } else if (IN_POLICY_T == KB) {
-        fx::SNMtoS_KB<N, M>(istrms, snm_to_op, i, std::forward<KEY_GENERATOR_T>(key_generator), "ReplicateOperator_IN_POLICY_KB");
+        FX_PROCESS(fx::SNMtoS_KB<N, M>(istrms, snm_to_op, i, std::forward<KEY_GENERATOR_T>(key_generator), "ReplicateOperator_IN_POLICY_KB"));
     }
 
     if (OPERATOR_T == MAP) {
-        fx::Map<FUNCTOR_T>(snm_to_op, op_to_smk);
+        FX_PROCESS(fx::Map<FUNCTOR_T>(snm_to_op, op_to_smk));
     } else if (OPERATOR_T == FILTER) {
-        fx::Filter<FUNCTOR_T>(snm_to_op, op_to_smk);
+        FX_PROCESS(fx::Filter<FUNCTOR_T>(snm_to_op, op_to_smk));
     } else if (OPERATOR_T == FLATMAP) {
-        fx::FlatMap<FUNCTOR_T>(snm_to_op, op_to_smk);
+        FX_PROCESS(fx::FlatMap<FUNCTOR_T>(snm_to_op, op_to_smk));
     }
 
     if (OUT_POLICY_T == RR) {
-        fx::StoSN_RR<K>(op_to_smk, ostrms, "ReplicateOperator_OUT_POLICY_RR");
+        FX_PROCESS(fx::StoSN_RR<K>(op_to_smk, ostrms, "ReplicateOperator_OUT_POLICY_RR"));
     } else if (OUT_POLICY_T == LB) {
-        fx::StoSN_LB<K>(op_to_smk, ostrms, "ReplicateOperator_OUT_POLICY_LB");
+        FX_PROCESS(fx::StoSN_LB<K>(op_to_smk, ostrms, "ReplicateOperator_OUT_POLICY_LB"));
     } else if (OUT_POLICY_T == KB) {
-        fx::StoSN_KB<K>(op_to_smk, ostrms, std::forward<KEY_EXTRACTOR_T>(key_extractor), "ReplicateOperator_OUT_POLICY_KB");
+        FX_PROCESS(fx::StoSN_KB<K, HASH_T>(op_to_smk, ostrms, std::forward<KEY_EXTRACTOR_T>(key_extractor), "ReplicateOperator_OUT_POLICY_KB"));
     } else if (OUT_POLICY_T == BR) {
-        fx::StoSN_BR<K>(op_to_smk, ostrms, "ReplicateOperator_OUT_POLICY_BR");
+        FX_PROCESS(fx::StoSN_BR<K>(op_to_smk, ostrms, "ReplicateOperator_OUT_POLICY_BR"));
     }
 }
 
@@ -172,6 +176,7 @@ template <
     int N,
     int M,
     int K,
+    typename HASH_T = modulo_hash_t,
     typename STREAM_IN,
     typename STREAM_OUT,
     typename KEY_EXTRACTOR_T = int,
@@ -213,12 +218,13 @@ void Operator(
     );
 
     #pragma HLS dataflow
+    FX_DATAFLOW;
 A2AOperator:
     for (int i = 0; i < M; ++i) {
     #pragma HLS unroll
-        ReplicateOperator<OPERATOR_T, FUNCTOR_T, IN_POLICY_T, OUT_POLICY_T, N, M, K>(
+        FX_PROCESS_I(i, ReplicateOperator<OPERATOR_T, FUNCTOR_T, IN_POLICY_T, OUT_POLICY_T, N, M, K, HASH_T>(
             istrms, ostrms[i], i, std::forward<KEY_EXTRACTOR_T>(key_extractor), std::forward<KEY_GENERATOR_T>(key_generator)
-        );
+        ));
     }
 }
 
@@ -253,20 +259,242 @@ void Collector(
     );
 
 #pragma HLS dataflow
+    FX_DATAFLOW;
 Collector:
     for (int i = 0; i < M; ++i) {
     #pragma HLS unroll
         if (POLICY_T == RR) {
-            fx::SNMtoS_RR<N, M>(istrms, ostrms[i], i, "Collector_RR");
+            FX_PROCESS_I(i, fx::SNMtoS_RR<N, M>(istrms, ostrms[i], i, "Collector_RR"));
         } else if (POLICY_T == LB) {
-            fx::SNMtoS_LB<N, M>(istrms, ostrms[i], i, "Collector_LB");
+            FX_PROCESS_I(i, fx::SNMtoS_LB<N, M>(istrms, ostrms[i], i, "Collector_LB"));
         } else if (POLICY_T == KB) {
-            fx::SNMtoS_KB<N, M>(istrms, ostrms[i], i, std::forward<KEY_GENERATOR_T>(key_generator), "Collector_KB");
+            FX_PROCESS_I(i, fx::SNMtoS_KB<N, M>(istrms, ostrms[i], i, std::forward<KEY_GENERATOR_T>(key_generator), "Collector_KB"));
         }
     }
 }
 
 
+//******************************************************************************
+//
+// Butterfly
+//
+//******************************************************************************
+
+// 2x2 switch of the butterfly network. The heads of both inputs are held in
+// registers and each output is written at most once per cycle, so the switch
+// forwards two tuples per cycle when they are directed to different outputs.
+// With KB the output is bit BIT of the destination replica, with RR the inputs
+// alternate between the outputs, with LB a tuple takes any non-full output and
+// with BR it is copied to both.
+template <
+    Policy_t POLICY_T,
+    int N,
+    int BIT,
+    typename HASH_T,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename KEY_EXTRACTOR_T
+>
+void _butterfly_switch(
+    STREAM_IN & istrm_0,
+    STREAM_IN & istrm_1,
+    STREAM_OUT & ostrm_0,
+    STREAM_OUT & ostrm_1,
+    KEY_EXTRACTOR_T && key_extractor
+)
+{
+#pragma HLS INLINE OFF
+    using T = typename STREAM_IN::data_t;
+    using MASK_T = ap_uint<2>;
+
+    const HASH_T hash;
+
+    T heads[2];
+    #pragma HLS array_partition variable=heads type=complete
+
+    MASK_T valid = 0;
+    MASK_T lasts = 0;
+    bool prio = false;
+
+    lasts[0] = istrm_0.read_eos();
+    lasts[1] = istrm_1.read_eos();
+
+Butterfly_Switch:
+    while (valid != 0 || lasts != MASK_T(3)) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        // a head is taken when the flag after it is there too: read_eos would
+        // otherwise block on the next tuple of that input and hold the other
+        // head, which closes a cycle between the switches of a stage
+        if (!valid[0] && !lasts[0] && !istrm_0.empty() && !istrm_0.empty_eos()) {
+            heads[0] = istrm_0.read();
+            lasts[0] = istrm_0.read_eos();
+            valid[0] = 1;
+        }
+        if (!valid[1] && !lasts[1] && !istrm_1.empty() && !istrm_1.empty_eos()) {
+            heads[1] = istrm_1.read();
+            lasts[1] = istrm_1.read_eos();
+            valid[1] = 1;
+        }
+
+        const MASK_T full = (MASK_T(ostrm_1.full()) << 1) | MASK_T(ostrm_0.full());
+
+        // source served by each output (-1: none), inputs in priority order
+        int src[2] = {-1, -1};
+        for (int k = 0; k < 2; ++k) {
+        #pragma HLS UNROLL
+            const int i = k ^ int(prio);
+            if (valid[i]) {
+                if (POLICY_T == BR) {
+                    if (src[0] < 0 && src[1] < 0 && full == 0) {
+                        src[0] = i;
+                        src[1] = i;
+                    }
+                } else if (POLICY_T == LB) {
+                    const int port = (src[0] < 0 && !full[0]) ? 0 : 1;
+                    if (src[port] < 0 && !full[port]) {
+                        src[port] = i;
+                    }
+                } else {
+                    int port = i ^ int(prio);
+                    if constexpr (POLICY_T == KB) {
+                        port = (hash.template index<N>(key_extractor(heads[i])) >> BIT) & 1;
+                    }
+                    if (src[port] < 0 && !full[port]) {
+                        src[port] = i;
+                    }
+                }
+            }
+        }
+
+        if (src[0] >= 0) {
+            ostrm_0.write(heads[src[0]]);
+        }
+        if (src[1] >= 0) {
+            ostrm_1.write(heads[src[1]]);
+        }
+        for (int i = 0; i < 2; ++i) {
+        #pragma HLS UNROLL
+            if (src[0] == i || src[1] == i) {
+                valid[i] = 0;
+            }
+        }
+        prio = !prio;
+    }
+
+    ostrm_0.write_eos();
+    ostrm_1.write_eos();
+}
+
+// One stage: pairs the lines that differ in BIT (from the most significant).
+template <
+    Policy_t POLICY_T,
+    int N,
+    int BIT,
+    typename HASH_T,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename KEY_EXTRACTOR_T
+>
+void _butterfly_stage(
+    STREAM_IN istrms[N],
+    STREAM_OUT ostrms[N],
+    KEY_EXTRACTOR_T && key_extractor
+)
+{
+#pragma HLS INLINE
+    FX_DATAFLOW;
+Butterfly_Stage:
+    for (int j = 0; j < N / 2; ++j) {
+    #pragma HLS UNROLL
+        FX_PROCESS_I(j,
+            const int lo = ((j >> BIT) << (BIT + 1)) | (j & ((1 << BIT) - 1));
+            const int hi = lo | (1 << BIT);
+            _butterfly_switch<POLICY_T, N, BIT, HASH_T>(
+                istrms[lo], istrms[hi], ostrms[lo], ostrms[hi],
+                std::forward<KEY_EXTRACTOR_T>(key_extractor)
+            )
+        );
+    }
+}
+
+template <
+    Policy_t POLICY_T,
+    int N,
+    int STAGE,
+    typename HASH_T,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename KEY_EXTRACTOR_T
+>
+void _butterfly_stages(
+    STREAM_IN istrms[N],
+    STREAM_OUT ostrms[N],
+    KEY_EXTRACTOR_T && key_extractor
+)
+{
+#pragma HLS INLINE
+    using T = typename STREAM_IN::data_t;
+
+    static constexpr int STAGES = LOG2_FLOOR(N);
+    static constexpr int BIT = STAGES - 1 - STAGE;
+
+    if constexpr (STAGE == STAGES - 1) {
+        _butterfly_stage<POLICY_T, N, BIT, HASH_T>(
+            istrms, ostrms, std::forward<KEY_EXTRACTOR_T>(key_extractor)
+        );
+    } else {
+        // a switch writes at most one tuple per output and cycle and buffers
+        // its inputs in its head registers: 2 slots keep the stages at II=1
+        fx::stream<T, 2> lines[N];
+        FX_DATAFLOW;
+        FX_PROCESS(_butterfly_stage<POLICY_T, N, BIT, HASH_T>(
+            istrms, lines, std::forward<KEY_EXTRACTOR_T>(key_extractor)
+        ));
+        FX_PROCESS(_butterfly_stages<POLICY_T, N, STAGE + 1, HASH_T>(
+            lines, ostrms, std::forward<KEY_EXTRACTOR_T>(key_extractor)
+        ));
+    }
+}
+
+// Connects N producers to N consumers through log2(N) stages of 2x2 switches
+// instead of an N x N matrix of FIFOs: N * log2(N) FIFOs and switches with
+// two inputs and two outputs only. With KB every tuple reaches the replica
+// selected by HASH_T as StoSN_KB would, with BR every replica receives every
+// tuple, while RR and LB spread tuples evenly and adaptively among replicas
+// without preserving the per-producer order of StoSN_RR.
+template <
+    Policy_t POLICY_T,
+    int N,
+    typename HASH_T = modulo_hash_t,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename KEY_EXTRACTOR_T = int
+>
+void Butterfly(
+    STREAM_IN istrms[N],
+    STREAM_OUT ostrms[N],
+    KEY_EXTRACTOR_T && key_extractor = 0
+)
+{
+    HW_STATIC_ASSERT(
+        (
+            POLICY_T == RR ||
+            POLICY_T == LB ||
+            POLICY_T == KB ||
+            POLICY_T == BR
+        ),
+        "FX: fx::A2A::Butterfly supports RR, LB, KB and BR policies only!"
+    );
+    HW_STATIC_ASSERT(IS_POW2(N) && N >= 2, "FX: fx::A2A::Butterfly N must be a power of 2");
+
+#pragma HLS dataflow
+    _butterfly_stages<POLICY_T, N, 0, HASH_T>(
+        istrms, ostrms, std::forward<KEY_EXTRACTOR_T>(key_extractor)
+    );
+}
+
+
 //******************************************************************************
 //
 // Generator
@@ -286,9 +514,10 @@ void ReplicateGenerator(
 )
 {
 #pragma HLS dataflow
+    FX_DATAFLOW;
     for (int i = 0; i < N; ++i) {
     #pragma HLS unroll
-        fx::Generator<INDEX_T, FUNCTOR_T, STREAM_OUT>(ostrms[i], std::forward<Args>(args)...);
+        FX_PROCESS_I(i, fx::Generator<INDEX_T, FUNCTOR_T, STREAM_OUT>(ostrms[i], std::forward<Args>(args)...));
     }
 }
 
@@ -312,9 +541,10 @@ void ReplicateDrainer(
 )
 {
 #pragma HLS dataflow
+    FX_DATAFLOW;
     for (int i = 0; i < N; ++i) {
     #pragma HLS unroll
-        fx::Drainer<INDEX_T, FUNCTOR_T, STREAM_IN>(istrms[i], std::forward<Args>(args)...);
+        FX_PROCESS_I(i, fx::Drainer<INDEX_T, FUNCTOR_T, STREAM_IN>(istrms[i], std::forward<Args>(args)...));
     }
 }
 
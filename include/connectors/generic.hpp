@@ -4,6 +4,8 @@
 #include "ap_int.h"
 #include "../common.hpp"
 #include "../streams/stream.hpp"
+#include "../datastructures/sketch.hpp"
+#include "../datastructures/hash.hpp"
 
 
 namespace fx {
@@ -229,6 +231,71 @@ SNMtoS_RR:
 //
 //******************************************************************************
 
+// Rotating priority arbiter: index of the first bit set in `mask` at or after
+// `start`, wrapping around. Returns false if no bit is set.
+// For N > G the mask is split in groups of G bits and the arbiter is composed
+// hierarchically (a G-wide encoder inside the groups and a recursive one among
+// them), so that the logic depth grows with log(N) and any N is supported.
+template <
+    int N,
+    int G = 16
+>
+bool first_from(
+    const ap_uint<N> mask,
+    const int start,
+    int & index
+)
+{
+#pragma HLS INLINE
+    HW_STATIC_ASSERT(IS_POW2(G) && G > 1, "FX: first_from group size G must be a power of 2");
+
+    if constexpr (N <= G) {
+        const ap_uint<2 * N> twice = (ap_uint<2 * N>(mask) << N) | ap_uint<2 * N>(mask);
+        const ap_uint<N> rotated = twice >> start;
+
+        int offset = 0;
+        FIRST_FROM:
+        for (int i = N - 1; i >= 0; --i) {
+        #pragma HLS UNROLL
+            if (rotated[i]) {
+                offset = i;
+            }
+        }
+
+        index = (start + offset >= N) ? (start + offset - N) : (start + offset);
+    } else {
+        static constexpr int GROUPS = (N + G - 1) / G;
+        using PADDED_T = ap_uint<GROUPS * G>;
+
+        const PADDED_T padded = mask;
+
+        ap_uint<GROUPS> any = 0;
+        FIRST_FROM_GROUPS:
+        for (int g = 0; g < GROUPS; ++g) {
+        #pragma HLS UNROLL
+            any[g] = ap_uint<G>(padded >> (g * G)) != 0;
+        }
+
+        const int start_group = start / G;
+        const int start_offset = start % G;
+        const ap_uint<G> high = ap_uint<G>(padded >> (start_group * G)) & (~ap_uint<G>(0) << start_offset);
+
+        // bits of the start group at or after `start`, otherwise the first
+        // non-empty group after it (the start group itself when wrapping)
+        int group = start_group;
+        if (high == 0) {
+            first_from<GROUPS, G>(any, (start_group + 1 == GROUPS) ? 0 : (start_group + 1), group);
+        }
+        const ap_uint<G> bits = (high != 0) ? high : ap_uint<G>(padded >> (group * G));
+
+        int offset = 0;
+        first_from<G, G>(bits, 0, offset);
+        index = group * G + offset;
+    }
+
+    return mask != 0;
+}
+
 template <
     int N,
     typename STREAM_IN,
@@ -250,19 +317,27 @@ StoSN_LB:
     while (!last) {
     #pragma HLS PIPELINE II = 1
     #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
-        if (false == ostrms[id].full()) {
+        ap_uint<N> ready = 0;
+        for (int i = 0; i < N; ++i) {
+        #pragma HLS UNROLL
+            ready[i] = !ostrms[i].full();
+        }
+
+        // first non-full replica starting from the one after the last served
+        int dest = 0;
+        if (first_from<N>(ready, id, dest)) {
             T t = istrm.read();
             last = istrm.read_eos();
 
             #if defined(__DEBUG__CONNECTORS__)
             std::stringstream ss;
-            ss << "StoSN_LB" << " (to: " << id << ", last: " << last << ")";
+            ss << "StoSN_LB" << " (to: " << dest << ", last: " << last << ")";
             print_debug(ss.str(), name, t);
             #endif
 
-            ostrms[id].write(t);
+            ostrms[dest].write(t);
+            id = (dest + 1 == N) ? 0 : (dest + 1);
         }
-        id = (id + 1 == N) ? 0 : (id + 1);
     }
 
 StoSN_LB_EOS:
@@ -302,25 +377,29 @@ SNtoS_LB:
     #pragma HLS PIPELINE II = 1
     #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
 
-        bool last = lasts[id];
-        bool empty = istrms[id].empty();
+        ap_uint<N> ready = 0;
+        for (int i = 0; i < N; ++i) {
+        #pragma HLS UNROLL
+            ready[i] = !istrms[i].empty_eos();
+        }
 
-        if (!last && !empty) {
-            T t = istrms[id].read();
+        // serve the first ready input starting from the one after the last served
+        int src = 0;
+        if (first_from<N>(ready, id, src)) {
+            if (!istrms[src].empty()) {
+                T t = istrms[src].read();
 
-            #if defined(__DEBUG__CONNECTORS__)
-            std::stringstream ss;
-            ss << "SNtoS_LB" << " (from: " << id << ", last: " << lasts[id] << ")";
-            print_debug(ss.str(), name, t);
-            #endif
+                #if defined(__DEBUG__CONNECTORS__)
+                std::stringstream ss;
+                ss << "SNtoS_LB" << " (from: " << src << ", last: " << lasts[src] << ")";
+                print_debug(ss.str(), name, t);
+                #endif
 
-            ostrm.write(t);
+                ostrm.write(t);
+            }
+            lasts[src] = istrms[src].read_eos();
+            id = (src + 1 == N) ? 0 : (src + 1);
         }
-
-        bool empty_eos = istrms[id].empty_eos();
-        lasts[id] = (last || empty_eos) ? last : istrms[id].read_eos();
-
-        id = (id + 1 == N) ? 0 : (id + 1);
     }
 
     ostrm.write_eos();
@@ -437,18 +516,19 @@ void SNtoS_LB_recursive(
     } else {
         // N > 16
         fx::stream<DATA_T, M_RES> ostrms[M_RES];
+        FX_DATAFLOW;
 
         for (int i = 0; i < M; ++i) {
         #pragma HLS unroll
-            SNtoS_LB_check<MAX_N>(istrms + i * MAX_N, ostrms[i], name);
+            FX_PROCESS_I(i, SNtoS_LB_check<MAX_N>(istrms + i * MAX_N, ostrms[i], name));
         }
  
         if constexpr (RES == 1) {
-            StoS(istrms[M * MAX_N], ostrms[M], name);
+            FX_PROCESS(StoS(istrms[M * MAX_N], ostrms[M], name));
         } else if constexpr (RES > 1) {
-            SNtoS_LB_check<RES>(istrms + M * MAX_N, ostrms[M], name);
+            FX_PROCESS(SNtoS_LB_check<RES>(istrms + M * MAX_N, ostrms[M], name));
         }
-        SNtoS_LB_recursive<M_RES>(ostrms, ostrm, name);
+        FX_PROCESS(SNtoS_LB_recursive<M_RES>(ostrms, ostrm, name));
     }
 }
 
@@ -766,18 +846,19 @@ route_min_rec(
     static constexpr int M_RES = M + (RES > 0);
 
     STREAM_INTERN ostrms[M_RES];
+    FX_DATAFLOW;
 
     for (int i = 0; i < M; ++i) {
         #pragma HLS UNROLL
-        route_min(istrms + i * 2, ostrms[i], std::forward<COMPARATOR>(comparator));
+        FX_PROCESS_I(i, route_min(istrms + i * 2, ostrms[i], std::forward<COMPARATOR>(comparator)));
     }
 
     if (RES == 1) {
         // std::cout << "SoS with RES = 1" << std::endl;
-        StoS(istrms[M * 2], ostrms[M]);
+        FX_PROCESS(StoS(istrms[M * 2], ostrms[M]));
     }
 
-    route_min_rec<M_RES>(ostrms, ostrm, std::forward<COMPARATOR>(comparator));
+    FX_PROCESS(route_min_rec<M_RES>(ostrms, ostrm, std::forward<COMPARATOR>(comparator)));
 }
 
 template <
@@ -857,25 +938,29 @@ SNMtoS_LB:
     #pragma HLS PIPELINE II = 1
     #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
 
-        bool last = lasts[id];
-        bool empty = istrms[id][m].empty();
+        ap_uint<N> ready = 0;
+        for (int i = 0; i < N; ++i) {
+        #pragma HLS UNROLL
+            ready[i] = !istrms[i][m].empty_eos();
+        }
 
-        if (!last && !empty) {
-            T t = istrms[id][m].read();
+        // serve the first ready input starting from the one after the last served
+        int src = 0;
+        if (first_from<N>(ready, id, src)) {
+            if (!istrms[src][m].empty()) {
+                T t = istrms[src][m].read();
 
-            #if defined(__DEBUG__CONNECTORS__)
-            std::stringstream ss;
-            ss << "SNMtoS_LB" << " (from: " << id << ", last: " << lasts[id] << ")";
-            print_debug(ss.str(), name, t);
-            #endif
+                #if defined(__DEBUG__CONNECTORS__)
+                std::stringstream ss;
+                ss << "SNMtoS_LB" << " (from: " << src << ", last: " << lasts[src] << ")";
+                print_debug(ss.str(), name, t);
+                #endif
 
-            ostrm.write(t);
+                ostrm.write(t);
+            }
+            lasts[src] = istrms[src][m].read_eos();
+            id = (src + 1 == N) ? 0 : (src + 1);
         }
-
-        bool empty_eos = istrms[id][m].empty_eos();
-        lasts[id] = (last || empty_eos) ? last : istrms[id][m].read_eos();
-
-        id = (id + 1 == N) ? 0 : (id + 1);
     }
 
     ostrm.write_eos();
@@ -888,8 +973,10 @@ SNMtoS_LB:
 //
 //******************************************************************************
 
+// HASH_T maps the extracted key to a replica (see datastructures/hash.hpp).
 template <
     int N,
+    typename HASH_T = modulo_hash_t,
     typename STREAM_IN,
     typename STREAM_OUT,
     typename KEY_EXTRACTOR_T
@@ -904,6 +991,8 @@ void StoSN_KB(
     UNUSED(name);
     using T = typename STREAM_IN::data_t;
 
+    const HASH_T hash;
+
     bool last = istrm.read_eos();
 
 StoSN_KB:
@@ -912,7 +1001,7 @@ StoSN_KB:
     #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
         T t = istrm.read();
         last = istrm.read_eos();
-        int key = key_extractor(t) % N;
+        int key = hash.template index<N>(key_extractor(t));
         ostrms[key].write(t);
 
         #if defined(__DEBUG__CONNECTORS__)
@@ -929,6 +1018,78 @@ StoSN_KB_EOS:
     }
 }
 
+// Key-by that tolerates skewed keys: a Space-Saving sketch tracks the heavy
+// hitters and a key carrying at least 1 / 2^HOT_SHIFT of the recent traffic is
+// spread round-robin over SPLIT consecutive replicas starting from its own.
+// `tagger(t, split)` is invoked before each write with `split` set when the
+// key is hot, so that the downstream keyed operator can mark its results as
+// partial aggregates to be merged (e.g. by a keyed Reduce after SNtoS_LB).
+template <
+    int N,
+    int SPLIT = N,
+    int SLOTS = 8,
+    int HOT_SHIFT = LOG2_FLOOR(N),
+    int AGING_LOG = 12,
+    typename HASH_T = modulo_hash_t,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename KEY_EXTRACTOR_T,
+    typename TAGGER_T
+>
+void StoSN_KB_skew(
+    STREAM_IN & istrm,
+    STREAM_OUT ostrms[N],
+    KEY_EXTRACTOR_T && key_extractor,
+    TAGGER_T && tagger,
+    const char * name = ""
+)
+{
+    HW_STATIC_ASSERT(SPLIT > 0 && SPLIT <= N, "FX: StoSN_KB_skew SPLIT must be in [1, N]");
+
+    UNUSED(name);
+    using T = typename STREAM_IN::data_t;
+    using KEY_T = unsigned int;
+
+    const HASH_T hash;
+    space_saving_t<KEY_T, SLOTS, AGING_LOG> sketch;
+    int offset = 0;
+
+    bool last = istrm.read_eos();
+
+StoSN_KB_skew:
+    while (!last) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        T t = istrm.read();
+        last = istrm.read_eos();
+
+        const KEY_T k = KEY_T(key_extractor(t));
+        const bool hot = sketch.template is_hot<HOT_SHIFT>(sketch.update(k));
+
+        int key = hash.template index<N>(k);
+        if (hot) {
+            key += offset;
+            key = (key >= N) ? (key - N) : key;
+            offset = (offset == SPLIT - 1) ? 0 : (offset + 1);
+        }
+
+        tagger(t, hot);
+        ostrms[key].write(t);
+
+        #if defined(__DEBUG__CONNECTORS__)
+        std::stringstream ss;
+        ss << "StoSN_KB_skew" << " (to: " << key << ", hot: " << hot << ", last: " << last << ")";
+        print_debug(ss.str(), name, t);
+        #endif
+    }
+
+StoSN_KB_skew_EOS:
+    for (int i = 0; i < N; ++i) {
+    #pragma HLS UNROLL
+        ostrms[i].write_eos();
+    }
+}
+
 template <
     int N,
     typename STREAM_IN,
@@ -1087,6 +1248,205 @@ StoSN_BR_EOS:
     }
 }
 
+
+//******************************************************************************
+//
+// Ordered
+//
+//******************************************************************************
+
+// Node of the tournament tree: merges two sorted streams, emitting the head
+// that comes first according to `comparator` only when both inputs have a head
+// or have ended, so that the output is sorted too. An input without a head
+// does not hold the other one back if that head does not come after the last
+// tuple taken from the input, the next one cannot come earlier: two inputs
+// fed by the same producer (StoSN_RR of a sorted stream) never wait on each
+// other. Heads for which `is_watermark` is true take part in the comparison
+// like any other tuple, which lets an idle input unblock the merge, and are
+// dropped by the root.
+template <
+    bool ROOT,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename COMPARATOR_T,
+    typename WATERMARK_T
+>
+void _ordered_merge(
+    STREAM_IN istrms[2],
+    STREAM_OUT & ostrm,
+    COMPARATOR_T && comparator,
+    WATERMARK_T && is_watermark
+)
+{
+#pragma HLS INLINE OFF
+    using T = typename STREAM_IN::data_t;
+    using MASK_T = ap_uint<2>;
+
+    T heads[2];
+    T tails[2];     // last tuple taken from each input
+    #pragma HLS array_partition variable=heads type=complete
+    #pragma HLS array_partition variable=tails type=complete
+
+    MASK_T valid = 0;
+    MASK_T lasts = 0;
+    MASK_T taken = 0;
+
+ORDERED_MERGE_INIT:
+    for (int i = 0; i < 2; ++i) {
+    #pragma HLS UNROLL
+        lasts[i] = istrms[i].read_eos();
+    }
+
+ORDERED_MERGE:
+    while (valid != 0 || lasts != MASK_T(3)) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        for (int i = 0; i < 2; ++i) {
+        #pragma HLS UNROLL
+            // wait for the eos flag after the head too: a blocking read_eos
+            // would hold the head until that input sends its next tuple
+            if (!valid[i] && !lasts[i] && !istrms[i].empty() && !istrms[i].empty_eos()) {
+                heads[i] = istrms[i].read();
+                lasts[i] = istrms[i].read_eos();
+                valid[i] = 1;
+            }
+        }
+
+        // a side without a head that has not ended could still send a tuple
+        // that comes before the head of the other side, unless that head
+        // comes before the last tuple of the side
+        MASK_T ready = 0;
+        for (int i = 0; i < 2; ++i) {
+        #pragma HLS UNROLL
+            ready[i] = valid[i] || lasts[i] || (taken[i] && valid[1 - i] && comparator(heads[1 - i], tails[i]));
+        }
+
+        if (ready == MASK_T(3) && valid != 0) {
+            const int id = (valid[0] && (!valid[1] || comparator(heads[0], heads[1]))) ? 0 : 1;
+            if (!ROOT || !is_watermark(heads[id])) {
+                ostrm.write(heads[id]);
+            }
+            tails[id] = heads[id];
+            taken[id] = 1;
+            valid[id] = 0;
+        }
+    }
+
+    ostrm.write_eos();
+}
+
+template <
+    int N,
+    bool ROOT,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename COMPARATOR_T,
+    typename WATERMARK_T
+>
+void _ordered_merge_rec(
+    STREAM_IN istrms[N],
+    STREAM_OUT & ostrm,
+    COMPARATOR_T && comparator,
+    WATERMARK_T && is_watermark
+)
+{
+#pragma HLS INLINE
+    using T = typename STREAM_IN::data_t;
+
+    static constexpr int M = N / 2;
+    static constexpr int RES = N % 2;
+    static constexpr int M_RES = M + RES;
+
+    if constexpr (N == 1) {
+        // reached only when SNtoS_Ordered is instantiated with N = 1
+        bool last = istrms[0].read_eos();
+    ORDERED_MERGE_SINGLE:
+        while (!last) {
+        #pragma HLS PIPELINE II = 1
+        #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+            T t = istrms[0].read();
+            last = istrms[0].read_eos();
+            if (!is_watermark(t)) {
+                ostrm.write(t);
+            }
+        }
+        ostrm.write_eos();
+    } else if constexpr (N == 2) {
+        _ordered_merge<ROOT>(istrms, ostrm,
+                             std::forward<COMPARATOR_T>(comparator),
+                             std::forward<WATERMARK_T>(is_watermark));
+    } else {
+        // one level of the tree: every node holds only two heads and the
+        // levels are decoupled by 2-slot FIFOs
+        fx::stream<T, 2> ostrms[M_RES];
+        FX_DATAFLOW;
+
+        for (int i = 0; i < M; ++i) {
+        #pragma HLS UNROLL
+            FX_PROCESS_I(i, _ordered_merge<false>(istrms + i * 2, ostrms[i],
+                                                  std::forward<COMPARATOR_T>(comparator),
+                                                  std::forward<WATERMARK_T>(is_watermark)));
+        }
+
+        if constexpr (RES == 1) {
+            FX_PROCESS(StoS(istrms[M * 2], ostrms[M]));
+        }
+
+        FX_PROCESS(_ordered_merge_rec<M_RES, ROOT>(ostrms, ostrm,
+                                                   std::forward<COMPARATOR_T>(comparator),
+                                                   std::forward<WATERMARK_T>(is_watermark)));
+    }
+}
+
+// Merges N streams, each sorted according to `comparator(a, b)` (true if a
+// comes before b), into one sorted stream with a pipelined tournament tree
+// that emits one tuple per cycle. An input that is temporarily empty stalls
+// the merge until it sends a tuple or ends, unless the smallest head does not
+// come after the last tuple of that input; inputs that may stay idle should
+// send periodic watermarks, recognised by `is_watermark`, which are never
+// forwarded to ostrm.
+template <
+    int N,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename COMPARATOR_T,
+    typename WATERMARK_T
+>
+void SNtoS_Ordered(
+    STREAM_IN istrms[N],
+    STREAM_OUT & ostrm,
+    COMPARATOR_T && comparator,
+    WATERMARK_T && is_watermark
+)
+{
+#pragma HLS INLINE
+    HW_STATIC_ASSERT(N > 0, "FX: SNtoS_Ordered needs at least one input");
+
+    _ordered_merge_rec<N, true>(istrms, ostrm,
+                                std::forward<COMPARATOR_T>(comparator),
+                                std::forward<WATERMARK_T>(is_watermark));
+}
+
+// Ordered merge by timestamp, for tuples exposing a `timestamp` field.
+template <
+    int N,
+    typename STREAM_IN,
+    typename STREAM_OUT
+>
+void SNtoS_Ordered(
+    STREAM_IN istrms[N],
+    STREAM_OUT & ostrm
+)
+{
+#pragma HLS INLINE
+    using T = typename STREAM_IN::data_t;
+
+    SNtoS_Ordered<N>(istrms, ostrm,
+        [](const T & a, const T & b) { return a.timestamp <= b.timestamp; },
+        [](const T &) { return false; }
+    );
+}
+
 }
 
 #endif // __CONNECTORS_GENERIC_HPP__
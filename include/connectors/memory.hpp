@@ -5,6 +5,8 @@
 #include "../common.hpp"
 #include "../connectors/connectors.hpp"
 #include "../datastructures/typehandler.hpp"
+#include "../datastructures/codec.hpp"
+#include "../datastructures/ring.hpp"
 #include "../streams/streams.hpp"
 
 
@@ -31,8 +33,8 @@ void WMtoS(
     HW_STATIC_ASSERT((W >= 8) && (W <= 512) && IS_POW2(W),
                      "AXI port width W must be power of 2 and between 8 to 512.");
 
-    constexpr int T_BITS = sizeof(T) * 8;   // item size in bits
-    constexpr int READ_ITEMS = W / T_BITS;  // number of items in a read operation
+    constexpr int T_BITS = TypeHandler<T>::WIDTH;   // item size in bits
+    constexpr int READ_ITEMS = W / T_BITS;          // number of items in a read operation
 
 WMtoS:
     for (int i = 0; i < count; ++i) {
@@ -53,14 +55,286 @@ WMtoS:
     }
 }
 
+// Wide reader: the READ_ITEMS tuples of a line are written in the same cycle,
+// item j of every line to ostrms[j], so a single port can feed READ_ITEMS
+// replicas. The II=1 loop is inferred as burst reads; set the number of
+// outstanding requests and the burst length on the m_axi port of the kernel
+// (e.g. num_read_outstanding = 16 max_read_burst_length = 64).
+template <int W, typename STREAM_OUT>
+void WMtoSN(
+    ap_uint<W> * in,
+    int count,
+    bool eos,
+    STREAM_OUT ostrms[]
+)
+{
+    using T = typename STREAM_OUT::data_t;
+
+    HW_STATIC_ASSERT(W % sizeof(T) == 0,
+                     "AXI port width W is not multiple of stream element width (sizeof(T) * 8).");
+    HW_STATIC_ASSERT((W >= 8) && (W <= 512) && IS_POW2(W),
+                     "AXI port width W must be power of 2 and between 8 to 512.");
+
+    constexpr int T_BITS = TypeHandler<T>::WIDTH;   // item size in bits
+    constexpr int READ_ITEMS = W / T_BITS;          // number of items in a read operation
+
+WMtoSN:
+    for (int i = 0; i < count; ++i) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+
+        ap_uint<W> line = in[i];
+        for (int j = 0; j < READ_ITEMS; ++j) {
+        #pragma HLS UNROLL
+            ap_uint<T_BITS> item = line.range(T_BITS * (j + 1) - 1, T_BITS * j);
+            ostrms[j].write(TypeHandler<T>::from_ap(item));
+        }
+    }
+
+    if (eos) {
+    WMtoSN_EOS:
+        for (int j = 0; j < READ_ITEMS; ++j) {
+        #pragma HLS UNROLL
+            ostrms[j].write_eos();
+        }
+    }
+}
+
+// Packs tuples into records of CODEC_T::BITS bits (the concatenated field
+// codes of a record_codec_t) and back.
+template <typename T, typename CODEC_T>
+struct _record_packer_t
+{
+    static constexpr int BITS = CODEC_T::BITS;
+
+    CODEC_T codec;
+
+    void reset(const T & first)
+    {
+    #pragma HLS INLINE
+        codec.reset(first);
+    }
+
+    ap_uint<BITS> pack(const T & t)
+    {
+    #pragma HLS INLINE
+        code_t codes[CODEC_T::FIELDS];
+        #pragma HLS array_partition variable=codes type=complete
+        codec.encode(t, codes);
+
+        ap_uint<BITS> record = 0;
+        for (unsigned int f = 0; f < CODEC_T::FIELDS; ++f) {
+        #pragma HLS UNROLL
+            record.range(CODEC_T::offset(f) + CODEC_T::width(f) - 1, CODEC_T::offset(f)) = codes[f];
+        }
+        return record;
+    }
+
+    T unpack(const ap_uint<BITS> & record)
+    {
+    #pragma HLS INLINE
+        code_t codes[CODEC_T::FIELDS];
+        #pragma HLS array_partition variable=codes type=complete
+        for (unsigned int f = 0; f < CODEC_T::FIELDS; ++f) {
+        #pragma HLS UNROLL
+            codes[f] = record.range(CODEC_T::offset(f) + CODEC_T::width(f) - 1, CODEC_T::offset(f)).to_uint64();
+        }
+        return codec.decode(codes);
+    }
+};
+
+// Reader of a batch compressed with CODEC_T (a record_codec_t). The first line
+// holds the first tuple raw, which seeds the codecs (e.g. the base of the
+// deltas); the following lines hold W / CODEC_T::BITS records each, none
+// across two lines. `count` is the number of items, header tuple included.
+template <int W, typename CODEC_T, typename STREAM_OUT>
+void WMtoS_codec(
+    ap_uint<W> * in,
+    int count,
+    bool eos,
+    STREAM_OUT & out
+)
+{
+    using T = typename STREAM_OUT::data_t;
+
+    HW_STATIC_ASSERT((W >= 8) && (W <= 512) && IS_POW2(W),
+                     "AXI port width W must be power of 2 and between 8 to 512.");
+    HW_STATIC_ASSERT((W >= CODEC_T::BITS) && (W >= TypeHandler<T>::WIDTH),
+                     "AXI port width W is smaller than the record or the stream element width.");
+    HW_STATIC_ASSERT(TypeHandler<T>::WIDTH == sizeof(T) * 8,
+                     "The header of a codec batch is the memory image of T, use the packed connectors with a PackedTypeHandler.");
+
+    constexpr int T_BITS = TypeHandler<T>::WIDTH;   // header item size in bits
+    constexpr int R_BITS = CODEC_T::BITS;           // record size in bits
+    constexpr int READ_ITEMS = W / R_BITS;          // number of records in a line
+
+    _record_packer_t<T, CODEC_T> packer;
+
+    int l = 0;  // index of the next line
+    int j = 0;  // index of the record in the current line
+    ap_uint<W> line = 0;
+
+WMtoS_codec:
+    for (int i = 0; i < count; ++i) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        if (i == 0 || j == 0) {
+            line = in[l];
+            l = l + 1;
+        }
+
+        T t;
+        if (i == 0) {
+            ap_uint<T_BITS> item = line.range(T_BITS - 1, 0);
+            t = TypeHandler<T>::from_ap(item);
+            packer.reset(t);
+        } else {
+            const ap_uint<R_BITS> record = line.range(R_BITS - 1, 0);
+            t = packer.unpack(record);
+            line = line >> R_BITS;
+            j = (j + 1 == READ_ITEMS) ? 0 : (j + 1);
+        }
+        out.write(t);
+    }
+
+    if (eos) {
+        out.write_eos();
+    }
+}
+
+template <int W, int T_BITS>
+void _read_lines(
+    ap_uint<W> * in,
+    int count,
+    fifo< ap_uint<W> > & lines
+)
+{
+    const int line_count = (int)(((long long)count * T_BITS + W - 1) / W);
+
+read_lines:
+    for (int l = 0; l < line_count; ++l) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        lines.write(in[l]);
+    }
+}
+
+template <int W, typename STREAM_OUT>
+void _unpack_lines(
+    fifo< ap_uint<W> > & lines,
+    int count,
+    bool eos,
+    STREAM_OUT & out
+)
+{
+    using T = typename STREAM_OUT::data_t;
+    constexpr int T_BITS = TypeHandler<T>::WIDTH;   // item size in bits
+
+    ap_uint<2 * W> buffer = 0;  // bits not yet unpacked
+    int valid = 0;              // number of bits in buffer
+
+unpack_lines:
+    for (int i = 0; i < count; ++i) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        if (valid < T_BITS) {
+            const ap_uint<2 * W> line = lines.read();
+            buffer = buffer | (line << valid);
+            valid = valid + W;
+        }
+
+        ap_uint<T_BITS> item = buffer.range(T_BITS - 1, 0);
+        buffer = buffer >> T_BITS;
+        valid = valid - T_BITS;
+        out.write(TypeHandler<T>::from_ap(item));
+    }
+
+    if (eos) {
+        out.write_eos();
+    }
+}
+
+// Reader of tuples packed back to back: tuple i takes bits
+// [i * T_BITS, (i + 1) * T_BITS) of the concatenated lines, so tuples of any
+// TypeHandler<T>::WIDTH (e.g. a PackedTypeHandler) straddle two lines and no
+// bit of a line is wasted. `count` is the number of items.
+template <int W, typename STREAM_OUT>
+void WMtoS_packed(
+    ap_uint<W> * in,
+    int count,
+    bool eos,
+    STREAM_OUT & out
+)
+{
+    using T = typename STREAM_OUT::data_t;
+
+    HW_STATIC_ASSERT(W >= TypeHandler<T>::WIDTH,
+                     "AXI port width W is smaller than the stream element width (TypeHandler<T>::WIDTH).");
+    HW_STATIC_ASSERT((W >= 8) && (W <= 512) && IS_POW2(W),
+                     "AXI port width W must be power of 2 and between 8 to 512.");
+
+#pragma HLS DATAFLOW
+    fifo< ap_uint<W> > lines;
+    #pragma HLS STREAM variable = lines depth = 64
+
+    FX_DATAFLOW;
+    FX_PROCESS(_read_lines<W, TypeHandler<T>::WIDTH>(in, count, lines));
+    FX_PROCESS(_unpack_lines<W>(lines, count, eos, out));
+}
+
+// Persistent reader: runs until the end of the stream, polling the control
+// block `ctrl` (see ring_ctrl_t) for the slots published by the host. Slot s
+// holds the lines [s * slot_lines, (s + 1) * slot_lines) of `ring`, laid out
+// as for WMtoS; its count is in lines. Per batch the host only writes the
+// slot and rings the doorbell, there is no kernel launch nor argument setup.
+// Map `ring` and `ctrl` on host memory (or HBM and copy) and keep `ctrl`
+// volatile so every poll is a new read.
+template <int W, int SLOTS, typename STREAM_OUT>
+void WMtoS_ring(
+    ap_uint<W> * ring,
+    volatile int * ctrl,
+    int slot_lines,
+    STREAM_OUT & out
+)
+{
+    using RING = ring_ctrl_t<SLOTS>;
+
+    int tail = 0;
+    bool last = false;
+
+WMtoS_ring:
+    while (!last) {
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        const int head = ctrl[RING::HEAD];
+        if (head != tail) {
+            const int slot = RING::slot(tail);
+            const int count = ctrl[RING::COUNT + slot];
+            last = (ctrl[RING::EOS + slot] != 0);
+
+            WMtoS<W>(ring + slot * slot_lines, count, false, out);
+
+            tail = tail + 1;
+            ctrl[RING::TAIL] = tail;
+        }
+    }
+
+    out.write_eos();
+}
+
+// With idle_cycles > 0 the burst is closed early, and the kernel returns the
+// items packed so far without eos, if the next item does not arrive within
+// idle_cycles polls of the input: low-rate outputs reach the host in bounded
+// time instead of waiting for the buffer to fill. The flag of the next item is
+// then read by the next invocation, as the leading read_eos.
 template <int W, int BURST_LENGTH = 4096 / (W / 8), typename STREAM_IN>
 void prepare_burst(
     STREAM_IN & in,
-    hls::stream< ap_uint<W> > & out,
-    hls::stream< ap_uint<8> > & burst_size,
-    hls::stream< ap_uint<16> > & items_packed,
-    hls::stream<bool> & eos_signal,
-    int out_size
+    fifo< ap_uint<W> > & out,
+    fifo< ap_uint<8> > & burst_size,
+    fifo< ap_uint<16> > & items_packed,
+    fifo<bool> & eos_signal,
+    int out_size,
+    int idle_cycles = 0
 )
 {
     using T = typename STREAM_IN::data_t;
@@ -70,66 +344,280 @@ void prepare_burst(
     HW_STATIC_ASSERT((W >= 8) && (W <= 512) && IS_POW2(W),
                      "AXI port width W must be power of 2 and between 8 to 512.");
 
-    constexpr int T_BITS = sizeof(T) * 8;           // item size in bits
+    constexpr int T_BITS = TypeHandler<T>::WIDTH;   // item size in bits
     constexpr int TMP_ITEMS = W / T_BITS;           // number of items in a write operation
     const int WRITE_MAX_COUNT = out_size / (W / 8); // max number of write operations
 
     int i = 0;  // index of tmp buffer
     int wc = 0; // count the total number of write operations
     int bc = 0; // count the number of write operations in a single burst
+    int idle = 0;
 
     ap_uint<W> tmp;
     bool last = in.read_eos();
+    bool ready = !last; // the flag of the next item has been read
+    bool flush = false; // idle_cycles elapsed without the next item
 
 prepare_burst:
+    while (!last && !flush && (wc < WRITE_MAX_COUNT)) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        if (ready) {
+            T t = in.read();
+            ready = false;
+            idle = 0;
+
+            tmp.range(T_BITS * (i + 1) - 1, T_BITS * i) = TypeHandler<T>::to_ap(t);
+
+            if (i + 1 == TMP_ITEMS) {
+                out.write(tmp);
+                i = 0;
+                wc = wc + 1;
+
+                // signal a complete burst
+                if (bc + 1 == BURST_LENGTH) {
+                    burst_size.write(BURST_LENGTH);
+                    items_packed.write(BURST_LENGTH * TMP_ITEMS);
+                    bc = 0;
+                } else {
+                    bc = bc + 1;
+                }
+            } else {
+                i = i + 1;
+            }
+        }
+
+        // the flag of the next item is left to the next invocation once the
+        // buffer is full
+        if (!ready && (wc < WRITE_MAX_COUNT)) {
+            if (idle_cycles <= 0) {
+                last = in.read_eos();
+                ready = !last;
+            } else {
+                bool e;
+                if (in.read_eos_nb(e)) {
+                    last = e;
+                    ready = !e;
+                } else {
+                    idle = idle + 1;
+                    flush = (idle >= idle_cycles);
+                }
+            }
+        }
+    }
+
+    // write remaining items
+    if (i != 0) {
+    remaining_items:
+        for (int j = 0; j < TMP_ITEMS; ++j) {
+        #pragma HLS unroll
+            if (j >= i) {
+                tmp.range(T_BITS * (j + 1) - 1, T_BITS * j) = 0;
+            }
+        }
+        out.write(tmp);
+        bc = bc + 1;
+    }
+
+    // last burst or partial burst (the partially filled line holds i items)
+    if (bc != 0) {
+        burst_size.write(bc);
+        items_packed.write((i != 0) ? ((bc - 1) * TMP_ITEMS + i) : (bc * TMP_ITEMS));
+    }
+    // no more writes
+    burst_size.write(0);
+    items_packed.write(0);
+
+    // propagate EOS
+    eos_signal.write(last);
+}
+
+// Compressing counterpart of prepare_burst, with the layout of WMtoS_codec:
+// a header line with the first tuple raw, then records of CODEC_T::BITS bits.
+template <int W, typename CODEC_T, int BURST_LENGTH = 4096 / (W / 8), typename STREAM_IN>
+void prepare_burst_codec(
+    STREAM_IN & in,
+    fifo< ap_uint<W> > & out,
+    fifo< ap_uint<8> > & burst_size,
+    fifo< ap_uint<16> > & items_packed,
+    fifo<bool> & eos_signal,
+    int out_size
+)
+{
+    using T = typename STREAM_IN::data_t;
+
+    HW_STATIC_ASSERT((W >= 8) && (W <= 512) && IS_POW2(W),
+                     "AXI port width W must be power of 2 and between 8 to 512.");
+    HW_STATIC_ASSERT((W >= CODEC_T::BITS) && (W >= TypeHandler<T>::WIDTH),
+                     "AXI port width W is smaller than the record or the stream element width.");
+    HW_STATIC_ASSERT(TypeHandler<T>::WIDTH == sizeof(T) * 8,
+                     "The header of a codec batch is the memory image of T, use the packed connectors with a PackedTypeHandler.");
+
+    constexpr int T_BITS = TypeHandler<T>::WIDTH;   // header item size in bits
+    constexpr int R_BITS = CODEC_T::BITS;           // record size in bits
+    constexpr int TMP_ITEMS = W / R_BITS;           // number of records in a line
+    const int WRITE_MAX_COUNT = out_size / (W / 8); // max number of write operations
+
+    _record_packer_t<T, CODEC_T> packer;
+
+    bool header = true;
+    int i = 0;  // index of tmp buffer
+    int wc = 0; // count the total number of write operations
+    int bc = 0; // count the number of write operations in a single burst
+    int ic = 0; // count the items in the lines of the current burst
+
+    ap_uint<W> tmp = 0;
+    bool last = in.read_eos();
+
+prepare_burst_codec:
     while (!last && (wc < WRITE_MAX_COUNT)) {
     #pragma HLS PIPELINE II = 1
     #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
         T t = in.read();
 
-        if ((i + 1 == TMP_ITEMS) && (wc + 1 == WRITE_MAX_COUNT)) {
-            // last = true;
+        ap_uint<W> line = 0;
+        bool line_ready = false;
+        int line_items = 0;
+
+        if (header) {
+            packer.reset(t);
+            line.range(T_BITS - 1, 0) = TypeHandler<T>::to_ap(t);
+            line_ready = true;
+            line_items = 1;
+            header = false;
         } else {
-            last = in.read_eos();
+            tmp.range(R_BITS * (i + 1) - 1, R_BITS * i) = packer.pack(t);
+            if (i + 1 == TMP_ITEMS) {
+                line = tmp;
+                line_ready = true;
+                line_items = TMP_ITEMS;
+                tmp = 0;
+                i = 0;
+            } else {
+                i = i + 1;
+            }
         }
 
-        tmp.range(T_BITS * (i + 1) - 1, T_BITS * i) = TypeHandler<T>::to_ap(t);
-
-        if (i + 1 == TMP_ITEMS) {
-            out.write(tmp);
-            i = 0;
+        if (line_ready) {
+            out.write(line);
             wc = wc + 1;
+            ic = ic + line_items;
 
             // signal a complete burst
             if (bc + 1 == BURST_LENGTH) {
                 burst_size.write(BURST_LENGTH);
-                items_packed.write(BURST_LENGTH * TMP_ITEMS);
+                items_packed.write(ic);
                 bc = 0;
+                ic = 0;
             } else {
                 bc = bc + 1;
             }
-        } else {
-            i = i + 1;
+        }
+
+        // the flag of the next item is left to the next invocation once the
+        // buffer is full
+        if (wc < WRITE_MAX_COUNT) {
+            last = in.read_eos();
         }
     }
 
     // write remaining items
     if (i != 0) {
-    remaining_items:
-        for (int j = 0; j < TMP_ITEMS; ++j) {
-        #pragma HLS unroll
-            if (j >= i) {
-                tmp.range(T_BITS * (j + 1) - 1, T_BITS * j) = 0;
+        out.write(tmp);
+        bc = bc + 1;
+        ic = ic + i;
+    }
+
+    // last burst or partial burst
+    if (bc != 0) {
+        burst_size.write(bc);
+        items_packed.write(ic);
+    }
+    // no more writes
+    burst_size.write(0);
+    items_packed.write(0);
+
+    // propagate EOS
+    eos_signal.write(last);
+}
+
+// Counterpart of prepare_burst with the layout of WMtoS_packed: tuples are
+// packed back to back, straddling two lines when W is not a multiple of
+// TypeHandler<T>::WIDTH.
+template <int W, int BURST_LENGTH = 4096 / (W / 8), typename STREAM_IN>
+void prepare_burst_packed(
+    STREAM_IN & in,
+    fifo< ap_uint<W> > & out,
+    fifo< ap_uint<8> > & burst_size,
+    fifo< ap_uint<16> > & items_packed,
+    fifo<bool> & eos_signal,
+    int out_size
+)
+{
+    using T = typename STREAM_IN::data_t;
+
+    HW_STATIC_ASSERT(W >= TypeHandler<T>::WIDTH,
+                     "AXI port width W is smaller than the stream element width (TypeHandler<T>::WIDTH).");
+    HW_STATIC_ASSERT((W >= 8) && (W <= 512) && IS_POW2(W),
+                     "AXI port width W must be power of 2 and between 8 to 512.");
+
+    constexpr int T_BITS = TypeHandler<T>::WIDTH;   // item size in bits
+    const int WRITE_MAX_COUNT = out_size / (W / 8); // max number of write operations
+    const long long MAX_ITEMS = ((long long)WRITE_MAX_COUNT * W) / T_BITS;
+
+    long long n = 0;    // count the total number of items
+    int bc = 0;         // count the number of write operations in a single burst
+    int ic = 0;         // count the items in the lines of the current burst
+
+    ap_uint<2 * W> buffer = 0;  // bits not yet written
+    int valid = 0;              // number of bits in buffer
+    bool last = in.read_eos();
+
+prepare_burst_packed:
+    while (!last && (n < MAX_ITEMS)) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        T t = in.read();
+        n = n + 1;
+
+        if (n == MAX_ITEMS) {
+            // last = true;
+        } else {
+            last = in.read_eos();
+        }
+
+        const ap_uint<2 * W> item = TypeHandler<T>::to_ap(t);
+        buffer = buffer | (item << valid);
+        valid = valid + T_BITS;
+        ic = ic + 1;
+
+        if (valid >= W) {
+            out.write(buffer.range(W - 1, 0));
+            buffer = buffer >> W;
+            valid = valid - W;
+
+            // signal a complete burst
+            if (bc + 1 == BURST_LENGTH) {
+                burst_size.write(BURST_LENGTH);
+                items_packed.write(ic);
+                bc = 0;
+                ic = 0;
+            } else {
+                bc = bc + 1;
             }
         }
-        out.write(tmp);
+    }
+
+    // write remaining bits
+    if (valid != 0) {
+        out.write(buffer.range(W - 1, 0));
         bc = bc + 1;
     }
 
     // last burst or partial burst
     if (bc != 0) {
         burst_size.write(bc);
-        items_packed.write(bc * TMP_ITEMS + i);
+        items_packed.write(ic);
     }
     // no more writes
     burst_size.write(0);
@@ -141,10 +629,10 @@ prepare_burst:
 
 template <int W, int BURST_LENGTH = 4096 / (W / 8)>
 void burst_write(
-    hls::stream< ap_uint<W> > & in,
-    hls::stream< ap_uint<8> > & burst_size,
-    hls::stream< ap_uint<16> > & items_packed,
-    hls::stream<bool> & eos_signal,
+    fifo< ap_uint<W> > & in,
+    fifo< ap_uint<8> > & burst_size,
+    fifo< ap_uint<16> > & items_packed,
+    fifo<bool> & eos_signal,
     ap_uint<W> * out,
     int * items_written,
     int * eos
@@ -173,8 +661,70 @@ burst_write:
     eos[0] = (eos_signal.read() ? 1 : 0);
 }
 
+// With idle_cycles > 0 the kernel also returns, without eos, when no item
+// arrives for idle_cycles cycles (see prepare_burst); items_written is then
+// smaller than the buffer.
 template <int W, int BURST_LENGTH = 4096 / (W / 8), typename STREAM_IN>
 void StoWM(
+    STREAM_IN & in,
+    ap_uint<W> * out,
+    int out_size,
+    int * items_written,
+    int * eos,
+    int idle_cycles = 0
+)
+{
+#pragma HLS DATAFLOW
+    fifo< ap_uint<W> > internal_stream;
+    fifo< ap_uint<8> > burst_size;
+    fifo< ap_uint<16> > items_packed;
+    fifo<bool> eos_signal;
+
+    constexpr int fifo_buf = 2 * BURST_LENGTH;
+
+    #pragma HLS STREAM variable = internal_stream depth = fifo_buf
+    #pragma HLS STREAM variable = burst_size depth = 2
+    #pragma HLS STREAM variable = items_packed depth = 2
+    #pragma HLS STREAM variable = eos_signal depth = 2
+
+    FX_DATAFLOW;
+    FX_PROCESS(prepare_burst(in, internal_stream, burst_size, items_packed, eos_signal, out_size, idle_cycles));
+    FX_PROCESS(burst_write(internal_stream, burst_size, items_packed, eos_signal, out, items_written, eos));
+}
+
+// Compressing writer: lines are laid out as for WMtoS_codec and decoded on
+// the host with decode_batch.
+template <int W, typename CODEC_T, int BURST_LENGTH = 4096 / (W / 8), typename STREAM_IN>
+void StoWM_codec(
+    STREAM_IN & in,
+    ap_uint<W> * out,
+    int out_size,
+    int * items_written,
+    int * eos
+)
+{
+#pragma HLS DATAFLOW
+    fifo< ap_uint<W> > internal_stream;
+    fifo< ap_uint<8> > burst_size;
+    fifo< ap_uint<16> > items_packed;
+    fifo<bool> eos_signal;
+
+    constexpr int fifo_buf = 2 * BURST_LENGTH;
+
+    #pragma HLS STREAM variable = internal_stream depth = fifo_buf
+    #pragma HLS STREAM variable = burst_size depth = 2
+    #pragma HLS STREAM variable = items_packed depth = 2
+    #pragma HLS STREAM variable = eos_signal depth = 2
+
+    FX_DATAFLOW;
+    FX_PROCESS(prepare_burst_codec<W, CODEC_T, BURST_LENGTH>(in, internal_stream, burst_size, items_packed, eos_signal, out_size));
+    FX_PROCESS(burst_write<W, BURST_LENGTH>(internal_stream, burst_size, items_packed, eos_signal, out, items_written, eos));
+}
+
+// Packed writer: lines are laid out as for WMtoS_packed and unpacked on the
+// host with decode_batch and a packed_codec_t (host/packed_codec.hpp).
+template <int W, int BURST_LENGTH = 4096 / (W / 8), typename STREAM_IN>
+void StoWM_packed(
     STREAM_IN & in,
     ap_uint<W> * out,
     int out_size,
@@ -183,10 +733,10 @@ void StoWM(
 )
 {
 #pragma HLS DATAFLOW
-    hls::stream< ap_uint<W> > internal_stream;
-    hls::stream< ap_uint<8> > burst_size;
-    hls::stream< ap_uint<16> > items_packed;
-    hls::stream<bool> eos_signal;
+    fifo< ap_uint<W> > internal_stream;
+    fifo< ap_uint<8> > burst_size;
+    fifo< ap_uint<16> > items_packed;
+    fifo<bool> eos_signal;
 
     constexpr int fifo_buf = 2 * BURST_LENGTH;
 
@@ -195,8 +745,153 @@ void StoWM(
     #pragma HLS STREAM variable = items_packed depth = 2
     #pragma HLS STREAM variable = eos_signal depth = 2
 
-    prepare_burst(in, internal_stream, burst_size, items_packed, eos_signal, out_size);
-    burst_write(internal_stream, burst_size, items_packed, eos_signal, out, items_written, eos);
+    FX_DATAFLOW;
+    FX_PROCESS(prepare_burst_packed<W, BURST_LENGTH>(in, internal_stream, burst_size, items_packed, eos_signal, out_size));
+    FX_PROCESS(burst_write<W, BURST_LENGTH>(internal_stream, burst_size, items_packed, eos_signal, out, items_written, eos));
+}
+
+// Persistent writer, counterpart of WMtoS_ring: fills the free slots of `ring`
+// with StoWM, publishes count (in items) and eos of each slot and rings the
+// doorbell, waiting for the host whenever all SLOTS are full. A slot is
+// published when it is full or at the end of the stream.
+template <int W, int SLOTS, int BURST_LENGTH = 4096 / (W / 8), typename STREAM_IN>
+void StoWM_ring(
+    STREAM_IN & in,
+    ap_uint<W> * ring,
+    volatile int * ctrl,
+    int slot_lines
+)
+{
+    using RING = ring_ctrl_t<SLOTS>;
+
+    int head = 0;
+    bool last = false;
+
+StoWM_ring:
+    while (!last) {
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+    StoWM_ring_wait:
+        while (head - ctrl[RING::TAIL] == SLOTS) {
+        #pragma HLS LOOP_TRIPCOUNT min = 0 max = 1024
+        }
+
+        const int slot = RING::slot(head);
+        int items_written = 0;
+        int eos = 0;
+        StoWM<W, BURST_LENGTH>(in, ring + slot * slot_lines, slot_lines * (W / 8), &items_written, &eos);
+
+        ctrl[RING::COUNT + slot] = items_written;
+        ctrl[RING::EOS + slot] = eos;
+        head = head + 1;
+        ctrl[RING::HEAD] = head;
+        last = (eos != 0);
+    }
+}
+
+// Writer side of SNtoWM: serves the sources with a complete burst in rotating
+// priority order, writing the lines of source j in its own region of `out`.
+template <int W, int N, int BURST_LENGTH = 4096 / (W / 8)>
+void burst_write_N(
+    fifo< ap_uint<W> > in[N],
+    fifo< ap_uint<8> > burst_size[N],
+    fifo< ap_uint<16> > items_packed[N],
+    fifo<bool> eos_signal[N],
+    ap_uint<W> * out,
+    int region_lines,
+    int * items_written,
+    int * eos
+)
+{
+    HW_STATIC_ASSERT((W >= 8) && (W <= 512) && IS_POW2(W),
+                     "AXI port width W must be power of 2 and between 8 to 512.");
+
+    int lines[N];   // lines written by each source
+    int iw[N];      // items written by each source
+    #pragma HLS array_partition variable=lines type=complete
+    #pragma HLS array_partition variable=iw type=complete
+
+    for (int j = 0; j < N; ++j) {
+    #pragma HLS UNROLL
+        lines[j] = 0;
+        iw[j] = 0;
+    }
+
+    ap_uint<N> done = 0;
+    const ap_uint<N> ends = ~done;  // set all bits to one
+    int id = 0;
+
+burst_write_N:
+    while (done != ends) {
+        ap_uint<N> ready = 0;
+        for (int j = 0; j < N; ++j) {
+        #pragma HLS UNROLL
+            ready[j] = !done[j] && !burst_size[j].empty();
+        }
+
+        int src = 0;
+        if (first_from<N>(ready, id, src)) {
+            const int bs = burst_size[src].read();
+            iw[src] += items_packed[src].read();
+
+            const int base = src * region_lines + lines[src];
+        one_burst:
+            for (int k = 0; k < bs; k++) {
+            #pragma HLS pipeline II = 1
+            #pragma HLS LOOP_TRIPCOUNT min = 1 max = BURST_LENGTH
+                out[base + k] = in[src].read();
+            }
+            lines[src] += bs;
+            done[src] = (bs == 0);
+            id = (src + 1 == N) ? 0 : (src + 1);
+        }
+    }
+
+    for (int j = 0; j < N; ++j) {
+    #pragma HLS UNROLL
+        items_written[j] = iw[j];
+        eos[j] = (eos_signal[j].read() ? 1 : 0);
+    }
+}
+
+// Multi-source writer: N streams share one AXI port. Every source is packed
+// in lines by its own prepare_burst, so up to min(N, W / T_BITS) tuples are
+// stored per cycle, and written in bursts to its own region of out_size / N
+// bytes. items_written[j] and eos[j] report the outcome of source j. Every
+// invocation reads all the sources, so they must end in the same invocation:
+// a source that returned eos has nothing left to read.
+template <int W, int N, int BURST_LENGTH = 4096 / (W / 8), typename STREAM_IN>
+void SNtoWM(
+    STREAM_IN istrms[N],
+    ap_uint<W> * out,
+    int out_size,
+    int * items_written,
+    int * eos
+)
+{
+#pragma HLS DATAFLOW
+    fifo< ap_uint<W> > internal_streams[N];
+    fifo< ap_uint<8> > burst_size[N];
+    fifo< ap_uint<16> > items_packed[N];
+    fifo<bool> eos_signal[N];
+
+    constexpr int fifo_buf = 2 * BURST_LENGTH;
+
+    #pragma HLS STREAM variable = internal_streams depth = fifo_buf
+    #pragma HLS STREAM variable = burst_size depth = 2
+    #pragma HLS STREAM variable = items_packed depth = 2
+    #pragma HLS STREAM variable = eos_signal depth = 2
+
+    const int region_size = out_size / N;
+    const int region_lines = region_size / (W / 8);
+
+    FX_DATAFLOW;
+
+SNtoWM:
+    for (int j = 0; j < N; ++j) {
+    #pragma HLS UNROLL
+        FX_PROCESS_I(j, prepare_burst<W, BURST_LENGTH>(istrms[j], internal_streams[j], burst_size[j], items_packed[j], eos_signal[j], region_size));
+    }
+    FX_PROCESS(burst_write_N<W, N, BURST_LENGTH>(internal_streams, burst_size, items_packed, eos_signal, out, region_lines, items_written, eos));
 }
 
 }
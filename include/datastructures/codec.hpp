@@ -0,0 +1,306 @@
+#ifndef __CODEC_HPP__
+#define __CODEC_HPP__
+
+#include "../common.hpp"
+
+
+namespace fx {
+
+// Lightweight per-field codecs for the memory connectors (WMtoS_codec,
+// StoWM_codec) and the host StreamGenerator/StreamDrainer. Every codec turns a
+// field value into a BITS-wide code and back. A batch starts with its first
+// tuple stored raw, which resets the codecs on both sides (e.g. it is the base
+// of the deltas). `fits` tells whether a value survives the round trip; the
+// kernels do not check it, the host encoder (encode_batch) rejects the
+// batches that do not fit. Plain C++ only: this header is shared by kernels
+// and host.
+
+using code_t = unsigned long long;
+
+template <unsigned int BITS>
+constexpr code_t CODE_MASK()
+{
+    return (BITS >= 64) ? ~code_t(0) : ((code_t(1) << BITS) - 1);
+}
+
+
+// Field stored as is, optionally truncated to BITS bits.
+template <typename V, unsigned int BITS_ = sizeof(V) * 8>
+struct raw_codec_t
+{
+    static constexpr unsigned int BITS = BITS_;
+    using VALUE_T = V;
+
+    void reset(const V) {}
+
+    bool fits(const V value) const
+    {
+        return V(code_t(value) & CODE_MASK<BITS>()) == value;
+    }
+
+    code_t encode(const V value)
+    {
+    #pragma HLS INLINE
+        return code_t(value) & CODE_MASK<BITS>();
+    }
+
+    V decode(const code_t code)
+    {
+    #pragma HLS INLINE
+        return V(code);
+    }
+};
+
+
+// Difference from the previous value of the batch, for non-decreasing fields
+// (e.g. timestamps). Gaps must fit in BITS bits.
+template <typename V, unsigned int BITS_>
+struct delta_codec_t
+{
+    static constexpr unsigned int BITS = BITS_;
+    using VALUE_T = V;
+
+    V prev;
+
+    delta_codec_t()
+    : prev(0)
+    {}
+
+    void reset(const V first)
+    {
+    #pragma HLS INLINE
+        prev = first;
+    }
+
+    bool fits(const V value) const
+    {
+        return V(prev + V(code_t(value - prev) & CODE_MASK<BITS>())) == value;
+    }
+
+    code_t encode(const V value)
+    {
+    #pragma HLS INLINE
+        const code_t code = code_t(value - prev) & CODE_MASK<BITS>();
+        prev = value;
+        return code;
+    }
+
+    V decode(const code_t code)
+    {
+    #pragma HLS INLINE
+        prev = V(prev + V(code));
+        return prev;
+    }
+};
+
+
+// Frame of reference: offset from BASE, for fields in [BASE, BASE + 2^BITS)
+// (e.g. small-range keys).
+template <typename V, unsigned int BITS_, V BASE = 0>
+struct for_codec_t
+{
+    static constexpr unsigned int BITS = BITS_;
+    using VALUE_T = V;
+
+    void reset(const V) {}
+
+    bool fits(const V value) const
+    {
+        return V(BASE + V(code_t(value - BASE) & CODE_MASK<BITS>())) == value;
+    }
+
+    code_t encode(const V value)
+    {
+    #pragma HLS INLINE
+        return code_t(value - BASE) & CODE_MASK<BITS>();
+    }
+
+    V decode(const code_t code)
+    {
+    #pragma HLS INLINE
+        return V(BASE + V(code));
+    }
+};
+
+
+// Dictionary of the VALUES a low-cardinality field can take: the code is the
+// index of the value. Values outside the dictionary are encoded as index 0
+// by the kernels and rejected by encode_batch.
+template <typename V, V... VALUES>
+struct dict_codec_t
+{
+    static constexpr unsigned int SIZE = sizeof...(VALUES);
+    static constexpr unsigned int BITS = MAX_VAL(LOG2_CEIL(SIZE), 1u);
+    using VALUE_T = V;
+
+    HW_STATIC_ASSERT(SIZE > 0, "FX: dict_codec_t needs at least one value");
+
+    void reset(const V) {}
+
+    bool fits(const V value) const
+    {
+        const V values[SIZE] = {VALUES...};
+        for (unsigned int i = 0; i < SIZE; ++i) {
+            if (values[i] == value) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    code_t encode(const V value)
+    {
+    #pragma HLS INLINE
+        const V values[SIZE] = {VALUES...};
+        code_t code = 0;
+        DICT_CODEC_ENCODE:
+        for (unsigned int i = 0; i < SIZE; ++i) {
+        #pragma HLS UNROLL
+            if (values[i] == value) {
+                code = i;
+            }
+        }
+        return code;
+    }
+
+    V decode(const code_t code)
+    {
+    #pragma HLS INLINE
+        const V values[SIZE] = {VALUES...};
+        return (code < SIZE) ? values[code] : values[0];
+    }
+};
+
+
+// Binds a codec to a member of the tuple, e.g.
+// field_codec_t<&tuple_t::timestamp, delta_codec_t<unsigned int, 12>>
+template <auto MEMBER, typename CODEC_T>
+struct field_codec_t : CODEC_T
+{
+    template <typename T>
+    void reset_field(const T & first)
+    {
+    #pragma HLS INLINE
+        CODEC_T::reset(first.*MEMBER);
+    }
+
+    template <typename T>
+    bool fits_field(const T & t) const
+    {
+        return CODEC_T::fits(t.*MEMBER);
+    }
+
+    template <typename T>
+    code_t encode_field(const T & t)
+    {
+    #pragma HLS INLINE
+        return CODEC_T::encode(t.*MEMBER);
+    }
+
+    template <typename T>
+    void decode_field(T & t, const code_t code)
+    {
+    #pragma HLS INLINE
+        t.*MEMBER = CODEC_T::decode(code);
+    }
+};
+
+
+template <typename T, typename... FIELDS_T>
+struct _record_fields
+{
+    void reset(const T &) {}
+    bool fits(const T &) const { return true; }
+    void encode(const T &, code_t *) {}
+    void decode(T &, const code_t *) {}
+};
+
+template <typename T, typename FIELD_T, typename... REST_T>
+struct _record_fields<T, FIELD_T, REST_T...>
+{
+    FIELD_T head;
+    _record_fields<T, REST_T...> tail;
+
+    void reset(const T & first)
+    {
+    #pragma HLS INLINE
+        head.reset_field(first);
+        tail.reset(first);
+    }
+
+    bool fits(const T & t) const
+    {
+        return head.fits_field(t) && tail.fits(t);
+    }
+
+    void encode(const T & t, code_t * codes)
+    {
+    #pragma HLS INLINE
+        codes[0] = head.encode_field(t);
+        tail.encode(t, codes + 1);
+    }
+
+    void decode(T & t, const code_t * codes)
+    {
+    #pragma HLS INLINE
+        head.decode_field(t, codes[0]);
+        tail.decode(t, codes + 1);
+    }
+};
+
+// Codec of a whole tuple: the codes of FIELDS_T are concatenated, the first
+// field in the least significant bits, into a record of BITS bits. Members
+// without a codec are not transferred and decode default-initialized.
+template <typename T, typename... FIELDS_T>
+struct record_codec_t
+{
+    using data_t = T;
+
+    static constexpr unsigned int FIELDS = sizeof...(FIELDS_T);
+    static constexpr unsigned int BITS = (FIELDS_T::BITS + ...);
+
+    HW_STATIC_ASSERT(FIELDS > 0, "FX: record_codec_t needs at least one field");
+
+    static constexpr unsigned int width(const unsigned int f)
+    {
+        constexpr unsigned int widths[FIELDS] = {FIELDS_T::BITS...};
+        return widths[f];
+    }
+
+    static constexpr unsigned int offset(const unsigned int f)
+    {
+        return (f == 0) ? 0 : offset(f - 1) + width(f - 1);
+    }
+
+    _record_fields<T, FIELDS_T...> fields;
+
+    void reset(const T & first)
+    {
+    #pragma HLS INLINE
+        fields.reset(first);
+    }
+
+    // true if every field of t is decoded back as is
+    bool fits(const T & t) const
+    {
+        return fields.fits(t);
+    }
+
+    void encode(const T & t, code_t codes[FIELDS])
+    {
+    #pragma HLS INLINE
+        fields.encode(t, codes);
+    }
+
+    T decode(const code_t codes[FIELDS])
+    {
+    #pragma HLS INLINE
+        T t = T();
+        fields.decode(t, codes);
+        return t;
+    }
+};
+
+}
+
+#endif // __CODEC_HPP__
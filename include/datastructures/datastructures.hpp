@@ -2,5 +2,10 @@
 #define __DATASTRUCTURES_HPP__
 
 #include "typehandler.hpp"
+#include "distributions.hpp"
+#include "sketch.hpp"
+#include "hash.hpp"
+#include "codec.hpp"
+#include "ring.hpp"
 
 #endif // __DATASTRUCTURES_HPP__
\ No newline at end of file
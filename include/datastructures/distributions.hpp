@@ -0,0 +1,148 @@
+#ifndef __DISTRIBUTIONS_HPP__
+#define __DISTRIBUTIONS_HPP__
+
+#include "hls_math.h"
+#include "../common.hpp"
+
+
+namespace fx {
+
+// Marsaglia's xorshift32: one 32-bit value per cycle, no multipliers.
+struct xorshift32_t
+{
+    using VALUE_T = unsigned int;
+
+    VALUE_T state;
+
+    constexpr xorshift32_t(const VALUE_T seed = 1)
+    : state(seed == 0 ? VALUE_T(0x9E3779B9) : seed)
+    {}
+
+    constexpr VALUE_T next()
+    {
+    #pragma HLS INLINE
+        VALUE_T x = state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state = x;
+        return x;
+    }
+
+    // uniform value in [0, n) using a multiply-shift instead of a modulo
+    VALUE_T next_below(const VALUE_T n)
+    {
+    #pragma HLS INLINE
+        return VALUE_T((static_cast<unsigned long long>(next()) * n) >> 32);
+    }
+};
+
+
+template <unsigned int KEYS>
+struct uniform_keys_t
+{
+    using KEY_T = unsigned int;
+
+    xorshift32_t rng;
+
+    uniform_keys_t(const unsigned int seed = 1)
+    : rng(seed)
+    {}
+
+    KEY_T next()
+    {
+    #pragma HLS INLINE
+        return rng.next_below(KEYS);
+    }
+};
+
+
+// Zipf(s) over KEYS keys: key k is drawn with probability proportional to
+// 1 / (k + 1)^s. The CDF is computed once at construction and sampled with
+// a binary search; every level of the search reads its own copy of the CDF
+// so that a key is produced every cycle.
+template <unsigned int KEYS>
+struct zipf_keys_t
+{
+    HW_STATIC_ASSERT(IS_POW2(KEYS), "FX: zipf_keys_t KEYS must be a power of 2");
+
+    static constexpr unsigned int LEVELS = MAX_VAL(LOG2_CEIL(KEYS), 1u);
+
+    using KEY_T = unsigned int;
+    using CDF_T = unsigned int;
+
+    xorshift32_t rng;
+    CDF_T cdf[LEVELS][KEYS];
+
+    zipf_keys_t(const float s, const unsigned int seed = 1)
+    : rng(seed)
+    {
+        #pragma HLS array_partition variable=cdf type=complete dim=1
+
+        float norm = 0.0f;
+        ZIPF_NORM:
+        for (KEY_T k = 0; k < KEYS; ++k) {
+            norm += 1.0f / hls::pow(float(k + 1), s);
+        }
+
+        float acc = 0.0f;
+        ZIPF_CDF:
+        for (KEY_T k = 0; k < KEYS; ++k) {
+            acc += 1.0f / hls::pow(float(k + 1), s);
+            const double p = double(acc / norm);
+            const CDF_T value = (k + 1 == KEYS || p >= 1.0) ? CDF_T(-1) : CDF_T(p * 4294967295.0);
+            for (unsigned int l = 0; l < LEVELS; ++l) {
+            #pragma HLS UNROLL
+                cdf[l][k] = value;
+            }
+        }
+    }
+
+    KEY_T next()
+    {
+    #pragma HLS INLINE
+        const CDF_T u = rng.next();
+
+        // smallest k such that cdf[k] > u
+        KEY_T pos = 0;
+        ZIPF_SEARCH:
+        for (unsigned int l = 0; l < LEVELS; ++l) {
+        #pragma HLS UNROLL
+            const KEY_T step = KEYS >> (l + 1);
+            if (step > 0 && cdf[l][pos + step - 1] <= u) {
+                pos += step;
+            }
+        }
+        return pos;
+    }
+};
+
+
+// Moves timestamps back by at most DISORDER time units, producing a stream
+// whose out-of-orderness is bounded by DISORDER (i.e. a LATENESS of DISORDER
+// is enough to never drop a tuple).
+template <unsigned int DISORDER>
+struct bounded_jitter_t
+{
+    using TIME_T = unsigned int;
+
+    xorshift32_t rng;
+
+    bounded_jitter_t(const unsigned int seed = 1)
+    : rng(seed ^ 0x5BD1E995)
+    {}
+
+    TIME_T next(const TIME_T timestamp)
+    {
+    #pragma HLS INLINE
+        if (DISORDER == 0) {
+            return timestamp;
+        }
+        const TIME_T jitter = rng.next_below(DISORDER + 1);
+        return (timestamp > jitter) ? (timestamp - jitter) : TIME_T(0);
+    }
+};
+
+}
+
+#endif // __DISTRIBUTIONS_HPP__
@@ -0,0 +1,132 @@
+#ifndef __HASH_HPP__
+#define __HASH_HPP__
+
+#include "ap_int.h"
+#include "../common.hpp"
+#include "distributions.hpp"
+
+
+namespace fx {
+
+// Hash functions for the key-by connectors. Every hash maps a 32-bit key to
+// a replica in [0, N) with `index<N>(key)` at II=1: the 32-bit hash value is
+// scaled to the range with a multiply-shift, which is a plain shift when N is a
+// power of 2 and a constant multiplication otherwise, never a divider.
+
+template <unsigned int N>
+unsigned int hash_to_range(const unsigned int h)
+{
+#pragma HLS INLINE
+    return (unsigned int)((static_cast<unsigned long long>(h) * N) >> 32);
+}
+
+
+// Plain modulo on the key (the historical key-by behaviour). Only suitable for
+// keys without structure and, if N is not a power of 2, costs a modulo.
+struct modulo_hash_t
+{
+    template <unsigned int N>
+    unsigned int index(const unsigned int key) const
+    {
+    #pragma HLS INLINE
+        return key % N;
+    }
+};
+
+
+// Knuth's multiplicative hash: one multiplication, high bits are used.
+struct multiply_shift_hash_t
+{
+    static constexpr unsigned int A = 0x9E3779B1;
+
+    unsigned int operator()(const unsigned int key) const
+    {
+    #pragma HLS INLINE
+        return key * A;
+    }
+
+    template <unsigned int N>
+    unsigned int index(const unsigned int key) const
+    {
+    #pragma HLS INLINE
+        return hash_to_range<N>((*this)(key));
+    }
+};
+
+
+// CRC-32C (Castagnoli) of the 4 key bytes: the fully unrolled loop is a
+// network of XOR gates, no multipliers nor memories.
+struct crc32_hash_t
+{
+    static constexpr unsigned int POLY = 0x82F63B78;
+
+    unsigned int operator()(const unsigned int key) const
+    {
+    #pragma HLS INLINE
+        unsigned int crc = 0xFFFFFFFF ^ key;
+        for (int i = 0; i < 32; ++i) {
+        #pragma HLS UNROLL
+            crc = (crc >> 1) ^ ((crc & 1) ? POLY : 0u);
+        }
+        return ~crc;
+    }
+
+    template <unsigned int N>
+    unsigned int index(const unsigned int key) const
+    {
+    #pragma HLS INLINE
+        return hash_to_range<N>((*this)(key));
+    }
+};
+
+
+// Simple tabulation hashing: one random table per key byte, XOR of the four
+// entries. The tables are filled from SEED at compile time and are read-only,
+// so they are mapped to ROMs instead of being initialized at every call.
+struct tabulation_table_t
+{
+    unsigned int entries[4][256];
+};
+
+constexpr tabulation_table_t make_tabulation_table(const unsigned int seed)
+{
+    tabulation_table_t table = {};
+    xorshift32_t rng(seed);
+    for (int i = 0; i < 256; ++i) {
+        for (int b = 0; b < 4; ++b) {
+            table.entries[b][i] = rng.next();
+        }
+    }
+    return table;
+}
+
+template <unsigned int SEED>
+struct seeded_tabulation_hash_t
+{
+    static constexpr tabulation_table_t table = make_tabulation_table(SEED);
+
+    unsigned int operator()(const unsigned int key) const
+    {
+    #pragma HLS INLINE
+        return table.entries[0][(key >>  0) & 0xFF]
+             ^ table.entries[1][(key >>  8) & 0xFF]
+             ^ table.entries[2][(key >> 16) & 0xFF]
+             ^ table.entries[3][(key >> 24) & 0xFF];
+    }
+
+    template <unsigned int N>
+    unsigned int index(const unsigned int key) const
+    {
+    #pragma HLS INLINE
+        return hash_to_range<N>((*this)(key));
+    }
+};
+
+template <unsigned int SEED>
+constexpr tabulation_table_t seeded_tabulation_hash_t<SEED>::table;
+
+using tabulation_hash_t = seeded_tabulation_hash_t<0x2545F491>;
+
+}
+
+#endif // __HASH_HPP__
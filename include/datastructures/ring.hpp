@@ -0,0 +1,34 @@
+#ifndef __RING_HPP__
+#define __RING_HPP__
+
+#include "../common.hpp"
+
+
+namespace fx {
+
+// Control block of a ring of SLOTS batches shared by a persistent memory
+// kernel (WMtoS_ring, StoWM_ring) and the host: an array of WORDS ints.
+// The producer fills slot `head % SLOTS`, stores its count and eos flag and
+// then bumps HEAD (the doorbell); the consumer waits for HEAD != TAIL, drains
+// slot `tail % SLOTS` and bumps TAIL to give it back. Indices only grow: the
+// ring is empty when HEAD == TAIL and full when HEAD - TAIL == SLOTS.
+template <int SLOTS>
+struct ring_ctrl_t
+{
+    HW_STATIC_ASSERT(IS_POW2(SLOTS), "FX: ring_ctrl_t SLOTS must be a power of 2");
+
+    static constexpr int HEAD = 0;              // producer index
+    static constexpr int TAIL = 1;              // consumer index
+    static constexpr int COUNT = 2;             // COUNT + s: count of slot s
+    static constexpr int EOS = COUNT + SLOTS;   // EOS + s: slot s is the last one
+    static constexpr int WORDS = EOS + SLOTS;
+
+    static constexpr int slot(const int index)
+    {
+        return index & (SLOTS - 1);
+    }
+};
+
+}
+
+#endif // __RING_HPP__
@@ -0,0 +1,103 @@
+#ifndef __SKETCH_HPP__
+#define __SKETCH_HPP__
+
+#include "ap_int.h"
+#include "../common.hpp"
+
+
+namespace fx {
+
+// Space-Saving heavy-hitters sketch (Metwally et al.) on SLOTS registers.
+// `update` returns the estimated frequency of the key, which overestimates the
+// real one by at most total / SLOTS. Counters are halved every 2^AGING_LOG
+// updates so that the sketch follows changes in the key distribution.
+template <
+    typename KEY_T,
+    unsigned int SLOTS,
+    unsigned int AGING_LOG = 12
+>
+struct space_saving_t
+{
+    using COUNT_T = unsigned int;
+    using IDX_T   = unsigned int;
+    using MASK_T  = ap_uint<SLOTS>;
+
+    static constexpr COUNT_T AGING_PERIOD = COUNT_T(1) << AGING_LOG;
+
+    KEY_T keys[SLOTS];
+    COUNT_T counts[SLOTS];
+    MASK_T valid;
+    COUNT_T total;
+
+    space_saving_t()
+    : valid(0)
+    , total(0)
+    {
+        #pragma HLS array_partition variable=keys   type=complete
+        #pragma HLS array_partition variable=counts type=complete
+
+        SPACE_SAVING_INIT:
+        for (IDX_T i = 0; i < SLOTS; ++i) {
+        #pragma HLS UNROLL
+            counts[i] = 0;
+        }
+    }
+
+    COUNT_T update(const KEY_T key)
+    {
+    #pragma HLS INLINE
+        bool hit = false;
+        IDX_T hit_idx = 0;
+        IDX_T min_idx = 0;
+        COUNT_T min_count = COUNT_T(-1);
+
+        SPACE_SAVING_FIND:
+        for (IDX_T i = 0; i < SLOTS; ++i) {
+        #pragma HLS UNROLL
+            const COUNT_T count = valid[i] ? counts[i] : COUNT_T(0);
+            if (valid[i] && keys[i] == key) {
+                hit = true;
+                hit_idx = i;
+            }
+            if (count < min_count) {
+                min_count = count;
+                min_idx = i;
+            }
+        }
+
+        // on a miss the key takes over the least frequent slot
+        const IDX_T idx = hit ? hit_idx : min_idx;
+        const COUNT_T count = (hit ? counts[idx] : min_count) + 1;
+        keys[idx] = key;
+        counts[idx] = count;
+        valid[idx] = 1;
+
+        // the count returned is aged with the others, is_hot compares it
+        // against the halved total
+        total = total + 1;
+        const bool aging = (total == AGING_PERIOD);
+        if (aging) {
+            total = total >> 1;
+            SPACE_SAVING_AGING:
+            for (IDX_T i = 0; i < SLOTS; ++i) {
+            #pragma HLS UNROLL
+                counts[i] = counts[i] >> 1;
+            }
+        }
+
+        return aging ? COUNT_T(count >> 1) : count;
+    }
+
+    // true when the key accounts for at least 1 / 2^HOT_SHIFT of the recent
+    // traffic; no key is hot before half an aging period has been observed
+    template <unsigned int HOT_SHIFT>
+    bool is_hot(const COUNT_T count) const
+    {
+    #pragma HLS INLINE
+        return (total >= (AGING_PERIOD >> 1)) && ((count << HOT_SHIFT) >= total);
+    }
+};
+
+}
+
+#endif // __SKETCH_HPP__
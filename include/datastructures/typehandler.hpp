@@ -3,6 +3,7 @@
 
 #pragma GCC system_header
 #include <ap_int.h>
+#include <type_traits>
 
 // Code taken from hlslib:
 // https://github.com/definelicht/hlslib/blob/master/include/hlslib/xilinx/DataPack.h#L27
@@ -20,4 +21,95 @@ struct TypeHandler {
     }
 };
 
+
+// Packed serialization: a tuple is the concatenation of the fields listed in
+// a PackedTypeHandler, first field in the least significant bits, each on the
+// bits it needs instead of the sizeof(T) * 8 bits of its memory image.
+// Opt in by specializing TypeHandler for the tuple, e.g.
+//
+//   template <>
+//   struct TypeHandler<tuple_t>
+//   : PackedTypeHandler<tuple_t, PackedField<&tuple_t::key, 20>,
+//                                PackedField<&tuple_t::timestamp, 24>> {};
+//
+// Members not listed are not transferred and unpack default-initialized.
+// Fields are (un)packed by their own TypeHandler, so nested tuples work too.
+
+template <typename C, typename V>
+V _packed_member_type(V C::*);
+
+template <auto MEMBER, int BITS_ = TypeHandler<decltype(_packed_member_type(MEMBER))>::WIDTH>
+struct PackedField {
+    using value_t = decltype(_packed_member_type(MEMBER));
+
+    static constexpr int BITS = BITS_;
+    static constexpr int WIDTH = TypeHandler<value_t>::WIDTH;
+
+    static_assert((BITS > 0) && (BITS <= WIDTH),
+                  "PackedField: BITS must be in [1, TypeHandler<value_t>::WIDTH]");
+    static_assert((BITS == WIDTH) || std::is_integral<value_t>::value,
+                  "PackedField: only integral fields can be truncated");
+
+    template <typename T>
+    static ap_uint<BITS> pack(T const & t) {
+        ap_uint<WIDTH> value = TypeHandler<value_t>::to_ap(t.*MEMBER);
+        return value.range(BITS - 1, 0);
+    }
+
+    template <typename T>
+    static void unpack(T & t, ap_uint<BITS> const & bits) {
+        if constexpr (std::is_signed<value_t>::value && (BITS < WIDTH)) {
+            // sign extension of truncated signed integers
+            const long long value = (long long)(bits.to_uint64() << (64 - BITS)) >> (64 - BITS);
+            t.*MEMBER = value_t(value);
+        } else {
+            t.*MEMBER = TypeHandler<value_t>::from_ap(ap_uint<WIDTH>(bits));
+        }
+    }
+};
+
+template <typename T, int OFFSET, typename... FIELDS_T>
+struct _PackedFields {
+    template <int W>
+    static void pack(T const &, ap_uint<W> &) {}
+
+    template <int W>
+    static void unpack(T &, ap_uint<W> const &) {}
+};
+
+template <typename T, int OFFSET, typename FIELD_T, typename... REST_T>
+struct _PackedFields<T, OFFSET, FIELD_T, REST_T...> {
+    using next_t = _PackedFields<T, OFFSET + FIELD_T::BITS, REST_T...>;
+
+    template <int W>
+    static void pack(T const & t, ap_uint<W> & ap) {
+        ap.range(OFFSET + FIELD_T::BITS - 1, OFFSET) = FIELD_T::pack(t);
+        next_t::pack(t, ap);
+    }
+
+    template <int W>
+    static void unpack(T & t, ap_uint<W> const & ap) {
+        ap_uint<FIELD_T::BITS> bits = ap.range(OFFSET + FIELD_T::BITS - 1, OFFSET);
+        FIELD_T::unpack(t, bits);
+        next_t::unpack(t, ap);
+    }
+};
+
+template <typename T, typename... FIELDS_T>
+struct PackedTypeHandler {
+    static constexpr int WIDTH = (FIELDS_T::BITS + ...);
+
+    static T from_ap(ap_uint<WIDTH> const & ap) {
+        T value = T();
+        _PackedFields<T, 0, FIELDS_T...>::unpack(value, ap);
+        return value;
+    }
+
+    static ap_uint<WIDTH> to_ap(T const & value) {
+        ap_uint<WIDTH> ap = 0;
+        _PackedFields<T, 0, FIELDS_T...>::pack(value, ap);
+        return ap;
+    }
+};
+
 #endif // __TYPEHANDLER_HPP__
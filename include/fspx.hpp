@@ -6,6 +6,7 @@
 #include "datastructures/typehandler.hpp"
 #include "datastructures/bucket.hpp"
 #include "datastructures/aggregate_operators.hpp"
+#include "datastructures/distributions.hpp"
 // #include "datastructures/tumbling_window.hpp"
 // #include "datastructures/sliding_window.hpp"
 #include "connectors/connectors.hpp"
@@ -3,9 +3,21 @@
 
 #include "common.hpp"
 #include "host/utils.hpp"
+#ifdef FX_CPU_BACKEND
+#include "host/cpu/ocl.hpp"
+#include "host/cpu/stream_generator.hpp"
+#include "host/cpu/stream_drainer.hpp"
+#else
 #include "host/ocl.hpp"
 #include "host/stream_generator.hpp"
 #include "host/stream_drainer.hpp"
+#endif
+#include "host/async_drainer.hpp"
+#include "host/replica_orchestrator.hpp"
+#include "host/latency_tracker.hpp"
+#include "host/codec.hpp"
+#include "host/ring.hpp"
+#include "host/metric/histogram.hpp"
 #include "host/metric/metric.hpp"
 #include "host/metric/sampler.hpp"
 #include "host/metric/metric_group.hpp"
@@ -0,0 +1,85 @@
+#ifndef __HOST_AFFINITY__
+#define __HOST_AFFINITY__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+
+namespace fx {
+
+// NUMA node of the first Xilinx card (PCI vendor 0x10ee) found in sysfs, -1
+// if none or if the platform is not NUMA
+inline int card_numa_node()
+{
+    const std::string root = "/sys/bus/pci/devices/";
+    DIR * dir = opendir(root.c_str());
+    if (dir == nullptr) return -1;
+
+    int node = -1;
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') continue;
+
+        const std::string device = root + entry->d_name;
+        std::string vendor;
+        std::ifstream(device + "/vendor") >> vendor;
+        if (vendor != "0x10ee") continue;
+
+        std::ifstream(device + "/numa_node") >> node;
+        break;
+    }
+    closedir(dir);
+
+    return node;
+}
+
+// CPUs of a NUMA node (sysfs cpulist, e.g. "0-7,16-23"), all the online CPUs
+// if node is -1 or unknown
+inline std::vector<int> numa_node_cpus(const int node)
+{
+    std::vector<int> cpus;
+
+    std::string list;
+    if (node >= 0) {
+        std::ifstream("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist") >> list;
+    }
+
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        const size_t dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+        for (int c = first; c <= last; ++c) {
+            cpus.push_back(c);
+        }
+    }
+
+    if (cpus.empty()) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int c = 0; c < online; ++c) {
+            cpus.push_back(c);
+        }
+    }
+
+    return cpus;
+}
+
+// pins the calling thread to `cpu`, false if not allowed
+inline bool pin_current_thread(const int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+}
+
+#endif // __HOST_AFFINITY__
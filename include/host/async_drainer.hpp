@@ -0,0 +1,234 @@
+#ifndef __HOST_ASYNC_DRAINER__
+#define __HOST_ASYNC_DRAINER__
+
+#include <functional>
+#include <future>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+
+#include "defines.hpp"
+#include "worker_pool.hpp"
+#ifdef FX_CPU_BACKEND
+#include "cpu/stream_drainer.hpp"
+#else
+#include "stream_drainer.hpp"
+#endif
+
+
+namespace fx {
+
+// Callback-driven counterpart of StreamDrainer. Every execution notifies its
+// completion (clSetEventCallback on the migrate event, a task of the command
+// queue on the CPU backend) and the batch is handed to `handler` on a pool of
+// workers; the execution is launched again as soon as the handler returns, so
+// the post-processing of a batch overlaps the transfers of the next ones.
+//
+//     fx::AsyncStreamDrainer<T> drainer(ocl, batch_size,
+//         [&](const T * batch, size_t items, bool last, size_t seq) { ... });
+//     std::future<void> end = drainer.start();
+//     ...
+//     end.wait();
+//
+// `seq` is the position of the batch in the stream: with more than one worker
+// the handlers run concurrently and may return out of order. The batch is
+// valid only during the call. The first execution that reads the end of the
+// stream stops the launches and is handed over flagged `last`, once every
+// batch before it has completed, whatever the order of the completions; the
+// executions launched after it return without being handed over.
+template <typename T, typename CODEC_T = void>
+struct AsyncStreamDrainer
+{
+    using Drainer = StreamDrainer<T, CODEC_T>;
+    using Execution = typename Drainer::Execution;
+    using Handler = std::function<void(const T * batch, size_t items_written, bool last, size_t seq)>;
+
+    Drainer drainer;
+    Handler handler;
+
+    std::mutex launch_mutex;    // serializes the launches, seq is their order
+    size_t next_seq;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t in_flight;           // executions launched and not completed
+    size_t handling;            // completed executions queued to or in the workers
+    bool started;
+    bool stopped;               // an execution has read the end of the stream
+    bool ended;                 // the batch flagged last and every handler before it have returned
+    std::promise<void> end;
+
+    size_t next_completed;      // every seq below has completed
+    std::set<size_t> completed_seqs;                // completed seqs above next_completed
+    std::map<size_t, Execution *> eos_executions;   // completed with eos, waiting for the seqs before them
+    size_t last_seq;            // seq of the batch flagged last, once known
+
+    WorkerPool workers;
+
+    AsyncStreamDrainer(
+        OCL & ocl,
+        const size_t batch_size,
+        Handler handler,
+        const size_t N = 4,
+        const size_t replica_id = 0,
+        const size_t num_workers = 1
+    )
+    : drainer(ocl, batch_size, N, replica_id)
+    , handler(std::move(handler))
+    , next_seq(0)
+    , in_flight(0)
+    , handling(0)
+    , started(false)
+    , stopped(false)
+    , ended(false)
+    , end()
+    , next_completed(0)
+    , completed_seqs()
+    , eos_executions()
+    , last_seq(std::numeric_limits<size_t>::max())
+    , workers(num_workers)
+    {}
+
+    AsyncStreamDrainer(const AsyncStreamDrainer &) = delete;
+    AsyncStreamDrainer & operator=(const AsyncStreamDrainer &) = delete;
+
+    // launches the N executions, the future is ready when the batch flagged
+    // last has been handled
+    std::future<void> start()
+    {
+        std::deque<Execution *> executions;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (started) {
+                std::cerr << "fx::AsyncStreamDrainer: already started" << '\n';
+                return std::future<void>();
+            }
+            started = true;
+            executions.swap(drainer.ready_queue);
+            in_flight = executions.size();
+        }
+
+        std::future<void> ended_future = end.get_future();
+        for (Execution * execution : executions) {
+            launch(execution);
+        }
+        return ended_future;
+    }
+
+    void launch(Execution * execution)
+    {
+        std::lock_guard<std::mutex> lock(launch_mutex);
+        const size_t seq = next_seq++;
+        execution->execute(drainer.max_batch_size);
+        execution->notify([this, execution, seq]() { completed(execution, seq); });
+    }
+
+    // called by the runtime, in the order of completion of the executions;
+    // only the bookkeeping is done here, the rest is left to the workers
+    void completed(Execution * execution, const size_t seq)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        in_flight--;
+
+        completed_seqs.insert(seq);
+        while (!completed_seqs.empty() && *completed_seqs.begin() == next_completed) {
+            completed_seqs.erase(completed_seqs.begin());
+            next_completed++;
+        }
+
+        if (seq > last_seq) {
+            // launched after the end of the stream
+            submit(execution, seq, false, false);
+        } else if (drainer.last(execution)) {
+            // the first batch with eos is the last one, which is known once
+            // every batch before it has completed
+            stopped = true;
+            eos_executions[seq] = execution;
+        } else {
+            submit(execution, seq, true, false);
+        }
+
+        if (last_seq == std::numeric_limits<size_t>::max() && !eos_executions.empty()
+            && eos_executions.begin()->first < next_completed) {
+            last_seq = eos_executions.begin()->first;
+            for (const auto & e : eos_executions) {
+                const bool last = (e.first == last_seq);
+                submit(e.second, e.first, last, last);
+            }
+            eos_executions.clear();
+        }
+    }
+
+    // the lock on mutex must be held
+    void submit(Execution * execution, const size_t seq, const bool deliver, const bool last)
+    {
+        handling++;
+        workers.submit([this, execution, seq, deliver, last]() {
+            handle(execution, seq, deliver, last);
+        });
+    }
+
+    void handle(
+        Execution * execution,
+        const size_t seq,
+        const bool deliver,
+        const bool last
+    )
+    {
+        execution->wait();
+
+        if (deliver) {
+            const size_t items_written = execution->items_written_h[0];
+            execution->decode(items_written);
+            if (drainer.latency) {
+                drainer.latency(execution->batch_h, items_written);
+            }
+            handler(execution->batch_h, items_written, last, seq);
+        }
+
+        bool relaunch = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            handling--;
+            if (stopped) {
+                drainer.ready_queue.push_back(execution);
+                if (handling == 0 && last_seq != std::numeric_limits<size_t>::max() && !ended) {
+                    ended = true;
+                    end.set_value();
+                }
+            } else {
+                in_flight++;
+                relaunch = true;
+            }
+            cv.notify_all();
+        }
+
+        if (relaunch) {
+            launch(execution);
+        }
+    }
+
+    // waits for the batch flagged last and for every handler
+    void finish()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!started) return;
+        cv.wait(lock, [this]() { return ended; });
+    }
+
+    ~AsyncStreamDrainer()
+    {
+        // as StreamDrainer, waits for the executions launched before the end
+        // of the stream
+        std::unique_lock<std::mutex> lock(mutex);
+        if (started) {
+            cv.wait(lock, [this]() { return ended && in_flight == 0 && handling == 0; });
+        }
+    }
+};
+
+}
+
+#endif // __HOST_ASYNC_DRAINER__
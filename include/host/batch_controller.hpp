@@ -0,0 +1,184 @@
+#ifndef __HOST_BATCH_CONTROLLER__
+#define __HOST_BATCH_CONTROLLER__
+
+#include <cstdint>
+#include <string>
+#include <algorithm>
+
+#include "utils.hpp"
+#include "metric/sampler.hpp"
+#include "metric/metric_group.hpp"
+
+
+namespace fx {
+
+// Effective batch size of a StreamGenerator or StreamDrainer, chosen within
+// the allocated buffers from the arrival rate, the latency SLO and the cost of
+// a batch. The cost is modelled as overhead + per_item * batch_size and fitted
+// (exponentially weighted least squares) on the device time of the completed
+// batches: the duration of their migrate events. Neither the run time of the
+// kernels nor their wait between submission and start is counted, both grow
+// when the kernels wait on their streams or on the previous invocation,
+// i.e. with backpressure rather than with the cost of the batch. The batch
+// size is the largest one the SLO allows, but never smaller than the one the
+// device needs to sustain the arrival rate (with some headroom):
+//
+//     latency(b)    = b / rate + overhead + per_item * b <= latency_slo
+//     throughput(b) = b / (overhead + per_item * b)      >= rate * headroom
+//
+// If the two bounds cross the SLO is not attainable and throughput wins. The
+// decisions are sampled and published to a MetricGroup. A controller is
+// attached to a single generator or drainer, it is not thread-safe.
+struct BatchController
+{
+    double latency_slo;         // ns
+    double smoothing;           // weight of the last observation
+    double headroom;
+    size_t min_batch_size;
+    size_t max_batch_size;      // set by attach
+    size_t granule;             // set by attach
+
+    // arrival rate
+    uint64_t last_arrival;
+    double rate;                // items / ns
+
+    // weighted sums of the fit of the batch cost
+    double s0, sb, sbb, st, sbt;
+    double overhead;            // ns
+    double per_item;            // ns
+
+    size_t batch_size_;
+
+    Sampler batch_size_samples;
+    Sampler rate_samples;
+    Sampler overhead_samples;
+    Sampler per_item_samples;
+
+    BatchController(
+        const double latency_slo_ns,
+        const size_t min_batch_size = 1,
+        const double smoothing = 0.1,
+        const double headroom = 1.2,
+        const uint64_t samples_per_second = 10
+    )
+    : latency_slo(latency_slo_ns)
+    , smoothing(smoothing)
+    , headroom(headroom)
+    , min_batch_size(min_batch_size)
+    , max_batch_size(0)
+    , granule(1)
+    , last_arrival(0)
+    , rate(0.0)
+    , s0(0.0), sb(0.0), sbb(0.0), st(0.0), sbt(0.0)
+    , overhead(0.0)
+    , per_item(0.0)
+    , batch_size_(0)
+    , batch_size_samples(samples_per_second)
+    , rate_samples(samples_per_second)
+    , overhead_samples(samples_per_second)
+    , per_item_samples(samples_per_second)
+    {}
+
+    // bounds of the batch size: the batches are multiples of granule items
+    // and at most max_batch_size (the allocated buffers)
+    void attach(const size_t granule, const size_t max_batch_size)
+    {
+        this->granule = std::max<size_t>(granule, 1);
+        this->max_batch_size = max_batch_size;
+        batch_size_ = clamp(max_batch_size);
+    }
+
+    size_t batch_size() const
+    {
+        return batch_size_;
+    }
+
+    // items that reached the generator (pushed) or the drainer (popped)
+    void arrived(const size_t items, const uint64_t now = current_time_nsecs())
+    {
+        if (last_arrival != 0 && now > last_arrival) {
+            const double r = double(items) / double(now - last_arrival);
+            rate = (rate == 0.0) ? r : (smoothing * r + (1.0 - smoothing) * rate);
+        }
+        last_arrival = now;
+
+        decide(now);
+    }
+
+    // device time of a completed batch of batch_size items
+    void completed(const size_t batch_size, const double device_ns, const uint64_t now = current_time_nsecs())
+    {
+        if (batch_size == 0 || device_ns <= 0.0) return;
+
+        const double b = double(batch_size);
+        const double decay = 1.0 - smoothing;
+        s0  = decay * s0  + 1.0;
+        sb  = decay * sb  + b;
+        sbb = decay * sbb + b * b;
+        st  = decay * st  + device_ns;
+        sbt = decay * sbt + b * device_ns;
+
+        const double var = s0 * sbb - sb * sb;
+        if (var > 1e-6 * s0 * sbb) {
+            per_item = std::max((s0 * sbt - sb * st) / var, 0.0);
+            overhead = std::max((st - per_item * sb) / s0, 0.0);
+        } else {
+            // a single batch size so far: all the cost is per item, which
+            // lets the batch size move and the overhead show up
+            per_item = st / sb;
+            overhead = 0.0;
+        }
+
+        decide(now);
+    }
+
+    void decide(const uint64_t now)
+    {
+        if (max_batch_size == 0) return;
+
+        if (rate <= 0.0) {
+            batch_size_ = clamp(max_batch_size);
+        } else {
+            const double inter_arrival = 1.0 / rate;
+
+            double b_lat = (latency_slo - overhead) / (inter_arrival + per_item);
+            double b_thr = 0.0;
+            const double slack = inter_arrival / headroom - per_item;
+            if (slack > 0.0) {
+                b_thr = overhead / slack;
+            } else {
+                b_thr = double(max_batch_size);
+            }
+
+            const double b = (b_thr > b_lat) ? b_thr : b_lat;
+            batch_size_ = clamp(b > double(max_batch_size) ? max_batch_size : size_t(b));
+        }
+
+        batch_size_samples.add(double(batch_size_), now);
+        rate_samples.add(rate * 1e9, now);
+        overhead_samples.add(overhead, now);
+        per_item_samples.add(per_item, now);
+    }
+
+    size_t clamp(size_t b) const
+    {
+        b = std::max(b, min_batch_size);
+        b = std::min(b, max_batch_size);
+        b = (b / granule) * granule;
+        return std::max(b, std::min(granule, max_batch_size));
+    }
+
+    // publishes the sampled decisions as `prefix`batch_size, `prefix`arrival_rate
+    // (items/s), `prefix`batch_overhead (ns) and `prefix`item_cost (ns)
+    void publish(MetricGroup & group, const std::string & prefix = "")
+    {
+        group.add(prefix + "batch_size", batch_size_samples);
+        group.add(prefix + "arrival_rate", rate_samples);
+        group.add(prefix + "batch_overhead", overhead_samples);
+        group.add(prefix + "item_cost", per_item_samples);
+    }
+};
+
+}
+
+#endif // __HOST_BATCH_CONTROLLER__
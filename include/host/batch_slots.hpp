@@ -0,0 +1,143 @@
+#ifndef __HOST_BATCH_SLOTS__
+#define __HOST_BATCH_SLOTS__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+
+namespace fx {
+
+// Order in which the batches of several producers reach the kernel: the order
+// in which they were acquired (IN_ORDER) or pushed (OUT_OF_ORDER).
+enum BatchOrder {
+    IN_ORDER,
+    OUT_OF_ORDER
+};
+
+// Lock-free bookkeeping of the batches of a generator shared by several
+// producer threads (ConcurrentStreamGenerator). A slot is FREE, FILLING, owned
+// by the producer that acquired it, or RUNNING, submitted to the kernel; a
+// RUNNING slot is reclaimed by the producer that finds its kernel done. Only
+// the submissions are serialized, by tickets, so that the kernels see the
+// batches in the selected order; buffers are filled concurrently.
+struct BatchSlots
+{
+    enum State : int {
+        FREE,
+        FILLING,
+        RUNNING,
+        CHECKING    // RUNNING, its kernel is being checked by one producer
+    };
+
+    size_t size;
+    BatchOrder order;
+
+    std::unique_ptr< std::atomic<int>[] > states;
+    std::unique_ptr< size_t[] > tickets;
+
+    alignas(64) std::atomic<size_t> next_ticket;
+    alignas(64) std::atomic<size_t> next_submit;
+    alignas(64) std::atomic<size_t> cursor;
+
+    BatchSlots(const size_t size, const BatchOrder order = IN_ORDER)
+    : size(size)
+    , order(order)
+    , states(new std::atomic<int>[size])
+    , tickets(new size_t[size])
+    , next_ticket(0)
+    , next_submit(0)
+    , cursor(0)
+    {
+        for (size_t s = 0; s < size; ++s) {
+            states[s].store(FREE, std::memory_order_relaxed);
+            tickets[s] = 0;
+        }
+    }
+
+    // Returns a slot in FILLING, owned by the caller. `done(s)` tells if the
+    // kernel of the RUNNING slot s completed, it is never called concurrently
+    // on the same slot; the caller has to release the resources of the
+    // previous kernel of the slot, if any.
+    template <typename DONE_T>
+    size_t acquire(DONE_T && done)
+    {
+        size_t s = cursor.fetch_add(1, std::memory_order_relaxed) % size;
+        while (true) {
+            for (size_t k = 0; k < size; ++k) {
+                int state = FREE;
+                if (states[s].compare_exchange_strong(state, FILLING, std::memory_order_acq_rel)) {
+                    return take(s);
+                }
+                state = RUNNING;
+                if (states[s].compare_exchange_strong(state, CHECKING, std::memory_order_acq_rel)) {
+                    if (done(s)) {
+                        states[s].store(FILLING, std::memory_order_release);
+                        return take(s);
+                    }
+                    states[s].store(RUNNING, std::memory_order_release);
+                }
+                s = (s + 1 == size) ? 0 : (s + 1);
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // waits for the turn of the FILLING slot s: from here to submitted or
+    // cancel the caller is the only one submitting
+    void wait_turn(const size_t s)
+    {
+        if (order == OUT_OF_ORDER) {
+            tickets[s] = next_ticket.fetch_add(1, std::memory_order_relaxed);
+        }
+        while (next_submit.load(std::memory_order_acquire) != tickets[s]) {
+            std::this_thread::yield();
+        }
+    }
+
+    // the batch of slot s has been submitted, passes the turn
+    void submitted(const size_t s)
+    {
+        states[s].store(RUNNING, std::memory_order_release);
+        next_submit.store(tickets[s] + 1, std::memory_order_release);
+    }
+
+    // slot s is given back without a submission, passes the turn
+    void cancel(const size_t s)
+    {
+        states[s].store(FREE, std::memory_order_release);
+        next_submit.store(tickets[s] + 1, std::memory_order_release);
+    }
+
+    // waits for the submissions in progress (with IN_ORDER for every acquired
+    // slot to be submitted or cancelled)
+    void drain()
+    {
+        while (next_submit.load(std::memory_order_acquire) != next_ticket.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool running(const size_t s) const
+    {
+        return states[s].load(std::memory_order_acquire) == RUNNING;
+    }
+
+    void release(const size_t s)
+    {
+        states[s].store(FREE, std::memory_order_release);
+    }
+
+    size_t take(const size_t s)
+    {
+        if (order == IN_ORDER) {
+            tickets[s] = next_ticket.fetch_add(1, std::memory_order_relaxed);
+        }
+        return s;
+    }
+};
+
+}
+
+#endif // __HOST_BATCH_SLOTS__
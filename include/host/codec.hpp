@@ -0,0 +1,140 @@
+#ifndef __HOST_CODEC__
+#define __HOST_CODEC__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../datastructures/codec.hpp"
+
+
+namespace fx {
+
+// Host counterpart of WMtoS_codec/StoWM_codec: the first item of the batch is
+// stored raw in line 0, as the memory image of T, and seeds the codecs, the
+// others follow as records of CODEC_T::BITS bits, W / CODEC_T::BITS per line
+// of W bits, first record in the least significant bits, laid out in memory as
+// the ap_uint<W> of the kernels. Other layouts specialize batch_codec_t (see
+// packed_codec.hpp).
+
+static inline void put_bits(uint64_t * words, const size_t pos, const code_t value, const unsigned int bits)
+{
+    for (unsigned int b = 0; b < bits; ++b) {
+        const size_t p = pos + b;
+        const uint64_t bit = (value >> b) & 1;
+        words[p / 64] = (words[p / 64] & ~(uint64_t(1) << (p % 64))) | (bit << (p % 64));
+    }
+}
+
+static inline code_t get_bits(const uint64_t * words, const size_t pos, const unsigned int bits)
+{
+    code_t value = 0;
+    for (unsigned int b = 0; b < bits; ++b) {
+        const size_t p = pos + b;
+        value |= code_t((words[p / 64] >> (p % 64)) & 1) << b;
+    }
+    return value;
+}
+
+template <int W, typename CODEC_T>
+struct batch_codec_t
+{
+    static constexpr size_t RECORDS = W / CODEC_T::BITS;
+
+    static constexpr size_t lines(const size_t count)
+    {
+        return (count == 0) ? 0 : 1 + (count - 1 + RECORDS - 1) / RECORDS;
+    }
+
+    template <typename T>
+    static void encode(const T * items, const size_t count, uint64_t * words)
+    {
+        static_assert(sizeof(T) * 8 <= W, "fx::encode_batch: T must fit in a line");
+
+        if (count == 0) {
+            return;
+        }
+
+        std::memcpy(words, &items[0], sizeof(T));
+
+        CODEC_T codec;
+        codec.reset(items[0]);
+        code_t codes[CODEC_T::FIELDS];
+        for (size_t i = 1; i < count; ++i) {
+            if (!codec.fits(items[i])) {
+                std::cerr << "fx::encode_batch: item " << i << " of the batch does not fit the codecs of its fields" << '\n';
+                exit(EXIT_FAILURE);
+            }
+            codec.encode(items[i], codes);
+            const size_t pos = W + ((i - 1) / RECORDS) * W + ((i - 1) % RECORDS) * CODEC_T::BITS;
+            for (unsigned int f = 0; f < CODEC_T::FIELDS; ++f) {
+                put_bits(words, pos + CODEC_T::offset(f), codes[f], CODEC_T::width(f));
+            }
+        }
+    }
+
+    template <typename T>
+    static void decode(const uint64_t * words, const size_t count, T * items)
+    {
+        static_assert(sizeof(T) * 8 <= W, "fx::decode_batch: T must fit in a line");
+
+        if (count == 0) {
+            return;
+        }
+
+        std::memcpy(&items[0], words, sizeof(T));
+
+        CODEC_T codec;
+        codec.reset(items[0]);
+        code_t codes[CODEC_T::FIELDS];
+        for (size_t i = 1; i < count; ++i) {
+            const size_t pos = W + ((i - 1) / RECORDS) * W + ((i - 1) % RECORDS) * CODEC_T::BITS;
+            for (unsigned int f = 0; f < CODEC_T::FIELDS; ++f) {
+                codes[f] = get_bits(words, pos + CODEC_T::offset(f), CODEC_T::width(f));
+            }
+            items[i] = codec.decode(codes);
+        }
+    }
+};
+
+template <int W, typename CODEC_T>
+constexpr size_t codec_lines(const size_t count)
+{
+    return batch_codec_t<W, CODEC_T>::lines(count);
+}
+
+// Encodes `count` items into `lines` (at least codec_lines<W, CODEC_T>(count)
+// lines of W bits) and returns the number of lines used. An item that the
+// codecs cannot represent (a delta wider than BITS, a value outside the frame
+// of reference or the dictionary) is an error: it would be decoded as a
+// different tuple.
+template <int W, typename CODEC_T, typename T>
+size_t encode_batch(const T * items, const size_t count, void * lines)
+{
+    static_assert(W % 64 == 0, "fx::encode_batch: W must be a multiple of 64");
+
+    uint64_t * words = reinterpret_cast<uint64_t *>(lines);
+    const size_t used = codec_lines<W, CODEC_T>(count);
+
+    for (size_t w = 0; w < used * (W / 64); ++w) {
+        words[w] = 0;
+    }
+    batch_codec_t<W, CODEC_T>::encode(items, count, words);
+    return used;
+}
+
+// Decodes `count` items written by StoWM_codec (StoWM_packed with a
+// packed_codec_t) from `lines` into `items`.
+template <int W, typename CODEC_T, typename T>
+void decode_batch(const void * lines, const size_t count, T * items)
+{
+    static_assert(W % 64 == 0, "fx::decode_batch: W must be a multiple of 64");
+
+    batch_codec_t<W, CODEC_T>::decode(reinterpret_cast<const uint64_t *>(lines), count, items);
+}
+
+} // namespace fx
+
+#endif // __HOST_CODEC__
@@ -0,0 +1,217 @@
+#ifndef __HOST_CPU_OCL__
+#define __HOST_CPU_OCL__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "../defines.hpp"
+#include "../utils.hpp"
+
+namespace fx {
+
+//*****************************************************************
+//
+// CPU backend (FX_CPU_BACKEND)
+//
+//*****************************************************************
+
+// The kernels are the C++ functions of the design, compiled for the CPU with
+// FX_CPU_BACKEND: every dataflow process runs in its own thread and streams
+// are lock-free SPSC queues (see streams/dataflow.hpp). The memory_reader and
+// memory_writer compute units are registered per replica with the arguments
+// of the kernels generated for the card, the free-running compute kernels are
+// started with launch, e.g.
+//
+//     fx::stream<T> in, out;
+//     ocl.set_memory_reader(0, [&](void * batch, int count, int eos) {
+//         memory_reader((ap_uint<512> *)batch, count, eos, in);
+//     });
+//     ocl.launch([&]() { compute(in, out); });
+//     ocl.set_memory_writer(0, [&](void * batch, int size, int * count, int * eos) {
+//         memory_writer(out, (ap_uint<512> *)batch, size, count, eos);
+//     });
+//
+// A memory_writer that takes the idle_cycles of StoWM as last argument also
+// gets the flush timeout set with StreamDrainer::set_flush_timeout.
+
+using cpu_memory_reader_t = std::function<void(void * batch, int count, int eos)>;
+using cpu_memory_writer_t = std::function<void(void * batch, int size, int * items_written, int * eos)>;
+// memory_writer with the flush timeout of StoWM, see StreamDrainer::set_flush_timeout
+using cpu_memory_writer_idle_t = std::function<void(void * batch, int size, int * items_written, int * eos, int idle_cycles)>;
+
+// In-order command queue: the tasks run one after the other in a worker
+// thread, as the invocations of a compute unit.
+struct CPUCommandQueue
+{
+    std::deque< std::packaged_task<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop;
+    std::thread worker;
+
+    CPUCommandQueue()
+    : stop(false)
+    , worker([this]() { run(); })
+    {}
+
+    CPUCommandQueue(const CPUCommandQueue &) = delete;
+    CPUCommandQueue & operator=(const CPUCommandQueue &) = delete;
+
+    void run()
+    {
+        while (true) {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]() { return stop || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::future<void> enqueue(std::function<void()> f)
+    {
+        std::packaged_task<void()> task(std::move(f));
+        std::future<void> done = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+        return done;
+    }
+
+    void finish()
+    {
+        enqueue([]() {}).wait();
+    }
+
+    ~CPUCommandQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_one();
+        worker.join();
+    }
+};
+
+// Drop-in for the OpenCL OCL context of host/ocl.hpp: the constructor takes
+// the same arguments, which are ignored.
+struct OCL
+{
+    std::vector<cpu_memory_reader_t> memory_readers;
+    std::vector<cpu_memory_writer_idle_t> memory_writers;
+    std::vector<std::thread> kernels;
+
+    OCL(const std::string & filename = "",
+        int platform_id = -1,
+        int device_id = -1,
+        bool show_build_time = false)
+    {
+        UNUSED(filename);
+        UNUSED(platform_id);
+        UNUSED(device_id);
+
+        if (show_build_time) {
+            std::cout << "INFO: CPU backend, no bitstream to load" << '\n';
+        }
+    }
+
+    OCL(const OCL &) = delete;
+    OCL & operator=(const OCL &) = delete;
+
+    void set_memory_reader(const size_t replica_id, cpu_memory_reader_t kernel)
+    {
+        if (memory_readers.size() <= replica_id) {
+            memory_readers.resize(replica_id + 1);
+        }
+        memory_readers[replica_id] = std::move(kernel);
+    }
+
+    void set_memory_writer(const size_t replica_id, cpu_memory_writer_idle_t kernel)
+    {
+        if (memory_writers.size() <= replica_id) {
+            memory_writers.resize(replica_id + 1);
+        }
+        memory_writers[replica_id] = std::move(kernel);
+    }
+
+    // the flush timeout is ignored
+    void set_memory_writer(const size_t replica_id, cpu_memory_writer_t kernel)
+    {
+        set_memory_writer(replica_id, [kernel](void * batch, int size, int * items_written, int * eos, int) {
+            kernel(batch, size, items_written, eos);
+        });
+    }
+
+    cpu_memory_reader_t & getMemoryReader(const size_t replica_id)
+    {
+        if (replica_id >= memory_readers.size() || !memory_readers[replica_id]) {
+            std::cerr << "fx::OCL: no memory_reader_" << replica_id << " on the CPU backend" << '\n';
+            exit(EXIT_FAILURE);
+        }
+        return memory_readers[replica_id];
+    }
+
+    cpu_memory_writer_idle_t & getMemoryWriter(const size_t replica_id)
+    {
+        if (replica_id >= memory_writers.size() || !memory_writers[replica_id]) {
+            std::cerr << "fx::OCL: no memory_writer_" << replica_id << " on the CPU backend" << '\n';
+            exit(EXIT_FAILURE);
+        }
+        return memory_writers[replica_id];
+    }
+
+    // starts a free-running kernel, it returns at the end of its streams
+    void launch(std::function<void()> kernel)
+    {
+        kernels.emplace_back(std::move(kernel));
+    }
+
+    size_t getMemoryReadersCUInfo()
+    {
+        return memory_readers.size();
+    }
+
+    size_t getMemoryWritersCUInfo()
+    {
+        return memory_writers.size();
+    }
+
+    // waits for the kernels started with launch
+    void finish()
+    {
+        for (auto & k : kernels) {
+            k.join();
+        }
+        kernels.clear();
+    }
+
+    void clean()
+    {
+        finish();
+    }
+
+    ~OCL()
+    {
+        finish();
+    }
+};
+
+}
+
+#endif // __HOST_CPU_OCL__
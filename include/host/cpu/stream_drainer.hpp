@@ -0,0 +1,343 @@
+#ifndef __HOST_CPU_STREAM_DRAINER__
+#define __HOST_CPU_STREAM_DRAINER__
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <future>
+#include <atomic>
+#include <functional>
+
+#include "../defines.hpp"
+#include "../utils.hpp"
+#include "../codec.hpp"
+#include "ocl.hpp"
+#include "../batch_controller.hpp"
+#include "../latency_tracker.hpp"
+
+
+namespace fx {
+
+// CPU counterpart of the StreamDrainer of host/stream_drainer.hpp, same
+// interface: every launch runs the memory_writer registered for replica_id on
+// a free batch, in order, in the thread of the command queue of the drainer.
+template <typename T, typename CODEC_T = void>
+struct StreamDrainerExecution {
+
+    static constexpr bool ENCODE = !std::is_void<CODEC_T>::value;
+    static constexpr int LINE_BITS = 512;
+    // batch sizes are multiples of GRANULE items: whole lines unless encoded
+    static constexpr size_t GRANULE = (ENCODE || sizeof(T) >= LINE_BITS / 8) ? 1 : (LINE_BITS / 8) / sizeof(T);
+
+    OCL & ocl;
+    CPUCommandQueue & queue;
+
+    size_t max_batch_size;
+    size_t buffer_size;     // bytes written by the kernel
+    std::atomic<int> * ended;
+    size_t replica_id;
+
+    T * batch_h;
+    void * buffer_h;        // batch_h itself or the encoded lines
+    int * items_written_h;
+    int * eos_h;
+
+    std::future<void> kernel_event;
+
+    int idle_cycles;        // flush timeout of the kernel, 0 to disable
+    size_t batch_items;     // items of the last execute
+    double device_ns;       // always 0: there is no transfer, and the kernel
+                            // runs as long as its batch takes to fill
+
+    StreamDrainerExecution(
+        OCL & ocl,
+        CPUCommandQueue & queue,
+        size_t batch_size,
+        std::atomic<int> * ended,
+        size_t replica_id = 0
+    )
+    : ocl(ocl)
+    , queue(queue)
+    , max_batch_size(batch_size)
+    , buffer_size(lines_size(batch_size))
+    , ended(ended)
+    , replica_id(replica_id)
+    , idle_cycles(0)
+    , batch_items(0)
+    , device_ns(0.0)
+    {
+        buffer_h = aligned_alloc<char>(buffer_size);
+        batch_h = ENCODE ? aligned_alloc<T>(max_batch_size) : (T *)buffer_h;
+
+        items_written_h = aligned_alloc<int>(1);
+        items_written_h[0] = 0;
+
+        eos_h = aligned_alloc<int>(1);
+        eos_h[0] = 0;
+    }
+
+    void set_flush_timeout(const int idle_cycles)
+    {
+        this->idle_cycles = idle_cycles;
+    }
+
+    // bytes of the kernel output buffer holding batch_size items
+    static size_t lines_size(const size_t batch_size)
+    {
+        if constexpr (ENCODE) {
+            return codec_lines<LINE_BITS, CODEC_T>(batch_size) * (LINE_BITS / 8);
+        } else {
+            return batch_size * sizeof(T);
+        }
+    }
+
+    // decodes the items written by the kernel into batch_h
+    void decode(const size_t items_written)
+    {
+        if constexpr (ENCODE) {
+            decode_batch<LINE_BITS, CODEC_T>(buffer_h, items_written, batch_h);
+        }
+    }
+
+    void execute(size_t batch_size)
+    {
+        if (batch_size > max_batch_size) {
+            std::cerr
+                << "fx::StreamDrainer: batch_size is larger than max_batch_size!"
+                << "Only " << max_batch_size << " elements are processed."
+                << '\n';
+
+            batch_size = max_batch_size;
+        }
+        batch_items = batch_size;
+
+        const int _bs = static_cast<int>(lines_size(batch_size));
+
+        // copied, a later set_memory_writer may reallocate the vector it lives in
+        cpu_memory_writer_idle_t kernel = ocl.getMemoryWriter(replica_id);
+        void * buffer = buffer_h;
+        int * items_written = items_written_h;
+        int * eos = eos_h;
+        std::atomic<int> * end = ended;
+        const int idle = idle_cycles;
+        // the executions launched after the end of the stream return empty,
+        // as there is nothing left to read
+        kernel_event = queue.enqueue([kernel, buffer, _bs, items_written, eos, end, idle]() {
+            if (end->load()) {
+                items_written[0] = 0;
+                eos[0] = 1;
+                return;
+            }
+            kernel(buffer, _bs, items_written, eos, idle);
+            if (eos[0]) {
+                end->store(1);
+            }
+        });
+    }
+
+    // calls `callback` from the thread of the command queue when the kernel
+    // launched by execute has returned
+    void notify(std::function<void()> callback)
+    {
+        queue.enqueue(std::move(callback));
+    }
+
+    void wait()
+    {
+        if (!kernel_event.valid()) return;
+
+        kernel_event.get();
+    }
+
+    ~StreamDrainerExecution()
+    {
+        wait();
+
+        free(items_written_h);
+        free(eos_h);
+        free(buffer_h);
+
+        if constexpr (ENCODE) {
+            free(batch_h);
+        }
+    }
+};
+
+template <typename T, typename CODEC_T = void>
+struct StreamDrainer
+{
+    using Execution = StreamDrainerExecution<T, CODEC_T>;
+    using ExecutionQueue = std::deque<Execution *>;
+
+    OCL & ocl;
+    CPUCommandQueue queue;
+
+    size_t max_batch_size;
+    size_t number_of_buffers;
+    size_t replica_id;
+    size_t iterations;
+
+    BatchController * controller;
+    std::function<void(const T *, size_t)> latency;
+
+    std::atomic<int> ended;     // set by the execution that reads the end of the stream
+
+    ExecutionQueue ready_queue;
+    ExecutionQueue running_queue;
+
+    StreamDrainer(
+        OCL & ocl,
+        const size_t batch_size,
+        const size_t N = 2,
+        const size_t replica_id = 0
+    )
+    : ocl(ocl)
+    , queue()
+    , max_batch_size(next_pow2(batch_size))
+    , number_of_buffers(N)
+    , replica_id(replica_id)
+    , iterations(0)
+    , controller(nullptr)
+    , latency()
+    , ended(0)
+    , ready_queue()
+    , running_queue()
+    {
+        if (batch_size != max_batch_size) {
+            std::cout << "fx::StreamDrainer: `batch_size` is rounded to the next power of 2 ("
+                      << batch_size << " -> " << max_batch_size << ")" << '\n';
+        }
+
+        for (size_t n = 0; n < number_of_buffers; ++n) {
+            ready_queue.push_back(new Execution(ocl, queue, max_batch_size, &ended, replica_id));
+        }
+    }
+
+    void prelaunch()
+    {
+        for (size_t n = 0; n < number_of_buffers; ++n) {
+            launch_kernel(batch_size());
+        }
+    }
+
+    void launch_kernel(size_t batch_size)
+    {
+        Execution * execution = ready_queue.front();
+        ready_queue.pop_front();
+        execution->execute(batch_size);
+        running_queue.push_back(execution);
+    }
+
+    T * pop(
+        size_t * items_written,
+        bool * last)
+    {
+        if (running_queue.empty()) {
+            std::cerr << "fx::StreamDrainer: no launched executions" << '\n';
+            return nullptr;
+        }
+
+        Execution * execution = running_queue.front();
+        running_queue.pop_front();
+        execution->wait();
+
+        T * batch = execution->batch_h;
+        *items_written = execution->items_written_h[0];
+        *last = this->last(execution);
+        execution->decode(*items_written);
+
+        if (latency) {
+            latency(batch, *items_written);
+        }
+
+        if (controller) {
+            controller->completed(execution->batch_items, execution->device_ns);
+            controller->arrived(*items_written);
+        }
+
+        ready_queue.push_back(execution);
+
+        iterations++;
+
+        return batch;
+    }
+
+    // true if the completed execution read the end of the stream
+    bool last(const Execution * execution) const
+    {
+        return (execution->eos_h[0] ? true : false);
+    }
+
+    void put_batch(T * batch, size_t batch_size)
+    {
+        if (!batch) {
+            std::cerr << "fx::StreamDrainer: batch is nullptr" << '\n';
+            return;
+        }
+
+        launch_kernel(batch_size);
+    }
+
+    // the batch sizes are then chosen by `controller`, see batch_size()
+    void set_controller(BatchController * controller)
+    {
+        this->controller = controller;
+        if (controller) {
+            controller->attach(Execution::GRANULE, max_batch_size);
+        }
+    }
+
+    // records to `tracker` the latency of the results stamped in the field
+    // `stamp` of T
+    template <typename S>
+    void set_latency_tracker(LatencyTracker & tracker, S T::* stamp)
+    {
+        latency = [&tracker, stamp](const T * batch, size_t items) { tracker.record(batch, items, stamp); };
+    }
+
+    // items to request with the next put_batch
+    size_t batch_size() const
+    {
+        return controller ? controller->batch_size() : max_batch_size;
+    }
+
+    // bounds the latency of sparse outputs: an execution completes with the
+    // items received so far once the kernel has been idle for idle_cycles
+    // cycles, so pop may return fewer items than requested, without last
+    void set_flush_timeout(const int idle_cycles)
+    {
+        for (Execution * execution : ready_queue) {
+            execution->set_flush_timeout(idle_cycles);
+        }
+        for (Execution * execution : running_queue) {
+            execution->set_flush_timeout(idle_cycles);
+        }
+    }
+
+    void launch_kernels() {}
+
+    void finish()
+    {
+        while (!running_queue.empty()) {
+            Execution * execution = running_queue.front();
+            running_queue.pop_front();
+            execution->wait();
+            ready_queue.push_back(execution);
+        }
+    }
+
+    ~StreamDrainer()
+    {
+        finish();
+
+        while (!ready_queue.empty()) {
+            Execution * execution = ready_queue.front();
+            ready_queue.pop_front();
+            delete execution;
+        }
+    }
+};
+
+}
+
+#endif // __HOST_CPU_STREAM_DRAINER__
@@ -0,0 +1,544 @@
+#ifndef __HOST_CPU_STREAM_GENERATOR__
+#define __HOST_CPU_STREAM_GENERATOR__
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include <future>
+#include <chrono>
+
+#include "../defines.hpp"
+#include "../utils.hpp"
+#include "../codec.hpp"
+#include "../batch_slots.hpp"
+#include "../mapped_file.hpp"
+#include "ocl.hpp"
+#include "../batch_controller.hpp"
+#include "../latency_tracker.hpp"
+
+
+namespace fx {
+
+// CPU counterpart of the StreamGenerator of host/stream_generator.hpp, same
+// interface: every push runs the memory_reader registered for replica_id on
+// the batch, in order, in the thread of the command queue of the generator.
+template <typename T, typename CODEC_T = void>
+struct StreamGeneratorExecution
+{
+    static constexpr bool ENCODE = !std::is_void<CODEC_T>::value;
+    static constexpr int LINE_BITS = 512;
+    // batch sizes are multiples of GRANULE items: whole lines unless encoded
+    static constexpr size_t GRANULE = (ENCODE || sizeof(T) >= LINE_BITS / 8) ? 1 : (LINE_BITS / 8) / sizeof(T);
+
+    OCL & ocl;
+    CPUCommandQueue & queue;
+
+    size_t max_batch_size;
+    size_t replica_id;
+    size_t buffer_size;     // bytes read by the kernel
+
+    T * batch_h;
+    void * buffer_h;        // batch_h itself or the encoded lines
+
+    std::future<void> kernel_event;
+
+    bool profile;           // set device_ns
+    size_t batch_items;     // items of the last execute
+    double device_ns;       // run time of the kernel on the last batch
+
+    StreamGeneratorExecution(
+        OCL & ocl,
+        CPUCommandQueue & queue,
+        const size_t batch_size,
+        const size_t replica_id = 0
+    )
+    : ocl(ocl)
+    , queue(queue)
+    , max_batch_size(batch_size)
+    , replica_id(replica_id)
+    , buffer_size(0)
+    , profile(false)
+    , batch_items(0)
+    , device_ns(0.0)
+    {
+        if constexpr (ENCODE) {
+            buffer_size = codec_lines<LINE_BITS, CODEC_T>(max_batch_size) * (LINE_BITS / 8);
+        } else {
+            buffer_size = max_batch_size * sizeof(T);
+        }
+
+        buffer_h = aligned_alloc<char>(buffer_size);
+        batch_h = ENCODE ? aligned_alloc<T>(max_batch_size) : (T *)buffer_h;
+    }
+
+    void execute(
+        size_t batch_size,
+        bool eos
+    )
+    {
+        if (batch_size > max_batch_size) {
+            std::cerr
+                << "fx::StreamGenerator: batch_size is larger than max_batch_size!"
+                << "Only " << max_batch_size << " elements are processed."
+                << '\n';
+
+            batch_size = max_batch_size;
+        }
+        batch_items = batch_size;
+
+        int count_int = 0;
+        if constexpr (ENCODE) {
+            encode_batch<LINE_BITS, CODEC_T>(batch_h, batch_size, buffer_h);
+            count_int = static_cast<int>(batch_size);
+        } else {
+            count_int = static_cast<int>(batch_size / ((512 / 8) / sizeof(T)));
+        }
+        const int eos_int = static_cast<int>(eos);
+
+        // copied, a later set_memory_reader may reallocate the vector it lives in
+        cpu_memory_reader_t kernel = ocl.getMemoryReader(replica_id);
+        void * buffer = buffer_h;
+        double * elapsed = profile ? &device_ns : nullptr;
+        kernel_event = queue.enqueue([kernel, buffer, count_int, eos_int, elapsed]() {
+            const uint64_t start = current_time_nsecs();
+            kernel(buffer, count_int, eos_int);
+            if (elapsed) {
+                *elapsed = double(current_time_nsecs() - start);
+            }
+        });
+    }
+
+    T * get_batch_ptr()
+    {
+        return batch_h;
+    }
+
+    T * get_batch()
+    {
+        return batch_h;
+    }
+
+    // true if no kernel is pending on the batch
+    bool done()
+    {
+        if (!kernel_event.valid()) return true;
+
+        return kernel_event.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    void wait()
+    {
+        if (!kernel_event.valid()) return;
+
+        kernel_event.get();
+    }
+
+    ~StreamGeneratorExecution()
+    {
+        wait();
+
+        free(buffer_h);
+
+        if constexpr (ENCODE) {
+            free(batch_h);
+        }
+    }
+};
+
+template <typename T, typename CODEC_T = void>
+struct StreamGenerator
+{
+    using Execution = StreamGeneratorExecution<T, CODEC_T>;
+    using ExecutionQueue = std::deque<Execution *>;
+
+    OCL & ocl;
+    CPUCommandQueue queue;
+
+    size_t max_batch_size;
+    size_t number_of_buffers;
+    size_t replica_id;
+    size_t iterations;
+
+    BatchController * controller;
+    std::function<void(T *, size_t)> latency;
+
+    ExecutionQueue ready_queue;
+    ExecutionQueue running_queue;
+
+    StreamGenerator(
+        OCL & ocl,
+        const size_t batch_size,
+        const size_t N = 2,
+        const size_t replica_id = 0
+    )
+    : ocl(ocl)
+    , queue()
+    , max_batch_size(next_pow2(batch_size))
+    , number_of_buffers(N)
+    , replica_id(replica_id)
+    , iterations(0)
+    , controller(nullptr)
+    , latency()
+    , ready_queue()
+    , running_queue()
+    {
+        if (batch_size != max_batch_size) {
+            std::cout << "fx::StreamGenerator: `batch_size` is rounded to the next power of 2 ("
+                      << batch_size << " -> " << max_batch_size << ")" << '\n';
+        }
+
+        for (size_t n = 0; n < number_of_buffers; ++n) {
+            running_queue.push_back(new Execution(ocl, queue, max_batch_size, replica_id));
+        }
+    }
+
+    T * get_batch()
+    {
+        Execution * execution = running_queue.front();
+        running_queue.pop_front();
+
+        if (iterations >= number_of_buffers) {
+            execution->wait();
+            if (controller) {
+                controller->completed(execution->batch_items, execution->device_ns);
+            }
+        }
+
+        T * batch = execution->get_batch();
+        ready_queue.push_back(execution);
+
+        return batch;
+    }
+
+    void push(
+        T * batch,
+        const size_t batch_size,
+        const bool last = false
+    )
+    {
+        Execution * execution = ready_queue.front();
+        ready_queue.pop_front();
+
+        if (batch != execution->get_batch_ptr()) {
+            std::cerr << "fx::StreamGenerator: batch pointer mismatch!" << '\n';
+        }
+
+        if (latency) {
+            latency(batch, batch_size);
+        }
+
+        execution->execute(batch_size, last);
+        running_queue.push_back(execution);
+
+        if (controller) {
+            controller->arrived(batch_size);
+        }
+
+        iterations++;
+    }
+
+    // the batch sizes are then chosen by `controller`, see batch_size()
+    void set_controller(BatchController * controller)
+    {
+        this->controller = controller;
+        if (controller) {
+            controller->attach(Execution::GRANULE, max_batch_size);
+        }
+        for (Execution * execution : running_queue) {
+            execution->profile = (controller != nullptr);
+        }
+        for (Execution * execution : ready_queue) {
+            execution->profile = (controller != nullptr);
+        }
+    }
+
+    // stamps the tuples pushed for `tracker`, in the field `stamp` of T
+    template <typename S>
+    void set_latency_tracker(LatencyTracker & tracker, S T::* stamp)
+    {
+        latency = [&tracker, stamp](T * batch, size_t items) { tracker.stamp(batch, items, stamp); };
+    }
+
+    // items to push in the next batch
+    size_t batch_size() const
+    {
+        return controller ? controller->batch_size() : max_batch_size;
+    }
+
+    void launch_kernels() {}
+
+    void finish()
+    {
+        while (!running_queue.empty()) {
+            Execution * execution = running_queue.front();
+            running_queue.pop_front();
+            execution->wait();
+            ready_queue.push_back(execution);
+        }
+    }
+
+    ~StreamGenerator()
+    {
+        finish();
+
+        while (!ready_queue.empty()) {
+            Execution * execution = ready_queue.front();
+            ready_queue.pop_front();
+            delete execution;
+        }
+    }
+};
+
+// CPU counterpart of the ConcurrentStreamGenerator of
+// host/stream_generator.hpp: the command queue runs the batches in the order
+// of submission, so no chaining is needed.
+template <typename T, typename CODEC_T = void>
+struct ConcurrentStreamGenerator
+{
+    using Execution = StreamGeneratorExecution<T, CODEC_T>;
+
+    struct Batch
+    {
+        T * data;
+        size_t slot;
+    };
+
+    OCL & ocl;
+    CPUCommandQueue queue;
+
+    size_t max_batch_size;
+    size_t number_of_buffers;
+    size_t replica_id;
+
+    std::vector<Execution *> executions;
+    BatchSlots slots;
+
+    ConcurrentStreamGenerator(
+        OCL & ocl,
+        const size_t batch_size,
+        const size_t N = 4,
+        const size_t replica_id = 0,
+        const BatchOrder order = IN_ORDER
+    )
+    : ocl(ocl)
+    , queue()
+    , max_batch_size(next_pow2(batch_size))
+    , number_of_buffers(N)
+    , replica_id(replica_id)
+    , executions()
+    , slots(N, order)
+    {
+        if (batch_size != max_batch_size) {
+            std::cout << "fx::ConcurrentStreamGenerator: `batch_size` is rounded to the next power of 2 ("
+                      << batch_size << " -> " << max_batch_size << ")" << '\n';
+        }
+
+        for (size_t n = 0; n < number_of_buffers; ++n) {
+            executions.push_back(new Execution(ocl, queue, max_batch_size, replica_id));
+        }
+    }
+
+    Batch acquire()
+    {
+        const size_t s = slots.acquire([this](const size_t i) {
+            return executions[i]->done();
+        });
+        executions[s]->wait();
+
+        return Batch{executions[s]->get_batch(), s};
+    }
+
+    void push(
+        Batch & batch,
+        const size_t batch_size,
+        const bool last = false
+    )
+    {
+        if (batch.slot >= number_of_buffers || batch.data != executions[batch.slot]->get_batch_ptr()) {
+            // the slot of the batch is unknown and cannot be given back:
+            // the producers waiting for its turn would spin forever
+            std::cerr << "fx::ConcurrentStreamGenerator: batch not acquired from this generator!" << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        slots.wait_turn(batch.slot);
+        if (batch_size == 0 && !last) {
+            slots.cancel(batch.slot);
+        } else {
+            executions[batch.slot]->execute(batch_size, last);
+            slots.submitted(batch.slot);
+        }
+
+        batch.data = nullptr;
+    }
+
+    void launch_kernels() {}
+
+    void finish()
+    {
+        slots.drain();
+
+        for (size_t s = 0; s < number_of_buffers; ++s) {
+            if (slots.running(s)) {
+                executions[s]->wait();
+                slots.release(s);
+            }
+        }
+    }
+
+    ~ConcurrentStreamGenerator()
+    {
+        finish();
+
+        for (Execution * execution : executions) {
+            delete execution;
+        }
+    }
+};
+
+
+// CPU counterpart of the FileStreamGenerator of host/stream_generator.hpp:
+// the memory_reader reads the batches in place from the mapping.
+template <typename T>
+struct FileStreamGenerator
+{
+    struct Slot
+    {
+        std::future<void> kernel_event;
+        size_t end;             // offset in the file after the batch
+        size_t loop;            // loop of the batch
+    };
+
+    OCL & ocl;
+    CPUCommandQueue queue;
+    MappedFile<T> & file;
+
+    size_t max_batch_size;
+    size_t number_of_buffers;
+    size_t replica_id;
+    size_t readahead;
+    size_t loops;
+    size_t iterations;
+
+    size_t line_items;          // tuples in a 512-bit line
+    size_t file_items;          // tuples pushed per loop
+    size_t offset;              // next tuple of the file
+    size_t loop;
+    bool ended;
+
+    std::vector<Slot> slots;
+
+    FileStreamGenerator(
+        OCL & ocl,
+        MappedFile<T> & file,
+        const size_t batch_size,
+        const size_t N = 2,
+        const size_t replica_id = 0,
+        const size_t readahead = 4,
+        const size_t loops = 1
+    )
+    : ocl(ocl)
+    , queue()
+    , file(file)
+    , max_batch_size(next_pow2(batch_size))
+    , number_of_buffers(N)
+    , replica_id(replica_id)
+    , readahead(readahead)
+    , loops(loops)
+    , iterations(0)
+    , line_items(((512 / 8) / sizeof(T)) ? ((512 / 8) / sizeof(T)) : 1)
+    , file_items(0)
+    , offset(0)
+    , loop(0)
+    , ended(false)
+    , slots(N)
+    {
+        if (batch_size != max_batch_size) {
+            std::cout << "fx::FileStreamGenerator: `batch_size` is rounded to the next power of 2 ("
+                      << batch_size << " -> " << max_batch_size << ")" << '\n';
+        }
+
+        file_items = file.size() / line_items * line_items;
+        if (file_items != file.size()) {
+            std::cerr << "fx::FileStreamGenerator: the last " << (file.size() - file_items)
+                      << " tuples do not fill a line and are skipped" << '\n';
+        }
+        if (file_items == 0 || loops == 0) {
+            std::cerr << "fx::FileStreamGenerator: nothing to push, only the eos is sent" << '\n';
+            file_items = 0;
+            this->loops = 1;
+        }
+
+        for (Slot & slot : slots) {
+            slot.end = 0;
+            slot.loop = 0;
+        }
+
+        file.advise(0, readahead * max_batch_size);
+    }
+
+    bool next()
+    {
+        if (ended) return false;
+
+        Slot & slot = slots[iterations % number_of_buffers];
+        wait(slot);
+
+        const size_t size = std::min(max_batch_size, file_items - offset);
+        const bool last = (offset + size == file_items) && (loop + 1 == loops);
+
+        const int count_int = static_cast<int>(size / line_items);
+        const int eos_int = static_cast<int>(last);
+        // copied, a later set_memory_reader may reallocate the vector it lives in
+        cpu_memory_reader_t kernel = ocl.getMemoryReader(replica_id);
+        void * buffer = (void *)(file.data + offset);
+        slot.kernel_event = queue.enqueue([kernel, buffer, count_int, eos_int]() {
+            kernel(buffer, count_int, eos_int);
+        });
+
+        offset += size;
+        slot.end = offset;
+        slot.loop = loop;
+        ended = last;
+        if (!last) {
+            if (offset == file_items) {
+                offset = 0;
+                loop++;
+                file.rewind();
+            }
+            file.advise(offset, readahead * max_batch_size);
+        }
+        iterations++;
+
+        return true;
+    }
+
+    void wait(Slot & slot)
+    {
+        if (!slot.kernel_event.valid()) return;
+
+        slot.kernel_event.get();
+        if (slot.loop == loop) {
+            file.release(slot.end);
+        }
+    }
+
+    void launch_kernels() {}
+
+    void finish()
+    {
+        for (size_t n = 0; n < number_of_buffers; ++n) {
+            wait(slots[(iterations + n) % number_of_buffers]);
+        }
+    }
+
+    ~FileStreamGenerator()
+    {
+        finish();
+    }
+};
+
+}
+
+#endif // __HOST_CPU_STREAM_GENERATOR__
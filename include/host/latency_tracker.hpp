@@ -0,0 +1,245 @@
+#ifndef __HOST_LATENCY_TRACKER__
+#define __HOST_LATENCY_TRACKER__
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "utils.hpp"
+#include "metric/metric.hpp"
+#include "metric/metric_group.hpp"
+
+
+namespace fx {
+
+// What the stamp field of a tuple holds: the host time of ingest, in units of
+// `resolution` ns (STAMP_TIME), or the sequence number of the batch that
+// carried it, mapped back to the time the batch was pushed (STAMP_SEQUENCE).
+// Either way 0 means "not stamped".
+enum LatencyStamp {
+    STAMP_TIME,
+    STAMP_SEQUENCE
+};
+
+// End-to-end (ingest to result) latency of a pipeline. The generator stamps
+// one tuple out of `sample_every` in an integral field of the input tuple
+// (the others get 0), the pipeline carries the stamp to the results as an
+// opaque field, and the drainer turns the stamps it finds into latencies,
+// recorded in `group` under `name` with the lock-free recorder of the calling
+// thread (rate limited by samples_per_second, 0 records all of them).
+//
+//     fx::LatencyTracker latency("latency");
+//     generator.set_latency_tracker(latency, &input_t::stamp);
+//     drainer.set_latency_tracker(latency, &output_t::stamp);
+//     ...
+//     latency.report();
+//
+// No operator of the library forwards the stamp itself, only the user
+// functors that build the results do: Map, Filter and FlatMap functors that
+// copy their input keep it, and the output functor of a join should copy the
+// largest stamp of the joined tuples (the result is then measured from its
+// last contributing tuple). The window operators build their results from
+// the window state, which has no stamp: a windowed pipeline delivers only 0s
+// and its latency is not measured. The window `sequence` counts the tuples
+// seen by the window, flushes included, so it cannot replace the stamp.
+//
+// Stamps are taken modulo the range of the field: a 32-bit field holds ~71
+// minutes of latency at the default resolution of 1 us. With STAMP_SEQUENCE
+// the push times of the last `history` batches are kept, older stamps are
+// counted as expired.
+//
+// stamp has a single caller (the generator), record may be called by any
+// number of threads (the drainers, the workers of an AsyncStreamDrainer).
+struct LatencyTracker
+{
+    struct Entry
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> time;
+    };
+
+    std::string name;
+    MetricGroup & group;
+    LatencyStamp mode;
+    size_t sample_every;
+    uint64_t resolution;        // ns per unit of a STAMP_TIME stamp
+    uint64_t samples_per_second;
+    uint64_t epoch;
+
+    // generator side
+    size_t countdown;           // tuples before the next stamp
+    uint64_t next_sequence;
+
+    // push times of the last batches, STAMP_SEQUENCE only
+    size_t history;
+    std::unique_ptr<Entry[]> entries;
+
+    std::atomic<uint64_t> stamped;
+    std::atomic<uint64_t> recorded;
+    std::atomic<uint64_t> expired;
+
+    LatencyTracker(
+        const std::string & name,
+        const size_t sample_every = 64,
+        const LatencyStamp mode = STAMP_TIME,
+        const uint64_t resolution_ns = 1000,
+        const size_t history = 4096,
+        const uint64_t samples_per_second = 0,
+        MetricGroup & group = metric_group
+    )
+    : name(name)
+    , group(group)
+    , mode(mode)
+    , sample_every(sample_every ? sample_every : 1)
+    , resolution(resolution_ns ? resolution_ns : 1)
+    , samples_per_second(samples_per_second)
+    , epoch(current_time_nsecs())
+    , countdown(0)
+    , next_sequence(0)
+    , history(next_pow2(uint64_t(history ? history : 1)))
+    , entries(nullptr)
+    , stamped(0)
+    , recorded(0)
+    , expired(0)
+    {
+        if (mode == STAMP_SEQUENCE) {
+            entries.reset(new Entry[this->history]);
+            for (size_t e = 0; e < this->history; ++e) {
+                entries[e].sequence.store(0, std::memory_order_relaxed);
+                entries[e].time.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    LatencyTracker(const LatencyTracker &) = delete;
+    LatencyTracker & operator=(const LatencyTracker &) = delete;
+
+    // stamps are kept in [1, range], the field wraps around after range;
+    // range + 1 is a power of 2
+    template <typename S>
+    static uint64_t range()
+    {
+        static_assert(std::is_integral<S>::value, "fx::LatencyTracker: the stamp field must be integral");
+        return (sizeof(S) >= sizeof(uint64_t))
+            ? std::numeric_limits<uint64_t>::max()
+            : (uint64_t(1) << (8 * sizeof(S) - (std::is_signed<S>::value ? 1 : 0))) - 1;
+    }
+
+    // called by the generator before the batch is sent to the device
+    template <typename T, typename S>
+    void stamp(T * batch, const size_t items, S T::* field, const uint64_t now = current_time_nsecs())
+    {
+        const uint64_t r = range<S>();
+
+        uint64_t value;
+        if (mode == STAMP_TIME) {
+            value = ((now - epoch) / resolution) % r + 1;
+        } else {
+            // the sequence numbers are taken modulo the range of the field,
+            // skipping the ones that would give a 0 stamp
+            uint64_t sequence;
+            do {
+                sequence = ++next_sequence;
+            } while ((sequence & r) == 0);
+            value = sequence & r;
+
+            Entry & entry = entries[value & (history - 1)];
+            entry.sequence.store(0, std::memory_order_release);
+            entry.time.store(now, std::memory_order_release);
+            entry.sequence.store(sequence, std::memory_order_release);
+        }
+
+        size_t count = 0;
+        for (size_t i = 0; i < items; ++i) {
+            if (countdown == 0) {
+                batch[i].*field = S(value);
+                countdown = sample_every;
+                count++;
+            } else {
+                batch[i].*field = S(0);
+            }
+            countdown--;
+        }
+        stamped += count;
+    }
+
+    // called by the drainer on the results of a batch
+    template <typename T, typename S>
+    void record(const T * batch, const size_t items, S T::* field, const uint64_t now = current_time_nsecs())
+    {
+        Sampler * sampler = nullptr;
+        const uint64_t r = range<S>();
+        size_t count = 0;
+
+        for (size_t i = 0; i < items; ++i) {
+            const uint64_t value = uint64_t(batch[i].*field);
+            if (value == 0) continue;
+
+            double ns;
+            if (!latency(value, r, now, ns)) {
+                expired++;
+                continue;
+            }
+
+            if (sampler == nullptr) {
+                sampler = &group.recorder(name, samples_per_second);
+            }
+            sampler->add(ns, now);
+            count++;
+        }
+        recorded += count;
+    }
+
+    // latency (ns) of a stamp, false if its batch is no longer in the history
+    bool latency(const uint64_t value, const uint64_t r, const uint64_t now, double & ns) const
+    {
+        if (mode == STAMP_TIME) {
+            const uint64_t a = ((now - epoch) / resolution) % r;
+            const uint64_t b = value - 1;
+            ns = double(a >= b ? a - b : r - b + a) * resolution;
+            return true;
+        }
+
+        // the entry is valid if it still holds a batch stamped with `value`
+        const Entry & entry = entries[value & (history - 1)];
+        const uint64_t sequence = entry.sequence.load(std::memory_order_acquire);
+        const uint64_t time = entry.time.load(std::memory_order_acquire);
+        if (sequence == 0 || (sequence & r) != value || entry.sequence.load(std::memory_order_acquire) != sequence) {
+            return false;
+        }
+        ns = (now > time) ? double(now - time) : 0.0;
+        return true;
+    }
+
+    Metric metric()
+    {
+        return group.get_metric(name);
+    }
+
+    void report()
+    {
+        Metric m = metric();
+
+        std::cout
+            << COUT_HEADER_SMALL << name << ": "
+            << COUT_HEADER_SMALL << "\tSamples: " << COUT_INTEGER << m.getN()
+            << " (" << expired << " expired)";
+        if (m.getN() > 0) {
+            std::cout
+                << COUT_HEADER_SMALL << "\tLatency: "
+                << "p50 " << COUT_FLOAT_(2) << m.percentile(0.5) / 1e3 << " us, "
+                << "p99 " << COUT_FLOAT_(2) << m.percentile(0.99) / 1e3 << " us, "
+                << "p999 " << COUT_FLOAT_(2) << m.percentile(0.999) / 1e3 << " us, "
+                << "max " << COUT_FLOAT_(2) << m.max() / 1e3 << " us";
+        }
+        std::cout << '\n';
+    }
+};
+
+}
+
+#endif // __HOST_LATENCY_TRACKER__
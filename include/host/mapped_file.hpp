@@ -0,0 +1,153 @@
+#ifndef __HOST_MAPPED_FILE__
+#define __HOST_MAPPED_FILE__
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+namespace fx {
+
+// Read-only mapping of a binary file of tuples T (raw, as in memory), or an
+// anonymous region of `items` tuples backed by huge pages if available, to be
+// filled by the caller. A file on hugetlbfs is mapped with huge pages as well.
+// Pages are loaded on demand: advise() reads ahead a window of the mapping and
+// release() drops the pages already consumed, so a trace larger than memory is
+// streamed with a bounded resident set.
+template <typename T>
+struct MappedFile
+{
+    int fd;
+    bool anonymous;
+    size_t bytes;           // length of the mapping
+    size_t items;           // whole tuples in the mapping
+    size_t page_size;
+    T * data;
+
+    size_t dropped;         // bytes before this offset have been released
+
+    explicit MappedFile(const std::string & filename)
+    : fd(-1)
+    , anonymous(false)
+    , bytes(0)
+    , items(0)
+    , page_size(sysconf(_SC_PAGESIZE))
+    , data(nullptr)
+    , dropped(0)
+    {
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "fx::MappedFile: cannot open " << filename << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            std::cerr << "fx::MappedFile: " << filename << " is empty or cannot be read" << '\n';
+            exit(EXIT_FAILURE);
+        }
+        bytes = st.st_size;
+        items = bytes / sizeof(T);
+        if (bytes % sizeof(T) != 0) {
+            std::cerr << "fx::MappedFile: " << filename << " is not a multiple of the tuple size, "
+                      << "the last " << (bytes % sizeof(T)) << " bytes are ignored" << '\n';
+        }
+
+        void * ptr = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            std::cerr << "fx::MappedFile: cannot map " << filename << '\n';
+            exit(EXIT_FAILURE);
+        }
+        data = (T *)ptr;
+        madvise(ptr, bytes, MADV_SEQUENTIAL);
+    }
+
+    MappedFile(const size_t items, const bool huge_pages)
+    : fd(-1)
+    , anonymous(true)
+    , bytes(items * sizeof(T))
+    , items(items)
+    , page_size(sysconf(_SC_PAGESIZE))
+    , data(nullptr)
+    , dropped(0)
+    {
+        void * ptr = MAP_FAILED;
+        #ifdef MAP_HUGETLB
+        if (huge_pages) {
+            const size_t huge = 2 * 1024 * 1024;
+            const size_t len = (bytes + huge - 1) / huge * huge;
+            ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) {
+                bytes = len;
+                page_size = huge;
+            } else {
+                std::cerr << "fx::MappedFile: no huge pages available, using regular pages" << '\n';
+            }
+        }
+        #endif
+        if (ptr == MAP_FAILED) {
+            ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+        if (ptr == MAP_FAILED) {
+            std::cerr << "fx::MappedFile: cannot map " << bytes << " bytes" << '\n';
+            exit(EXIT_FAILURE);
+        }
+        data = (T *)ptr;
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    size_t size() const
+    {
+        return items;
+    }
+
+    // starts reading [offset, offset + window) tuples in the background
+    void advise(const size_t offset, const size_t window)
+    {
+        if (offset >= items) return;
+
+        const size_t begin = (offset * sizeof(T)) / page_size * page_size;
+        const size_t end = std::min(bytes, (offset + window) * sizeof(T));
+        if (end > begin) {
+            madvise((char *)data + begin, end - begin, MADV_WILLNEED);
+        }
+    }
+
+    // releases the pages of the file before `offset`, the tuples consumed;
+    // anonymous regions hold the only copy of the data and are kept
+    void release(const size_t offset)
+    {
+        const size_t begin = std::min(bytes, offset * sizeof(T)) / page_size * page_size;
+        if (!anonymous && begin > dropped) {
+            madvise((char *)data + dropped, begin - dropped, MADV_DONTNEED);
+            dropped = begin;
+        }
+    }
+
+    // the pages dropped by release are read again from the file on access
+    void rewind()
+    {
+        dropped = 0;
+    }
+
+    ~MappedFile()
+    {
+        if (data != nullptr) {
+            munmap(data, bytes);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+}
+
+#endif // __HOST_MAPPED_FILE__
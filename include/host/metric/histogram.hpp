@@ -0,0 +1,166 @@
+#ifndef __METRIC_HISTOGRAM_HPP__
+#define __METRIC_HISTOGRAM_HPP__
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+
+namespace fx {
+
+// Fixed-memory log-linear histogram (HDR-style): every power of two in
+// [2^MIN_EXP, 2^MAX_EXP) is split into SUB_BUCKETS linear buckets, so values
+// are kept with a relative error below 1 / SUB_BUCKETS (0.8%) in 64 KiB,
+// whatever the number of samples. Smaller values (and zero) share the first
+// bucket, larger ones the last; count, sum, min and max are exact.
+//
+// A histogram has a single writer (record), the counters are atomics written
+// with plain stores so that other threads can read or merge it at any time
+// without locks.
+class Histogram {
+
+public:
+
+    static constexpr int SUB_BITS = 7;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MIN_EXP = -16;
+    static constexpr int MAX_EXP = 48;
+    static constexpr int BUCKETS = 1 + (MAX_EXP - MIN_EXP) * SUB_BUCKETS;
+
+private:
+
+    std::unique_ptr< std::atomic<uint64_t>[] > counts_;
+    std::atomic<uint64_t> count_;
+    std::atomic<double> sum_;
+    std::atomic<double> min_;
+    std::atomic<double> max_;
+
+    static void bump(std::atomic<uint64_t> & c, uint64_t n)
+    {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+public:
+
+    Histogram()
+    : counts_(new std::atomic<uint64_t>[BUCKETS])
+    , count_(0)
+    , sum_(0.0)
+    , min_(std::numeric_limits<double>::max())
+    , max_(std::numeric_limits<double>::lowest())
+    {
+        for (int b = 0; b < BUCKETS; ++b) {
+            counts_[b].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    Histogram(const Histogram & other)
+    : Histogram()
+    {
+        merge(other);
+    }
+
+    Histogram & operator=(const Histogram & other)
+    {
+        if (this != &other) {
+            reset();
+            merge(other);
+        }
+        return *this;
+    }
+
+    static int index(double value)
+    {
+        if (!(value >= std::ldexp(1.0, MIN_EXP))) return 0;
+
+        int e;
+        const double m = std::frexp(value, &e);     // value = m * 2^e, m in [0.5, 1)
+        const int k = e - 1;                        // value in [2^k, 2^(k + 1))
+        if (k >= MAX_EXP) return BUCKETS - 1;
+
+        const int sub = static_cast<int>((2.0 * m - 1.0) * SUB_BUCKETS);
+        return 1 + (k - MIN_EXP) * SUB_BUCKETS + sub;
+    }
+
+    // midpoint of bucket b
+    static double value(int b)
+    {
+        if (b <= 0) return 0.0;
+
+        const int k = (b - 1) / SUB_BUCKETS + MIN_EXP;
+        const int sub = (b - 1) % SUB_BUCKETS;
+        return std::ldexp(1.0 + (sub + 0.5) / SUB_BUCKETS, k);
+    }
+
+    void record(double value, uint64_t n = 1)
+    {
+        bump(counts_[index(value)], n);
+        bump(count_, n);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value * n, std::memory_order_relaxed);
+        if (value < min_.load(std::memory_order_relaxed)) min_.store(value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+    }
+
+    // adds the samples of other, which may be written concurrently
+    void merge(const Histogram & other)
+    {
+        for (int b = 0; b < BUCKETS; ++b) {
+            const uint64_t c = other.counts_[b].load(std::memory_order_relaxed);
+            if (c) bump(counts_[b], c);
+        }
+        bump(count_, other.count_.load(std::memory_order_relaxed));
+        sum_.store(sum_.load(std::memory_order_relaxed) + other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        if (other.min() < min()) min_.store(other.min(), std::memory_order_relaxed);
+        if (other.max() > max()) max_.store(other.max(), std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        for (int b = 0; b < BUCKETS; ++b) {
+            counts_[b].store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0.0, std::memory_order_relaxed);
+        min_.store(std::numeric_limits<double>::max(), std::memory_order_relaxed);
+        max_.store(std::numeric_limits<double>::lowest(), std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    double sum() const { return sum_.load(std::memory_order_relaxed); }
+
+    double min() const { return min_.load(std::memory_order_relaxed); }
+
+    double max() const { return max_.load(std::memory_order_relaxed); }
+
+    double mean() const
+    {
+        const uint64_t n = count();
+        return n ? sum() / n : 0.0;
+    }
+
+    // value below which a fraction p (in [0, 1]) of the samples lies, O(BUCKETS)
+    double percentile(double p) const
+    {
+        const uint64_t n = count();
+        if (n == 0) return 0.0;
+
+        uint64_t target = static_cast<uint64_t>(std::ceil(p * n));
+        if (target < 1) target = 1;
+        if (target > n) target = n;
+
+        uint64_t seen = 0;
+        int b = 0;
+        for (; b < BUCKETS - 1; ++b) {
+            seen += counts_[b].load(std::memory_order_relaxed);
+            if (seen >= target) break;
+        }
+        return std::fmin(std::fmax(value(b), min()), max());
+    }
+};
+
+}
+
+#endif // __METRIC_HISTOGRAM_HPP__
@@ -3,60 +3,61 @@
 
 #include <cstdint>
 #include <string>
-#include <vector>
-#include <numeric>
-#include <algorithm>
+#include <limits>
+
+#include "histogram.hpp"
 
 
 namespace fx {
 
+// Summary of the samples of a metric, kept in a fixed-memory Histogram:
+// percentiles are within the relative error of the histogram (0.8%), count,
+// mean, min and max are exact.
 class Metric {
 
 private:
 
     std::string name_;
-    std::vector<double> samples_;
+    Histogram histogram_;
     uint64_t total_;
 
 public:
 
     Metric(const std::string &name)
     : name_(name)
+    , histogram_()
+    , total_(0)
     {}
 
-    void add(double value) { samples_.push_back(value); }
+    const std::string & name() const { return name_; }
+
+    void add(double value) { histogram_.record(value); }
+
+    void merge(const Histogram & histogram) { histogram_.merge(histogram); }
 
     void total(uint64_t total) { total_ = total; }
 
     uint64_t total() { return total_; }
 
-    uint64_t getN() { return samples_.size(); }
+    uint64_t getN() { return histogram_.count(); }
 
-    double mean()
-    {
-        if (samples_.empty()) return 0.0;
-        return std::accumulate(samples_.begin(), samples_.end(), 0.0) / samples_.size();
-    }
+    double mean() { return histogram_.mean(); }
 
     double min()
     {
-        if (samples_.empty()) return std::numeric_limits<double>::max();
-        return *std::min_element(samples_.begin(), samples_.end());
+        if (histogram_.count() == 0) return std::numeric_limits<double>::max();
+        return histogram_.min();
     }
 
     double max()
     {
-        if (samples_.empty()) return std::numeric_limits<double>::min();
-        return *std::max_element(samples_.begin(), samples_.end());
+        if (histogram_.count() == 0) return std::numeric_limits<double>::min();
+        return histogram_.max();
     }
 
-    double percentile(double percentile)
-    {
-        if (samples_.empty()) return 0.0;
-        auto pointer = samples_.begin() + samples_.size() * percentile;
-        std::nth_element(samples_.begin(), pointer, samples_.end());
-        return *pointer;
-    }
+    double percentile(double percentile) { return histogram_.percentile(percentile); }
+
+    const Histogram & histogram() const { return histogram_; }
 };
 
 }
@@ -4,6 +4,9 @@
 
 #include "metric.hpp"
 #include "sampler.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -12,40 +15,75 @@
 
 namespace fx {
 
+// Named metrics made of the samplers of several threads. A thread gets its own
+// recorder with `recorder(name)` (the mutex is taken once per thread and name,
+// then samples are added without locks), or hands over a finished sampler
+// with `add`. get_metric merges the samplers of a name at any time. The
+// recorders of a thread are looked up by the id of the group, never reused,
+// so a group created where a destroyed one lived does not get its samplers.
 class MetricGroup {
 
 private:
 
+    const uint64_t id_ = next_id();
     std::mutex mutex_;
-    std::unordered_map<std::string, std::vector<Sampler>> map_;
+    std::unordered_map<std::string, std::vector< std::unique_ptr<Sampler> >> map_;
+
+    Sampler * make(const std::string & name, uint64_t samples_per_second)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &samplers = map_[name];
+        samplers.emplace_back(new Sampler(samples_per_second));
+        return samplers.back().get();
+    }
+
+    static uint64_t next_id()
+    {
+        static std::atomic<uint64_t> ids(0);
+        return ids.fetch_add(1, std::memory_order_relaxed);
+    }
 
 public:
 
-    void add(std::string name, Sampler sampler)
+    void add(std::string name, const Sampler & sampler)
     {
         std::lock_guard<std::mutex> lock(mutex_);
         auto &samplers = map_[name];
-        samplers.push_back(sampler);
+        samplers.emplace_back(new Sampler(sampler));
     }
 
+    // the sampler of the calling thread for `name`, owned by the group
+    Sampler & recorder(const std::string & name, uint64_t samples_per_second = 0)
+    {
+        thread_local std::unordered_map<uint64_t, std::unordered_map<std::string, Sampler *>> recorders;
+
+        auto &mine = recorders[id_];
+        auto it = mine.find(name);
+        if (it != mine.end()) {
+            return *it->second;
+        }
+
+        Sampler * sampler = make(name, samples_per_second);
+        mine[name] = sampler;
+        return *sampler;
+    }
+
+    // snapshot of the samplers of `name`, total is the number of values
+    // offered to them (sampled or not)
     Metric get_metric(std::string name)
     {
         Metric metric(name);
+        uint64_t total = 0;
 
-        // consume all the groups
-        auto &samplers = map_.at(name);
-        while (!samplers.empty()) {
-            auto sampler = samplers.back();
-            metric.total(sampler.total());
-
-            // add all the values from the sampler
-            for (double value : sampler.values()) {
-                metric.add(value);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = map_.find(name);
+        if (it != map_.end()) {
+            for (auto &sampler : it->second) {
+                metric.merge(sampler->histogram());
+                total += sampler->total();
             }
-
-            // discard it
-            samplers.pop_back();
         }
+        metric.total(total);
 
         return metric;
     }
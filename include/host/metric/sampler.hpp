@@ -1,13 +1,17 @@
 #ifndef __METRIC_SAMPLER_HPP__
 #define __METRIC_SAMPLER_HPP__
 
+#include <atomic>
 #include <cstdint>
-#include <vector>
 #include <sys/time.h>
 #include "../utils.hpp"
+#include "histogram.hpp"
 
 namespace fx {
 
+// Per-thread recorder of a metric: the sampled values go into a Histogram, so
+// a sampler has a fixed size and add never locks nor allocates. A sampler has
+// a single writer; it can be read (and merged into a Metric) concurrently.
 class Sampler {
 
 private:
@@ -15,8 +19,8 @@ private:
     const uint64_t samples_per_second_;
     uint64_t epoch_;
     uint64_t counter_;
-    uint64_t total_;
-    std::vector<double> samples_;
+    std::atomic<uint64_t> total_;
+    Histogram histogram_;
 
 public:
 
@@ -25,23 +29,32 @@ public:
     , epoch_(fx::current_time_nsecs())
     , counter_(0)
     , total_(0)
+    , histogram_()
+    {}
+
+    Sampler(const Sampler & other)
+    : samples_per_second_(other.samples_per_second_)
+    , epoch_(other.epoch_)
+    , counter_(other.counter_)
+    , total_(other.total())
+    , histogram_(other.histogram_)
     {}
 
     void add(double value, uint64_t timestamp)
     {
-        ++total_;
+        total_.store(total_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 
         // add samples according to the sample rate
         auto seconds = (timestamp - epoch_) / 1e9;
         if (samples_per_second_ == 0 || counter_ <= samples_per_second_ * seconds) {
-            samples_.push_back(value);
+            histogram_.record(value);
             ++counter_;
         }
     }
 
-    const std::vector<double> & values() const { return samples_; }
+    const Histogram & histogram() const { return histogram_; }
 
-    uint64_t total() const { return total_; }
+    uint64_t total() const { return total_.load(std::memory_order_relaxed); }
 
 };
 
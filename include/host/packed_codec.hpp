@@ -0,0 +1,71 @@
+#ifndef __HOST_PACKED_CODEC__
+#define __HOST_PACKED_CODEC__
+
+#include <cstdint>
+#include <cstddef>
+
+#include "../datastructures/typehandler.hpp"
+#include "codec.hpp"
+
+
+namespace fx {
+
+// Layout of WMtoS_packed/StoWM_packed, usable as the CODEC_T of encode_batch,
+// decode_batch, StreamGenerator and StreamDrainer: the items are serialized
+// by TypeHandler<T> and stored back to back, across lines. Kept apart from
+// codec.hpp as it needs ap_int.h.
+template <typename T>
+struct packed_codec_t
+{
+    using data_t = T;
+    static constexpr unsigned int BITS = TypeHandler<T>::WIDTH;
+};
+
+template <int BITS>
+static inline void put_ap(uint64_t * words, const size_t pos, const ap_uint<BITS> & value)
+{
+    for (int b = 0; b < BITS; b += 64) {
+        const int n = (BITS - b < 64) ? (BITS - b) : 64;
+        put_bits(words, pos + b, value.range(b + n - 1, b).to_uint64(), n);
+    }
+}
+
+template <int BITS>
+static inline ap_uint<BITS> get_ap(const uint64_t * words, const size_t pos)
+{
+    ap_uint<BITS> value = 0;
+    for (int b = 0; b < BITS; b += 64) {
+        const int n = (BITS - b < 64) ? (BITS - b) : 64;
+        value.range(b + n - 1, b) = get_bits(words, pos + b, n);
+    }
+    return value;
+}
+
+template <int W, typename T>
+struct batch_codec_t<W, packed_codec_t<T>>
+{
+    static constexpr int T_BITS = TypeHandler<T>::WIDTH;
+
+    static constexpr size_t lines(const size_t count)
+    {
+        return (count * T_BITS + W - 1) / W;
+    }
+
+    static void encode(const T * items, const size_t count, uint64_t * words)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            put_ap<T_BITS>(words, i * T_BITS, TypeHandler<T>::to_ap(items[i]));
+        }
+    }
+
+    static void decode(const uint64_t * words, const size_t count, T * items)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            items[i] = TypeHandler<T>::from_ap(get_ap<T_BITS>(words, i * T_BITS));
+        }
+    }
+};
+
+} // namespace fx
+
+#endif // __HOST_PACKED_CODEC__
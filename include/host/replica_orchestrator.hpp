@@ -0,0 +1,390 @@
+#ifndef __HOST_REPLICA_ORCHESTRATOR__
+#define __HOST_REPLICA_ORCHESTRATOR__
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstring>
+
+#include "utils.hpp"
+#include "affinity.hpp"
+#ifdef FX_CPU_BACKEND
+#include "cpu/stream_generator.hpp"
+#include "cpu/stream_drainer.hpp"
+#else
+#include "stream_generator.hpp"
+#include "stream_drainer.hpp"
+#endif
+
+
+namespace fx {
+
+// How the batches pushed to a ReplicaOrchestrator are spread over the
+// replicas: whole batches in turn (ROUND_ROBIN) or tuple by tuple on
+// key(t) % replicas (KEY_PARTITIONED), so that a key is always processed by
+// the same replica.
+enum ReplicaPolicy {
+    ROUND_ROBIN,
+    KEY_PARTITIONED
+};
+
+// Drives `number_of_replicas` instances of the design, the memory_reader_r and
+// memory_writer_r compute units generated by include/utils/*.sh: every
+// replica has a StreamGenerator and a StreamDrainer, each in its own thread
+// pinned to a CPU of the NUMA node of the card (numa_node, -1 to leave the
+// threads unpinned). The threads build their generator or drainer, so the
+// host buffers are allocated on that node. Batches pushed by the user are
+// queued to the replicas (up to `depth` per replica, then push blocks), packed
+// into the batches of the generators, and the results are handed to
+// `handler(replica, batch, items, last)` in the drainer threads.
+//
+// The memory_reader takes whole lines of GRANULE tuples. At close, with
+// ROUND_ROBIN the tuples left over by the replicas are gathered by the last
+// one to close, which drops at most one partial line (reported and counted
+// by items_dropped, not by items_in). With KEY_PARTITIONED moving them would
+// break the partitioning: every replica must receive whole lines, the
+// orchestrator fails otherwise.
+//
+//     fx::ReplicaOrchestrator<T> orchestrator(ocl, 4, batch_size, handler);
+//     orchestrator.push(std::move(tuples));
+//     ...
+//     orchestrator.finish();
+//     orchestrator.report();
+template <typename T, typename CODEC_T = void>
+struct ReplicaOrchestrator
+{
+    using Generator = StreamGenerator<T, CODEC_T>;
+    using Drainer = StreamDrainer<T, CODEC_T>;
+    using Handler = std::function<void(size_t replica, const T * batch, size_t items_written, bool last)>;
+    using KeyFn = std::function<size_t(const T &)>;
+
+    struct Replica
+    {
+        size_t id;
+        int ingest_cpu;
+        int drain_cpu;
+
+        std::deque< std::vector<T> > inbox;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool closed;
+
+        std::atomic<uint64_t> items_in;
+        std::atomic<uint64_t> items_out;
+
+        std::thread ingest;
+        std::thread drain;
+    };
+
+    OCL & ocl;
+    size_t number_of_replicas;
+    size_t batch_size;
+    size_t number_of_buffers;
+    size_t depth;
+    ReplicaPolicy policy;
+    KeyFn key;
+    Handler handler;
+    int numa_node;
+
+    std::vector< std::unique_ptr<Replica> > replicas;
+    size_t next;
+    bool closed;
+
+    // tuples left over by the replicas at close, ROUND_ROBIN only
+    std::mutex tail_mutex;
+    std::vector<T> tail;
+    size_t open_replicas;
+    std::atomic<uint64_t> dropped;
+
+    std::chrono::high_resolution_clock::time_point start_time;
+    std::atomic<int64_t> end_ns;    // last drained batch, from start_time
+
+    ReplicaOrchestrator(
+        OCL & ocl,
+        const size_t number_of_replicas,
+        const size_t batch_size,
+        Handler handler,
+        const ReplicaPolicy policy = ROUND_ROBIN,
+        KeyFn key = nullptr,
+        const size_t N = 2,
+        const size_t depth = 4,
+        const int numa_node = card_numa_node()
+    )
+    : ocl(ocl)
+    , number_of_replicas(number_of_replicas)
+    , batch_size(batch_size)
+    , number_of_buffers(N)
+    , depth(depth ? depth : 1)
+    , policy(policy)
+    , key(std::move(key))
+    , handler(std::move(handler))
+    , numa_node(numa_node)
+    , replicas()
+    , next(0)
+    , closed(false)
+    , tail()
+    , open_replicas(number_of_replicas)
+    , dropped(0)
+    , start_time(high_resolution_time())
+    , end_ns(0)
+    {
+        if (number_of_replicas == 0) {
+            std::cerr << "fx::ReplicaOrchestrator: needs at least one replica" << '\n';
+            exit(EXIT_FAILURE);
+        }
+        if (policy == KEY_PARTITIONED && !this->key) {
+            std::cerr << "fx::ReplicaOrchestrator: KEY_PARTITIONED needs a key function" << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        const std::vector<int> cpus = numa_node_cpus(numa_node);
+
+        for (size_t r = 0; r < number_of_replicas; ++r) {
+            Replica * replica = new Replica();
+            replica->id = r;
+            replica->ingest_cpu = (numa_node >= 0) ? cpus[(2 * r) % cpus.size()] : -1;
+            replica->drain_cpu = (numa_node >= 0) ? cpus[(2 * r + 1) % cpus.size()] : -1;
+            replica->closed = false;
+            replica->items_in = 0;
+            replica->items_out = 0;
+            replicas.emplace_back(replica);
+        }
+
+        for (auto & replica : replicas) {
+            Replica * rp = replica.get();
+            rp->drain = std::thread([this, rp]() { drain(*rp); });
+            rp->ingest = std::thread([this, rp]() { ingest(*rp); });
+        }
+    }
+
+    ReplicaOrchestrator(const ReplicaOrchestrator &) = delete;
+    ReplicaOrchestrator & operator=(const ReplicaOrchestrator &) = delete;
+
+    // queues a batch of tuples, blocks while the replica has `depth` batches
+    // queued; not thread-safe
+    void push(std::vector<T> && tuples)
+    {
+        if (closed) {
+            std::cerr << "fx::ReplicaOrchestrator: push after close" << '\n';
+            return;
+        }
+        if (tuples.empty()) return;
+
+        if (policy == ROUND_ROBIN) {
+            enqueue(*replicas[next], std::move(tuples));
+            next = (next + 1 == number_of_replicas) ? 0 : (next + 1);
+        } else {
+            std::vector< std::vector<T> > parts(number_of_replicas);
+            for (auto & part : parts) {
+                part.reserve(tuples.size() / number_of_replicas + 1);
+            }
+            for (const T & t : tuples) {
+                parts[key(t) % number_of_replicas].push_back(t);
+            }
+            for (size_t r = 0; r < number_of_replicas; ++r) {
+                if (!parts[r].empty()) {
+                    enqueue(*replicas[r], std::move(parts[r]));
+                }
+            }
+        }
+    }
+
+    void push(const T * tuples, const size_t size)
+    {
+        push(std::vector<T>(tuples, tuples + size));
+    }
+
+    void enqueue(Replica & replica, std::vector<T> && tuples)
+    {
+        std::unique_lock<std::mutex> lock(replica.mutex);
+        replica.cv.wait(lock, [this, &replica]() { return replica.inbox.size() < depth; });
+        replica.inbox.push_back(std::move(tuples));
+        replica.cv.notify_all();
+    }
+
+    // packs the queued tuples into the batches of the generator, the last
+    // batch is pushed with eos when the orchestrator is closed
+    void ingest(Replica & replica)
+    {
+        if (replica.ingest_cpu >= 0 && !pin_current_thread(replica.ingest_cpu)) {
+            std::cerr << "fx::ReplicaOrchestrator: cannot pin replica " << replica.id
+                      << " to CPU " << replica.ingest_cpu << '\n';
+        }
+
+        Generator generator(ocl, batch_size, number_of_buffers, replica.id);
+        const size_t max_batch_size = generator.max_batch_size;
+
+        T * batch = generator.get_batch();
+        size_t fill = 0;
+
+        auto pack = [&](const T * tuples, const size_t size) {
+            size_t i = 0;
+            while (i < size) {
+                const size_t n = std::min(size - i, max_batch_size - fill);
+                memcpy(batch + fill, tuples + i, n * sizeof(T));
+                fill += n;
+                i += n;
+
+                if (fill == max_batch_size) {
+                    generator.push(batch, fill);
+                    replica.items_in += fill;
+                    batch = generator.get_batch();
+                    fill = 0;
+                }
+            }
+        };
+
+        while (true) {
+            std::vector<T> tuples;
+            {
+                std::unique_lock<std::mutex> lock(replica.mutex);
+                replica.cv.wait(lock, [&replica]() { return replica.closed || !replica.inbox.empty(); });
+                if (replica.inbox.empty()) {
+                    break;
+                }
+                tuples = std::move(replica.inbox.front());
+                replica.inbox.pop_front();
+                replica.cv.notify_all();
+            }
+
+            pack(tuples.data(), tuples.size());
+        }
+
+        size_t rest = fill % Generator::Execution::GRANULE;
+        if (rest != 0 && policy == KEY_PARTITIONED) {
+            std::cerr << "fx::ReplicaOrchestrator: replica " << replica.id << " ends with " << rest
+                      << " tuples that do not fill a line, KEY_PARTITIONED needs whole lines of "
+                      << Generator::Execution::GRANULE << " tuples per replica" << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        // the last replica to close packs the tuples left over by the others
+        std::vector<T> carried;
+        {
+            std::lock_guard<std::mutex> lock(tail_mutex);
+            tail.insert(tail.end(), batch + fill - rest, batch + fill);
+            if (--open_replicas == 0) {
+                carried.swap(tail);
+            }
+        }
+        fill -= rest;
+        pack(carried.data(), carried.size());
+
+        rest = fill % Generator::Execution::GRANULE;
+        if (rest != 0) {
+            std::cerr << "fx::ReplicaOrchestrator: the last " << rest
+                      << " tuples do not fill a line and are dropped" << '\n';
+            fill -= rest;
+            dropped += rest;
+        }
+        generator.push(batch, fill, true);
+        replica.items_in += fill;
+        generator.finish();
+    }
+
+    void drain(Replica & replica)
+    {
+        if (replica.drain_cpu >= 0 && !pin_current_thread(replica.drain_cpu)) {
+            std::cerr << "fx::ReplicaOrchestrator: cannot pin replica " << replica.id
+                      << " to CPU " << replica.drain_cpu << '\n';
+        }
+
+        Drainer drainer(ocl, batch_size, number_of_buffers, replica.id);
+        drainer.prelaunch();
+
+        bool last = false;
+        while (!last) {
+            size_t items_written = 0;
+            T * batch = drainer.pop(&items_written, &last);
+            replica.items_out += items_written;
+            if (handler) {
+                handler(replica.id, batch, items_written, last);
+            }
+            // the drainers finish in any order: keep the latest
+            const int64_t now = elapsed_time_ns(start_time, high_resolution_time());
+            int64_t end = end_ns.load();
+            while (end < now && !end_ns.compare_exchange_weak(end, now)) {}
+            if (!last) {
+                drainer.put_batch(batch, drainer.max_batch_size);
+            }
+        }
+        drainer.finish();
+    }
+
+    // no more pushes: the replicas push their last batch with eos
+    void close()
+    {
+        if (closed) return;
+        closed = true;
+
+        for (auto & replica : replicas) {
+            std::lock_guard<std::mutex> lock(replica->mutex);
+            replica->closed = true;
+            replica->cv.notify_all();
+        }
+    }
+
+    // closes and waits for every replica to drain its last batch
+    void finish()
+    {
+        close();
+
+        for (auto & replica : replicas) {
+            if (replica->ingest.joinable()) replica->ingest.join();
+            if (replica->drain.joinable()) replica->drain.join();
+        }
+    }
+
+    uint64_t items_in() const
+    {
+        uint64_t total = 0;
+        for (auto & replica : replicas) total += replica->items_in;
+        return total;
+    }
+
+    // tuples pushed but not ingested, the partial line left at close
+    uint64_t items_dropped() const
+    {
+        return dropped;
+    }
+
+    uint64_t items_out() const
+    {
+        uint64_t total = 0;
+        for (auto & replica : replicas) total += replica->items_out;
+        return total;
+    }
+
+    // aggregate output throughput (tuples/s) from the construction to the
+    // last drained batch
+    double throughput() const
+    {
+        const int64_t ns = end_ns;
+        return (ns > 0) ? (items_out() * 1e9 / ns) : 0.0;
+    }
+
+    void report() const
+    {
+        const double ns = end_ns;
+        if (ns <= 0) return;
+
+        for (auto & replica : replicas) {
+            print_performance<T>("Replica " + std::to_string(replica->id), replica->items_out, ns);
+        }
+        print_performance<T>("Aggregate", items_out(), ns, COLOR_GREEN);
+    }
+
+    ~ReplicaOrchestrator()
+    {
+        finish();
+    }
+};
+
+}
+
+#endif // __HOST_REPLICA_ORCHESTRATOR__
@@ -0,0 +1,115 @@
+#ifndef __HOST_RING__
+#define __HOST_RING__
+
+#include <cstddef>
+#include <thread>
+
+#include "../datastructures/ring.hpp"
+
+
+namespace fx {
+
+// Host side of the rings of the persistent memory kernels, on memory shared
+// with the kernel: host-mapped buffers on the device, plain arrays in csim,
+// where the kernel (WMtoS_ring, StoWM_ring) runs in another thread. `ring`
+// holds SLOTS slots of slot_size items, `ctrl` the ring_ctrl_t<SLOTS>::WORDS
+// ints of the control block, zeroed before the kernel starts.
+
+static inline int ring_load(const int * word)
+{
+    return __atomic_load_n(word, __ATOMIC_ACQUIRE);
+}
+
+static inline void ring_store(int * word, const int value)
+{
+    __atomic_store_n(word, value, __ATOMIC_RELEASE);
+}
+
+// Producer of the slots read by WMtoS_ring.
+template <typename T, int SLOTS>
+struct RingProducer
+{
+    using RING = ring_ctrl_t<SLOTS>;
+
+    T * ring;
+    int * ctrl;
+    size_t slot_size;
+    int head;
+
+    RingProducer(T * ring, int * ctrl, const size_t slot_size)
+    : ring(ring)
+    , ctrl(ctrl)
+    , slot_size(slot_size)
+    , head(0)
+    {}
+
+    // waits for a free slot and returns it
+    T * get_batch()
+    {
+        while (head - ring_load(&ctrl[RING::TAIL]) == SLOTS) {
+            std::this_thread::yield();
+        }
+        return ring + RING::slot(head) * slot_size;
+    }
+
+    // publishes the slot returned by get_batch: `count` is in the unit of the
+    // kernel (lines for WMtoS_ring)
+    void push(const int count, const bool last = false)
+    {
+        const int slot = RING::slot(head);
+        ctrl[RING::COUNT + slot] = count;
+        ctrl[RING::EOS + slot] = last ? 1 : 0;
+        head = head + 1;
+        ring_store(&ctrl[RING::HEAD], head);
+    }
+
+    // waits for the kernel to consume every published slot
+    void finish()
+    {
+        while (ring_load(&ctrl[RING::TAIL]) != head) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+// Consumer of the slots written by StoWM_ring.
+template <typename T, int SLOTS>
+struct RingConsumer
+{
+    using RING = ring_ctrl_t<SLOTS>;
+
+    T * ring;
+    int * ctrl;
+    size_t slot_size;
+    int tail;
+
+    RingConsumer(T * ring, int * ctrl, const size_t slot_size)
+    : ring(ring)
+    , ctrl(ctrl)
+    , slot_size(slot_size)
+    , tail(0)
+    {}
+
+    // waits for a published slot and returns it, valid until put_batch
+    T * pop(size_t * items_written, bool * last)
+    {
+        while (ring_load(&ctrl[RING::HEAD]) == tail) {
+            std::this_thread::yield();
+        }
+        const int slot = RING::slot(tail);
+        *items_written = ctrl[RING::COUNT + slot];
+        *last = (ctrl[RING::EOS + slot] != 0);
+        return ring + slot * slot_size;
+    }
+
+    // gives the slot returned by pop back to the kernel
+    void put_batch()
+    {
+        tail = tail + 1;
+        ring_store(&ctrl[RING::TAIL], tail);
+    }
+};
+
+} // namespace fx
+
+#endif // __HOST_RING__
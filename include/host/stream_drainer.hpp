@@ -4,22 +4,35 @@
 #include <vector>
 #include <deque>
 #include <string>
+#include <functional>
 
 #include "defines.hpp"
 #include "utils.hpp"
 #include "ocl.hpp"
+#include "codec.hpp"
+#include "ring.hpp"
+#include "batch_controller.hpp"
+#include "latency_tracker.hpp"
 
 
 namespace fx {
 
-template <typename T>
+// With a CODEC_T (a record_codec_t, or a packed_codec_t from packed_codec.hpp)
+// the memory_writer kernel (StoWM_codec or StoWM_packed) writes encoded lines
+// of LINE_BITS bits, decoded into batch_h on pop.
+template <typename T, typename CODEC_T = void>
 struct StreamDrainerExecution {
 
+    static constexpr bool ENCODE = !std::is_void<CODEC_T>::value;
+    static constexpr int LINE_BITS = 512;
+    // batch sizes are multiples of GRANULE items: whole lines unless encoded
+    static constexpr size_t GRANULE = (ENCODE || sizeof(T) >= LINE_BITS / 8) ? 1 : (LINE_BITS / 8) / sizeof(T);
+
     OCL & ocl;
     cl_command_queue & queue;
 
     size_t max_batch_size;
-    const cl_mem * eos_d;
+    size_t buffer_size;     // bytes written by the kernel
     size_t replica_id;
 
     cl_kernel kernel;
@@ -27,37 +40,51 @@ struct StreamDrainerExecution {
 
     cl_mem batch_d;
     cl_mem items_written_d;
+    cl_mem eos_d;
 
     T * batch_h;
+    void * buffer_h;        // batch_h itself or the encoded lines
     cl_int * items_written_h;
+    cl_int * eos_h;         // eos of this execution, not of the last one completed
 
     cl_event kernel_event;
     cl_event migrate_event;
 
+    bool profile;           // set device_ns on wait, the queue must profile
+    size_t batch_items;     // items of the last execute
+    double device_ns;       // transfer time of the last batch
+
+    std::function<void()> on_complete;
+
     static constexpr int batch_argi = 1;
     static constexpr int bs_argi = 2;
     static constexpr int count_argi = 3;
     static constexpr int eos_argi = 4;
+    static constexpr int idle_argi = 5;
 
 
     StreamDrainerExecution(
         OCL & ocl,
         cl_command_queue & queue,
         size_t batch_size,
-        const cl_mem * eos_d,
         size_t replica_id = 0
     )
     : ocl(ocl)
     , queue(queue)
     , max_batch_size(batch_size)
-    , eos_d(eos_d)
+    , buffer_size(0)
     , replica_id(replica_id)
+    , profile(false)
+    , batch_items(0)
+    , device_ns(0.0)
     {
         cl_int err;
 
         kernel = ocl.createKernel("memory_writer:{memory_writer_" + std::to_string(replica_id) + "}");
         // queue = ocl.createCommandQueue();
 
+        buffer_size = lines_size(batch_size);
+
         #if STREAM_DRAINER_USE_HOSTMEM
         cl_mem_ext_ptr_t batch_ext;
         batch_ext.flags = XCL_MEM_EXT_HOST_ONLY;
@@ -66,14 +93,14 @@ struct StreamDrainerExecution {
         batch_d = clCreateBuffer(
             ocl.context,
             CL_MEM_WRITE_ONLY | CL_MEM_EXT_PTR_XILINX | CL_MEM_HOST_READ_ONLY,
-            batch_size * sizeof(T), &batch_ext,
+            buffer_size, &batch_ext,
             &err
         );
         clCheckErrorMsg(err, "fx::StreamDrainer: failed to create device buffer (batch_d)");
-        batch_h = (T *)clEnqueueMapBuffer(
+        buffer_h = clEnqueueMapBuffer(
             queue, batch_d, CL_TRUE,
             CL_MAP_READ,
-            0, batch_size * sizeof(T),
+            0, buffer_size,
             0, nullptr, nullptr, &err
         );
         clCheckErrorMsg(err, "fx::StreamDrainer: failed to map device buffer (batch_d)");
@@ -96,13 +123,32 @@ struct StreamDrainerExecution {
             0, nullptr, nullptr, &err
         );
         clCheckErrorMsg(err, "fx::StreamDrainer: failed to map device buffer (items_written_d)");
+
+        cl_mem_ext_ptr_t eos_ext;
+        eos_ext.flags = XCL_MEM_EXT_HOST_ONLY;
+        eos_ext.obj = NULL;
+        eos_ext.param = 0;
+        eos_d = clCreateBuffer(
+            ocl.context,
+            CL_MEM_WRITE_ONLY | CL_MEM_EXT_PTR_XILINX | CL_MEM_HOST_READ_ONLY,
+            sizeof(cl_int), &eos_ext,
+            &err
+        );
+        clCheckErrorMsg(err, "fx::StreamDrainer: failed to create device buffer (eos_d)");
+        eos_h = (cl_int *)clEnqueueMapBuffer(
+            queue, eos_d, CL_TRUE,
+            CL_MAP_READ,
+            0, sizeof(cl_int),
+            0, nullptr, nullptr, &err
+        );
+        clCheckErrorMsg(err, "fx::StreamDrainer: failed to map device buffer (eos_d)");
         clCheckError(clFinish(queue));
         #else
-        batch_h = aligned_alloc<T>(batch_size);
+        buffer_h = aligned_alloc<char>(buffer_size);
         batch_d = clCreateBuffer(
             ocl.context,
             CL_MEM_USE_HOST_PTR | CL_MEM_HOST_READ_ONLY | CL_MEM_WRITE_ONLY,
-            batch_size * sizeof(T), batch_h,
+            buffer_size, buffer_h,
             &err
         );
         clCheckErrorMsg(err, "fx::StreamDrainer: failed to create device buffer (batch_d)");
@@ -117,15 +163,36 @@ struct StreamDrainerExecution {
             &err
         );
         clCheckErrorMsg(err, "fx::StreamDrainer: failed to create device buffer (items_written_d)");
+
+        eos_h = aligned_alloc<cl_int>(1);
+        eos_h[0] = 0;
+
+        eos_d = clCreateBuffer(
+            ocl.context,
+            CL_MEM_USE_HOST_PTR | CL_MEM_HOST_READ_ONLY | CL_MEM_WRITE_ONLY,
+            sizeof(cl_int), eos_h,
+            &err
+        );
+        clCheckErrorMsg(err, "fx::StreamDrainer: failed to create device buffer (eos_d)");
         #endif
 
+        batch_h = ENCODE ? aligned_alloc<T>(max_batch_size) : (T *)buffer_h;
+
         clCheckError(clSetKernelArg(kernel, batch_argi, sizeof(batch_d), &batch_d));
         clCheckError(clSetKernelArg(kernel, count_argi, sizeof(items_written_d), &items_written_d));
-        clCheckError(clSetKernelArg(kernel, eos_argi,   sizeof(*eos_d),  eos_d));
+        clCheckError(clSetKernelArg(kernel, eos_argi,   sizeof(eos_d),   &eos_d));
+
+        // a memory_writer that takes idle_cycles starts with the flush timeout
+        // disabled, until set_flush_timeout
+        cl_uint num_args = 0;
+        clCheckError(clGetKernelInfo(kernel, CL_KERNEL_NUM_ARGS, sizeof(num_args), &num_args, nullptr));
+        if (num_args == idle_argi + 1) {
+            set_flush_timeout(0);
+        }
 
-        cl_mem buffers[] = {batch_d, items_written_d};
+        cl_mem buffers[] = {batch_d, items_written_d, eos_d};
         clCheckError(clEnqueueMigrateMemObjects(
-            queue, 2, buffers,
+            queue, 3, buffers,
             CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED,
             0, nullptr, &migrate_event
         ));
@@ -134,6 +201,33 @@ struct StreamDrainerExecution {
         clCheckError(clReleaseEvent(migrate_event));
     }
 
+    // the kernel returns the items written so far after idle_cycles cycles
+    // without input (StoWM with idle_cycles), the memory_writer kernel must
+    // take idle_cycles as its last argument
+    void set_flush_timeout(const int idle_cycles)
+    {
+        const cl_int _ic = static_cast<cl_int>(idle_cycles);
+        clCheckError(clSetKernelArg(kernel, idle_argi, sizeof(_ic), &_ic));
+    }
+
+    // bytes of the kernel output buffer holding batch_size items
+    static size_t lines_size(const size_t batch_size)
+    {
+        if constexpr (ENCODE) {
+            return codec_lines<LINE_BITS, CODEC_T>(batch_size) * (LINE_BITS / 8);
+        } else {
+            return batch_size * sizeof(T);
+        }
+    }
+
+    // decodes the items written by the kernel into batch_h
+    void decode(const size_t items_written)
+    {
+        if constexpr (ENCODE) {
+            decode_batch<LINE_BITS, CODEC_T>(buffer_h, items_written, batch_h);
+        }
+    }
+
     void execute(size_t batch_size)
     {
         if (batch_size > max_batch_size) {
@@ -144,14 +238,15 @@ struct StreamDrainerExecution {
 
             batch_size = max_batch_size;
         }
+        batch_items = batch_size;
 
         // TODO: cl_int should be cl_ulong to match the size of "size_t"
-        const cl_int _bs = static_cast<cl_int>(batch_size * sizeof(T));
+        const cl_int _bs = static_cast<cl_int>(lines_size(batch_size));
         clCheckError(clSetKernelArg(kernel, bs_argi, sizeof(_bs), &_bs));
 
         clCheckError(clEnqueueTask(queue, kernel, 0, nullptr, &kernel_event));
 
-        cl_mem buffers[] = {batch_d, items_written_d, *eos_d};
+        cl_mem buffers[] = {batch_d, items_written_d, eos_d};
         clCheckError(clEnqueueMigrateMemObjects(
             queue, 3, buffers,
             CL_MIGRATE_MEM_OBJECT_HOST,
@@ -159,6 +254,19 @@ struct StreamDrainerExecution {
         ));
     }
 
+    static void migrate_callback(cl_event, cl_int, void * data)
+    {
+        ((StreamDrainerExecution *)data)->on_complete();
+    }
+
+    // calls `callback` from a thread of the OpenCL runtime when the batch
+    // launched by execute is in host memory; the callback must not block
+    void notify(std::function<void()> callback)
+    {
+        on_complete = std::move(callback);
+        clCheckError(clSetEventCallback(migrate_event, CL_COMPLETE, &migrate_callback, this));
+    }
+
     void wait()
     {
         clCheckError(clWaitForEvents(1, &migrate_event));
@@ -170,7 +278,7 @@ struct StreamDrainerExecution {
             clCheckError(clGetEventProfilingInfo(migrate_event, CL_PROFILING_COMMAND_START, sizeof(start_time), &start_time, NULL));
             clCheckError(clGetEventProfilingInfo(migrate_event, CL_PROFILING_COMMAND_END, sizeof(end_time), &end_time, NULL));
             const double time = end_time - start_time;
-            const double size = max_batch_size * sizeof(T);
+            const double size = buffer_size;
             const double bw = size / time;
             std::cout << "fx::StreamDrainer (MIGRATE): " << bw << " GB/s" << "(start: " << start_time << ", end: " << end_time << ")" << '\n';
         }
@@ -180,12 +288,16 @@ struct StreamDrainerExecution {
             clCheckError(clGetEventProfilingInfo(kernel_event, CL_PROFILING_COMMAND_START, sizeof(start_time), &start_time, NULL));
             clCheckError(clGetEventProfilingInfo(kernel_event, CL_PROFILING_COMMAND_END, sizeof(end_time), &end_time, NULL));
             const double time = end_time - start_time;
-            const double size = max_batch_size * sizeof(T);
+            const double size = buffer_size;
             const double bw = size / time;
             std::cout << "fx::StreamDrainer (KERNEL): " << bw << " GB/s" << "(start: " << start_time << ", end: " << end_time << ")" << '\n';
         }
         #endif
 
+        if (profile) {
+            device_ns = clTimeEventNS(migrate_event);
+        }
+
         clCheckError(clReleaseEvent(migrate_event));
         clCheckError(clReleaseEvent(kernel_event));
     }
@@ -197,29 +309,39 @@ struct StreamDrainerExecution {
         #if STREAM_DRAINER_USE_HOSTMEM
         cl_event unmap_batch_event;
         cl_event unmap_items_written_event;
-        clCheckError(clEnqueueUnmapMemObject(queue, batch_d, batch_h, 0, nullptr, &unmap_batch_event));
+        cl_event unmap_eos_event;
+        clCheckError(clEnqueueUnmapMemObject(queue, batch_d, buffer_h, 0, nullptr, &unmap_batch_event));
         clCheckError(clEnqueueUnmapMemObject(queue, items_written_d, items_written_h, 0, nullptr, &unmap_items_written_event));
+        clCheckError(clEnqueueUnmapMemObject(queue, eos_d, eos_h, 0, nullptr, &unmap_eos_event));
         // clCheckError(clFinish(queue));
         clCheckError(clReleaseEvent(unmap_batch_event));
         clCheckError(clReleaseEvent(unmap_items_written_event));
+        clCheckError(clReleaseEvent(unmap_eos_event));
         #endif
 
         clCheckError(clReleaseMemObject(batch_d));
         clCheckError(clReleaseMemObject(items_written_d));
+        clCheckError(clReleaseMemObject(eos_d));
         // clCheckError(clReleaseKernel(kernel));
         // clCheckError(clReleaseCommandQueue(queue));
 
         #if !STREAM_DRAINER_USE_HOSTMEM
         free(items_written_h);
-        free(batch_h);
+        free(eos_h);
+        free(buffer_h);
         #endif
+
+        if constexpr (ENCODE) {
+            free(batch_h);
+        }
     }
 };
 
-template <typename T>
+template <typename T, typename CODEC_T = void>
 struct StreamDrainer
 {
-    using ExecutionQueue = std::deque<StreamDrainerExecution<T> *>;
+    using Execution = StreamDrainerExecution<T, CODEC_T>;
+    using ExecutionQueue = std::deque<Execution *>;
 
     OCL & ocl;
     cl_command_queue queue;
@@ -229,8 +351,8 @@ struct StreamDrainer
     size_t replica_id;
     size_t iterations;
 
-    cl_mem eos_d;
-    cl_int * eos;
+    BatchController * controller;
+    std::function<void(const T *, size_t)> latency;
 
     ExecutionQueue ready_queue;
     ExecutionQueue running_queue;
@@ -247,8 +369,8 @@ struct StreamDrainer
     , number_of_buffers(N)
     , replica_id(replica_id)
     , iterations(0)
-    , eos_d(nullptr)
-    , eos(nullptr)
+    , controller(nullptr)
+    , latency()
     , ready_queue()
     , running_queue()
     {
@@ -257,70 +379,21 @@ struct StreamDrainer
                       << batch_size << " -> " << max_batch_size << ")" << '\n';
         }
 
-        cl_int err;
-
-        #if STREAM_DRAINER_USE_HOSTMEM
-        cl_mem_ext_ptr_t eos_ext;
-        eos_ext.flags = XCL_MEM_EXT_HOST_ONLY;
-        eos_ext.obj = NULL;
-        eos_ext.param = 0;
-        eos_d = clCreateBuffer(
-            ocl.context,
-            CL_MEM_READ_WRITE | CL_MEM_EXT_PTR_XILINX,
-            sizeof(cl_int), &eos_ext,
-            &err
-        );
-        clCheckErrorMsg(err, "fx::StreamDrainer: failed to create device buffer (eos_d)");
-        eos = (cl_int *)clEnqueueMapBuffer(
-            queue, eos_d, CL_TRUE,
-            CL_MAP_READ,
-            0, sizeof(cl_int),
-            0, nullptr, nullptr, &err
-        );
-        clCheckErrorMsg(err, "fx::StreamDrainer: failed to map device buffer (eos_d)");
-        eos[0] = 0;
-        clCheckError(clFinish(queue));
-        #else
-        eos = aligned_alloc<cl_int>(1);
-        eos[0] = 0;
-
-        cl_mem_ext_ptr_t eos_ext;
-        eos_ext.obj = eos;
-        eos_ext.param = 0;
-        eos_ext.flags = hbm_bank[31];
-
-        eos_d = clCreateBuffer(
-            ocl.context,
-            CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE | CL_MEM_EXT_PTR_XILINX,
-            sizeof(cl_int), &eos_ext,
-            &err
-        );
-        clCheckErrorMsg(err, "fx::StreamDrainer: failed to create device buffer (eos_d)");
-        #endif
-
-        clCheckError(clEnqueueMigrateMemObjects(
-            queue, 1, &eos_d,
-            0,
-            0, nullptr, nullptr
-        ));
-
-        clCheckError(clFinish(queue));
-
         for (size_t n = 0; n < number_of_buffers; ++n) {
-            ready_queue.push_back(new StreamDrainerExecution<T>(ocl, queue, max_batch_size, &eos_d, replica_id));
+            ready_queue.push_back(new Execution(ocl, queue, max_batch_size, replica_id));
         }
     }
 
     void prelaunch()
     {
         for (size_t n = 0; n < number_of_buffers; ++n) {
-            launch_kernel(max_batch_size);
+            launch_kernel(batch_size());
         }
     }
 
     void launch_kernel(size_t batch_size)
     {
-        StreamDrainerExecution<T> * execution = ready_queue.front();
+        Execution * execution = ready_queue.front();
         ready_queue.pop_front();
         execution->execute(batch_size);
         running_queue.push_back(execution);
@@ -335,13 +408,23 @@ struct StreamDrainer
             return nullptr;
         }
 
-        StreamDrainerExecution<T> * execution = running_queue.front();
+        Execution * execution = running_queue.front();
         running_queue.pop_front();
         execution->wait();
 
         T * batch = execution->batch_h;
         *items_written = execution->items_written_h[0];
-        *last = (eos[0] ? true : false);
+        *last = this->last(execution);
+        execution->decode(*items_written);
+
+        if (latency) {
+            latency(batch, *items_written);
+        }
+
+        if (controller) {
+            controller->completed(execution->batch_items, execution->device_ns);
+            controller->arrived(*items_written);
+        }
 
         ready_queue.push_back(execution);
 
@@ -350,6 +433,12 @@ struct StreamDrainer
         return batch;
     }
 
+    // true if the completed execution read the end of the stream
+    bool last(const Execution * execution) const
+    {
+        return (execution->eos_h[0] ? true : false);
+    }
+
     void put_batch(T * batch, size_t batch_size)
     {
         if (!batch) {
@@ -360,12 +449,54 @@ struct StreamDrainer
         launch_kernel(batch_size);
     }
 
+    // the batch sizes are then chosen by `controller`, see batch_size()
+    void set_controller(BatchController * controller)
+    {
+        this->controller = controller;
+        if (controller) {
+            controller->attach(Execution::GRANULE, max_batch_size);
+        }
+        for (Execution * execution : running_queue) {
+            execution->profile = (controller != nullptr);
+        }
+        for (Execution * execution : ready_queue) {
+            execution->profile = (controller != nullptr);
+        }
+    }
+
+    // records to `tracker` the latency of the results stamped in the field
+    // `stamp` of T
+    template <typename S>
+    void set_latency_tracker(LatencyTracker & tracker, S T::* stamp)
+    {
+        latency = [&tracker, stamp](const T * batch, size_t items) { tracker.record(batch, items, stamp); };
+    }
+
+    // items to request with the next put_batch
+    size_t batch_size() const
+    {
+        return controller ? controller->batch_size() : max_batch_size;
+    }
+
+    // bounds the latency of sparse outputs: an execution completes with the
+    // items received so far once the kernel has been idle for idle_cycles
+    // cycles, so pop may return fewer items than requested, without last
+    void set_flush_timeout(const int idle_cycles)
+    {
+        for (Execution * execution : ready_queue) {
+            execution->set_flush_timeout(idle_cycles);
+        }
+        for (Execution * execution : running_queue) {
+            execution->set_flush_timeout(idle_cycles);
+        }
+    }
+
     void launch_kernels() {}
 
     void finish()
     {
         while (!running_queue.empty()) {
-            StreamDrainerExecution<T> * execution = running_queue.front();
+            Execution * execution = running_queue.front();
             running_queue.pop_front();
             execution->wait();
             ready_queue.push_back(execution);
@@ -377,22 +508,164 @@ struct StreamDrainer
         finish();
 
         while (!ready_queue.empty()) {
-            StreamDrainerExecution<T> * execution = ready_queue.front();
+            Execution * execution = ready_queue.front();
             ready_queue.pop_front();
             delete execution;
         }
 
-        #if STREAM_DRAINER_USE_HOSTMEM
-        clCheckError(clEnqueueUnmapMemObject(queue, eos_d, eos, 0, nullptr, nullptr));
+        clCheckError(clReleaseCommandQueue(queue));
+    }
+};
+
+// Persistent counterpart of StreamDrainer: the memory_writer kernel
+// (StoWM_ring) is launched once and fills a ring of SLOTS batches in host
+// memory. pop waits for the doorbell of the next slot, put_batch gives it
+// back to the kernel; no kernel is launched per batch.
+template <typename T, int SLOTS = 4>
+struct PersistentStreamDrainer
+{
+    using RING = ring_ctrl_t<SLOTS>;
+
+    OCL & ocl;
+    cl_command_queue queue;
+
+    size_t max_batch_size;
+    size_t replica_id;
+    size_t iterations;
+
+    cl_kernel kernel;
+
+    cl_mem ring_d;
+    cl_mem ctrl_d;
+    T * ring_h;
+    cl_int * ctrl_h;
+
+    cl_event kernel_event;
+
+    RingConsumer<T, SLOTS> consumer;
+
+    static constexpr int ring_argi = 1;
+    static constexpr int ctrl_argi = 2;
+    static constexpr int slot_lines_argi = 3;
+
+    PersistentStreamDrainer(
+        OCL & ocl,
+        const size_t batch_size,
+        const size_t replica_id = 0
+    )
+    : ocl(ocl)
+    , queue(ocl.createCommandQueue(true, true))
+    , max_batch_size(next_pow2(batch_size))
+    , replica_id(replica_id)
+    , iterations(0)
+    , kernel_event(nullptr)
+    , consumer(nullptr, nullptr, 0)
+    {
+        if (batch_size != max_batch_size) {
+            std::cout << "fx::PersistentStreamDrainer: `batch_size` is rounded to the next power of 2 ("
+                      << batch_size << " -> " << max_batch_size << ")" << '\n';
+        }
+
+        cl_int err;
+
+        kernel = ocl.createKernel("memory_writer:{memory_writer_" + std::to_string(replica_id) + "}");
+
+        cl_mem_ext_ptr_t host_ext;
+        host_ext.flags = XCL_MEM_EXT_HOST_ONLY;
+        host_ext.obj = NULL;
+        host_ext.param = 0;
+
+        ring_d = clCreateBuffer(
+            ocl.context,
+            CL_MEM_WRITE_ONLY | CL_MEM_EXT_PTR_XILINX | CL_MEM_HOST_READ_ONLY,
+            SLOTS * max_batch_size * sizeof(T), &host_ext,
+            &err
+        );
+        clCheckErrorMsg(err, "fx::PersistentStreamDrainer: failed to create device buffer (ring_d)");
+        ring_h = (T *)clEnqueueMapBuffer(
+            queue, ring_d, CL_TRUE,
+            CL_MAP_READ,
+            0, SLOTS * max_batch_size * sizeof(T),
+            0, nullptr, nullptr, &err
+        );
+        clCheckErrorMsg(err, "fx::PersistentStreamDrainer: failed to map device buffer (ring_d)");
+
+        ctrl_d = clCreateBuffer(
+            ocl.context,
+            CL_MEM_READ_WRITE | CL_MEM_EXT_PTR_XILINX,
+            RING::WORDS * sizeof(cl_int), &host_ext,
+            &err
+        );
+        clCheckErrorMsg(err, "fx::PersistentStreamDrainer: failed to create device buffer (ctrl_d)");
+        ctrl_h = (cl_int *)clEnqueueMapBuffer(
+            queue, ctrl_d, CL_TRUE,
+            CL_MAP_READ | CL_MAP_WRITE,
+            0, RING::WORDS * sizeof(cl_int),
+            0, nullptr, nullptr, &err
+        );
+        clCheckErrorMsg(err, "fx::PersistentStreamDrainer: failed to map device buffer (ctrl_d)");
+        for (int w = 0; w < RING::WORDS; ++w) {
+            ctrl_h[w] = 0;
+        }
         clCheckError(clFinish(queue));
-        #endif
 
-        clCheckError(clReleaseMemObject(eos_d));
-        clCheckError(clReleaseCommandQueue(queue));
+        consumer = RingConsumer<T, SLOTS>(ring_h, ctrl_h, max_batch_size);
 
-        #if !STREAM_DRAINER_USE_HOSTMEM
-        free(eos);
-        #endif
+        const cl_int slot_lines = static_cast<cl_int>(max_batch_size * sizeof(T) / (512 / 8));
+        clCheckError(clSetKernelArg(kernel, ring_argi, sizeof(ring_d), &ring_d));
+        clCheckError(clSetKernelArg(kernel, ctrl_argi, sizeof(ctrl_d), &ctrl_d));
+        clCheckError(clSetKernelArg(kernel, slot_lines_argi, sizeof(slot_lines), &slot_lines));
+
+        clCheckError(clEnqueueTask(queue, kernel, 0, nullptr, &kernel_event));
+    }
+
+    // waits for the next slot written by the kernel
+    T * pop(
+        size_t * items_written,
+        bool * last)
+    {
+        T * batch = consumer.pop(items_written, last);
+        iterations++;
+        return batch;
+    }
+
+    // gives the slot returned by pop back to the kernel
+    void put_batch(T * batch, size_t batch_size)
+    {
+        UNUSED(batch_size);
+
+        if (!batch) {
+            std::cerr << "fx::PersistentStreamDrainer: batch is nullptr" << '\n';
+            return;
+        }
+
+        consumer.put_batch();
+    }
+
+    void launch_kernels() {}
+
+    // waits for the kernel, i.e. for the slot flagged `last`
+    void finish()
+    {
+        if (kernel_event == nullptr) return;
+
+        clCheckError(clWaitForEvents(1, &kernel_event));
+        clCheckError(clReleaseEvent(kernel_event));
+        kernel_event = nullptr;
+    }
+
+    ~PersistentStreamDrainer()
+    {
+        finish();
+
+        clCheckError(clEnqueueUnmapMemObject(queue, ring_d, ring_h, 0, nullptr, nullptr));
+        clCheckError(clEnqueueUnmapMemObject(queue, ctrl_d, ctrl_h, 0, nullptr, nullptr));
+        clCheckError(clFinish(queue));
+
+        clCheckError(clReleaseMemObject(ring_d));
+        clCheckError(clReleaseMemObject(ctrl_d));
+        clCheckError(clReleaseKernel(kernel));
+        clCheckError(clReleaseCommandQueue(queue));
     }
 };
 
@@ -4,31 +4,52 @@
 #include <vector>
 #include <deque>
 #include <string>
+#include <functional>
 
 #include "defines.hpp"
 #include "utils.hpp"
 #include "ocl.hpp"
+#include "codec.hpp"
+#include "ring.hpp"
+#include "batch_slots.hpp"
+#include "batch_controller.hpp"
+#include "latency_tracker.hpp"
+#include "mapped_file.hpp"
 
 
 namespace fx {
 
-template <typename T>
+// With a CODEC_T (a record_codec_t, or a packed_codec_t from packed_codec.hpp)
+// batches are encoded on push into lines of LINE_BITS bits, to be read by
+// WMtoS_codec (WMtoS_packed) in the memory_reader kernel.
+template <typename T, typename CODEC_T = void>
 struct StreamGeneratorExecution
 {
+    static constexpr bool ENCODE = !std::is_void<CODEC_T>::value;
+    static constexpr int LINE_BITS = 512;
+    // batch sizes are multiples of GRANULE items: whole lines unless encoded
+    static constexpr size_t GRANULE = (ENCODE || sizeof(T) >= LINE_BITS / 8) ? 1 : (LINE_BITS / 8) / sizeof(T);
+
     OCL & ocl;
     cl_command_queue & queue;
 
     size_t max_batch_size;
     size_t replica_id;
+    size_t buffer_size;     // bytes read by the kernel
 
     cl_kernel kernel;
 
     cl_mem batch_d;
     T * batch_h;
+    void * buffer_h;        // batch_h itself or the encoded lines
 
     cl_event migrate_event;
     cl_event kernel_event;
 
+    bool profile;           // set device_ns on wait, the queue must profile
+    size_t batch_items;     // items of the last execute
+    double device_ns;       // transfer time of the last batch
+
     const int batch_argi = 0;
     const int count_argi = 1;
     const int eos_argi = 2;
@@ -43,14 +64,24 @@ struct StreamGeneratorExecution
     , queue(queue)
     , max_batch_size(batch_size)
     , replica_id(replica_id)
+    , buffer_size(0)
     , migrate_event(nullptr)
     , kernel_event(nullptr)
+    , profile(false)
+    , batch_items(0)
+    , device_ns(0.0)
     {
         cl_int err;
 
         kernel = ocl.createKernel("memory_reader:{memory_reader_" + std::to_string(replica_id) + "}");
         // queue = ocl.createCommandQueue();
 
+        if constexpr (ENCODE) {
+            buffer_size = codec_lines<LINE_BITS, CODEC_T>(max_batch_size) * (LINE_BITS / 8);
+        } else {
+            buffer_size = max_batch_size * sizeof(T);
+        }
+
         #if STREAM_GENERATOR_USE_HOSTMEM
         cl_mem_ext_ptr_t batch_ext;
         batch_ext.flags = XCL_MEM_EXT_HOST_ONLY;
@@ -59,28 +90,30 @@ struct StreamGeneratorExecution
         batch_d = clCreateBuffer(
             ocl.context,
             CL_MEM_READ_ONLY | CL_MEM_EXT_PTR_XILINX | CL_MEM_HOST_WRITE_ONLY,
-            max_batch_size * sizeof(T), &batch_ext,
+            buffer_size, &batch_ext,
             &err
         );
         clCheckErrorMsg(err, "fx::StreamGenerator: failed to create device buffer (batch_d)");
-        batch_h = (T *)clEnqueueMapBuffer(
+        buffer_h = clEnqueueMapBuffer(
             queue, batch_d, CL_TRUE,
             CL_MAP_WRITE,
-            0, max_batch_size * sizeof(T),
+            0, buffer_size,
             0, nullptr, nullptr, &err
         );
         clCheckErrorMsg(err, "fx::StreamGenerator: failed to map device buffer (batch_d)");
         #else
-        batch_h = aligned_alloc<T>(max_batch_size);
+        buffer_h = aligned_alloc<char>(buffer_size);
         batch_d = clCreateBuffer(
             ocl.context,
             CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR | CL_MEM_HOST_WRITE_ONLY,
-            max_batch_size * sizeof(T), batch_h,
+            buffer_size, buffer_h,
             &err
         );
         clCheckErrorMsg(err, "fx::StreamGenerator: failed to create device buffer (batch_d)");
         #endif
 
+        batch_h = ENCODE ? aligned_alloc<T>(max_batch_size) : (T *)buffer_h;
+
         clCheckError(clSetKernelArg(kernel, batch_argi, sizeof(batch_d), &batch_d));
         clCheckError(clEnqueueMigrateMemObjects(
             queue, 1, &batch_d,
@@ -92,9 +125,13 @@ struct StreamGeneratorExecution
         clCheckError(clReleaseEvent(migrate_event));
     }
 
+    // With `after`, the kernel starts after the event *after, which is then
+    // replaced by the kernel event: the batches of a chain of executions reach
+    // the kernel in order even on an out-of-order queue.
     void execute(
         size_t batch_size,
-        bool eos
+        bool eos,
+        cl_event * after = nullptr
     )
     {
         if (batch_size > max_batch_size) {
@@ -105,9 +142,17 @@ struct StreamGeneratorExecution
 
             batch_size = max_batch_size;
         }
-
-        // TODO: (512 / 8) should be calculated at runtime based on the width of the bus selected for the memory reader
-        const cl_int count_int = static_cast<cl_int>(batch_size / ((512 / 8) / sizeof(T)));
+        batch_items = batch_size;
+
+        cl_int count_int = 0;
+        if constexpr (ENCODE) {
+            // WMtoS_codec/WMtoS_packed count items, the last line may be partially filled
+            encode_batch<LINE_BITS, CODEC_T>(batch_h, batch_size, buffer_h);
+            count_int = static_cast<cl_int>(batch_size);
+        } else {
+            // TODO: (512 / 8) should be calculated at runtime based on the width of the bus selected for the memory reader
+            count_int = static_cast<cl_int>(batch_size / ((512 / 8) / sizeof(T)));
+        }
         const cl_int eos_int = static_cast<cl_int>(eos);
 
         clCheckError(clSetKernelArg(kernel, count_argi, sizeof(count_int), &count_int));
@@ -119,7 +164,31 @@ struct StreamGeneratorExecution
             0, nullptr, &migrate_event
         ));
 
-        clCheckError(clEnqueueTask(queue, kernel, 1, &migrate_event, &kernel_event));
+        if (after != nullptr && *after != nullptr) {
+            cl_event wait_list[] = {migrate_event, *after};
+            clCheckError(clEnqueueTask(queue, kernel, 2, wait_list, &kernel_event));
+            clCheckError(clReleaseEvent(*after));
+        } else {
+            clCheckError(clEnqueueTask(queue, kernel, 1, &migrate_event, &kernel_event));
+        }
+
+        if (after != nullptr) {
+            clCheckError(clRetainEvent(kernel_event));
+            *after = kernel_event;
+        }
+    }
+
+    // true if no kernel is pending on the batch
+    bool done()
+    {
+        if (kernel_event == nullptr) return true;
+
+        cl_int status;
+        clCheckError(clGetEventInfo(
+            kernel_event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+            sizeof(status), &status, nullptr
+        ));
+        return status == CL_COMPLETE;
     }
 
     T * get_batch_ptr()
@@ -147,7 +216,7 @@ struct StreamGeneratorExecution
             clCheckError(clGetEventProfilingInfo(migrate_event, CL_PROFILING_COMMAND_START, sizeof(start_time), &start_time, NULL));
             clCheckError(clGetEventProfilingInfo(migrate_event, CL_PROFILING_COMMAND_END, sizeof(end_time), &end_time, NULL));
             const double time = end_time - start_time;
-            const double size = max_batch_size * sizeof(T);
+            const double size = buffer_size;
             const double bw = size / time;
             std::cout << "fx::SteramGenerator (MIGRATE)" << bw << " GB/s" << "(start: " << start_time << ", end: " << end_time << ")" << '\n';
         }
@@ -158,14 +227,20 @@ struct StreamGeneratorExecution
             clCheckError(clGetEventProfilingInfo(kernel_event, CL_PROFILING_COMMAND_START, sizeof(start_time), &start_time, NULL));
             clCheckError(clGetEventProfilingInfo(kernel_event, CL_PROFILING_COMMAND_END, sizeof(end_time), &end_time, NULL));
             const double time = end_time - start_time;
-            const double size = max_batch_size * sizeof(T);
+            const double size = buffer_size;
             const double bw = size / time;
             std::cout << "fx::SteramGenerator (KERNEL): " << bw << " GB/s" << "(start: " << start_time << ", end: " << end_time << ")" << '\n';
         }
         #endif
 
+        if (profile) {
+            device_ns = clTimeEventNS(migrate_event);
+        }
+
         clCheckError(clReleaseEvent(kernel_event));
         clCheckError(clReleaseEvent(migrate_event));
+        kernel_event = nullptr;
+        migrate_event = nullptr;
     }
 
     ~StreamGeneratorExecution()
@@ -174,7 +249,7 @@ struct StreamGeneratorExecution
 
         #if STREAM_GENERATOR_USE_HOSTMEM
         cl_event unmap_event;
-        clCheckError(clEnqueueUnmapMemObject(queue, batch_d, batch_h, 0, nullptr, &unmap_event));
+        clCheckError(clEnqueueUnmapMemObject(queue, batch_d, buffer_h, 0, nullptr, &unmap_event));
         clCheckError(clWaitForEvents(1, &unmap_event));
         // clCheckError(clFinish(queue));
         #endif
@@ -184,15 +259,20 @@ struct StreamGeneratorExecution
         // clCheckError(clReleaseCommandQueue(queue));
 
         #if !STREAM_GENERATOR_USE_HOSTMEM
-        free(batch_h);
+        free(buffer_h);
         #endif
+
+        if constexpr (ENCODE) {
+            free(batch_h);
+        }
     }
 };
 
-template <typename T>
+template <typename T, typename CODEC_T = void>
 struct StreamGenerator
 {
-    using ExecutionQueue = std::deque<StreamGeneratorExecution<T> *>;
+    using Execution = StreamGeneratorExecution<T, CODEC_T>;
+    using ExecutionQueue = std::deque<Execution *>;
 
     OCL & ocl;
     cl_command_queue queue;
@@ -202,6 +282,9 @@ struct StreamGenerator
     size_t replica_id;
     size_t iterations;
 
+    BatchController * controller;
+    std::function<void(T *, size_t)> latency;
+
     ExecutionQueue ready_queue;
     ExecutionQueue running_queue;
 
@@ -217,6 +300,8 @@ struct StreamGenerator
     , number_of_buffers(N)
     , replica_id(replica_id)
     , iterations(0)
+    , controller(nullptr)
+    , latency()
     , ready_queue()
     , running_queue()
     {
@@ -226,17 +311,20 @@ struct StreamGenerator
         }
 
         for (size_t n = 0; n < number_of_buffers; ++n) {
-            running_queue.push_back(new StreamGeneratorExecution<T>(ocl, queue, max_batch_size, replica_id));
+            running_queue.push_back(new Execution(ocl, queue, max_batch_size, replica_id));
         }
     }
 
     T * get_batch()
     {
-        StreamGeneratorExecution<T> * execution = running_queue.front();
+        Execution * execution = running_queue.front();
         running_queue.pop_front();
 
         if (iterations >= number_of_buffers) {
             execution->wait();
+            if (controller) {
+                controller->completed(execution->batch_items, execution->device_ns);
+            }
         }
 
         T * batch = execution->get_batch();
@@ -251,25 +339,61 @@ struct StreamGenerator
         const bool last = false
     )
     {
-        StreamGeneratorExecution<T> * execution = ready_queue.front();
+        Execution * execution = ready_queue.front();
         ready_queue.pop_front();
 
         if (batch != execution->get_batch_ptr()) {
             std::cerr << "fx::StreamGenerator: batch pointer mismatch!" << '\n';
         }
 
+        if (latency) {
+            latency(batch, batch_size);
+        }
+
         execution->execute(batch_size, last);
         running_queue.push_back(execution);
 
+        if (controller) {
+            controller->arrived(batch_size);
+        }
+
         iterations++;
     }
 
+    // the batch sizes are then chosen by `controller`, see batch_size()
+    void set_controller(BatchController * controller)
+    {
+        this->controller = controller;
+        if (controller) {
+            controller->attach(Execution::GRANULE, max_batch_size);
+        }
+        for (Execution * execution : running_queue) {
+            execution->profile = (controller != nullptr);
+        }
+        for (Execution * execution : ready_queue) {
+            execution->profile = (controller != nullptr);
+        }
+    }
+
+    // stamps the tuples pushed for `tracker`, in the field `stamp` of T
+    template <typename S>
+    void set_latency_tracker(LatencyTracker & tracker, S T::* stamp)
+    {
+        latency = [&tracker, stamp](T * batch, size_t items) { tracker.stamp(batch, items, stamp); };
+    }
+
+    // items to push in the next batch
+    size_t batch_size() const
+    {
+        return controller ? controller->batch_size() : max_batch_size;
+    }
+
     void launch_kernels() {}
 
     void finish()
     {
         while (!running_queue.empty()) {
-            StreamGeneratorExecution<T> * execution = running_queue.front();
+            Execution * execution = running_queue.front();
             running_queue.pop_front();
             execution->wait();
             ready_queue.push_back(execution);
@@ -281,7 +405,7 @@ struct StreamGenerator
         finish();
 
         while (!ready_queue.empty()) {
-            StreamGeneratorExecution<T> * execution = ready_queue.front();
+            Execution * execution = ready_queue.front();
             ready_queue.pop_front();
             delete execution;
         }
@@ -290,6 +414,516 @@ struct StreamGenerator
     }
 };
 
+// Thread-safe counterpart of StreamGenerator: any number of producer threads
+// acquire a batch, fill it and push it concurrently. The batch belongs to the
+// producer from acquire to push; acquire never blocks on the other producers,
+// it only waits for a free buffer. Batches reach the kernel in the order they
+// were acquired (IN_ORDER) or pushed (OUT_OF_ORDER), since the kernels are
+// chained on their events. Pushing 0 items gives the batch back. The batch
+// pushed with `last` must be the last one: with IN_ORDER the last acquired,
+// with OUT_OF_ORDER pushed after the other producers are done. Use one
+// generator per replica to feed several replicas.
+template <typename T, typename CODEC_T = void>
+struct ConcurrentStreamGenerator
+{
+    using Execution = StreamGeneratorExecution<T, CODEC_T>;
+
+    struct Batch
+    {
+        T * data;
+        size_t slot;
+    };
+
+    OCL & ocl;
+    cl_command_queue queue;
+
+    size_t max_batch_size;
+    size_t number_of_buffers;
+    size_t replica_id;
+
+    std::vector<Execution *> executions;
+    BatchSlots slots;
+    cl_event last_kernel_event;     // end of the chain, owned by the turn
+
+    ConcurrentStreamGenerator(
+        OCL & ocl,
+        const size_t batch_size,
+        const size_t N = 4,
+        const size_t replica_id = 0,
+        const BatchOrder order = IN_ORDER
+    )
+    : ocl(ocl)
+    , queue(ocl.createCommandQueue(COMMAND_QUEUE_PROFILE, true))
+    , max_batch_size(next_pow2(batch_size))
+    , number_of_buffers(N)
+    , replica_id(replica_id)
+    , executions()
+    , slots(N, order)
+    , last_kernel_event(nullptr)
+    {
+        if (batch_size != max_batch_size) {
+            std::cout << "fx::ConcurrentStreamGenerator: `batch_size` is rounded to the next power of 2 ("
+                      << batch_size << " -> " << max_batch_size << ")" << '\n';
+        }
+
+        for (size_t n = 0; n < number_of_buffers; ++n) {
+            executions.push_back(new Execution(ocl, queue, max_batch_size, replica_id));
+        }
+    }
+
+    // thread-safe, waits for a free buffer
+    Batch acquire()
+    {
+        const size_t s = slots.acquire([this](const size_t i) {
+            return executions[i]->done();
+        });
+        executions[s]->wait();
+
+        return Batch{executions[s]->get_batch(), s};
+    }
+
+    // thread-safe, waits for the batches that come first
+    void push(
+        Batch & batch,
+        const size_t batch_size,
+        const bool last = false
+    )
+    {
+        if (batch.slot >= number_of_buffers || batch.data != executions[batch.slot]->get_batch_ptr()) {
+            // the slot of the batch is unknown and cannot be given back:
+            // the producers waiting for its turn would spin forever
+            std::cerr << "fx::ConcurrentStreamGenerator: batch not acquired from this generator!" << '\n';
+            exit(EXIT_FAILURE);
+        }
+
+        slots.wait_turn(batch.slot);
+        if (batch_size == 0 && !last) {
+            slots.cancel(batch.slot);
+        } else {
+            executions[batch.slot]->execute(batch_size, last, &last_kernel_event);
+            slots.submitted(batch.slot);
+        }
+
+        batch.data = nullptr;
+    }
+
+    void launch_kernels() {}
+
+    // waits for the batches pushed so far
+    void finish()
+    {
+        slots.drain();
+
+        for (size_t s = 0; s < number_of_buffers; ++s) {
+            if (slots.running(s)) {
+                executions[s]->wait();
+                slots.release(s);
+            }
+        }
+    }
+
+    ~ConcurrentStreamGenerator()
+    {
+        finish();
+
+        for (Execution * execution : executions) {
+            delete execution;
+        }
+
+        if (last_kernel_event != nullptr) {
+            clCheckError(clReleaseEvent(last_kernel_event));
+        }
+        clCheckError(clReleaseCommandQueue(queue));
+    }
+};
+
+// Persistent counterpart of StreamGenerator: the memory_reader kernel
+// (WMtoS_ring) is launched once and polls a ring of SLOTS batches in host
+// memory, so pushing a batch costs a doorbell write instead of a migration and
+// a kernel launch. The kernel returns after the batch pushed with `last`.
+template <typename T, int SLOTS = 4>
+struct PersistentStreamGenerator
+{
+    using RING = ring_ctrl_t<SLOTS>;
+
+    OCL & ocl;
+    cl_command_queue queue;
+
+    size_t max_batch_size;
+    size_t replica_id;
+
+    cl_kernel kernel;
+
+    cl_mem ring_d;
+    cl_mem ctrl_d;
+    T * ring_h;
+    cl_int * ctrl_h;
+
+    cl_event kernel_event;
+
+    RingProducer<T, SLOTS> producer;
+
+    const int ring_argi = 0;
+    const int ctrl_argi = 1;
+    const int slot_lines_argi = 2;
+
+    PersistentStreamGenerator(
+        OCL & ocl,
+        const size_t batch_size,
+        const size_t replica_id = 0
+    )
+    : ocl(ocl)
+    , queue(ocl.createCommandQueue(true, true))
+    , max_batch_size(next_pow2(batch_size))
+    , replica_id(replica_id)
+    , kernel_event(nullptr)
+    , producer(nullptr, nullptr, 0)
+    {
+        if (batch_size != max_batch_size) {
+            std::cout << "fx::PersistentStreamGenerator: `batch_size` is rounded to the next power of 2 ("
+                      << batch_size << " -> " << max_batch_size << ")" << '\n';
+        }
+
+        cl_int err;
+
+        kernel = ocl.createKernel("memory_reader:{memory_reader_" + std::to_string(replica_id) + "}");
+
+        cl_mem_ext_ptr_t host_ext;
+        host_ext.flags = XCL_MEM_EXT_HOST_ONLY;
+        host_ext.obj = NULL;
+        host_ext.param = 0;
+
+        ring_d = clCreateBuffer(
+            ocl.context,
+            CL_MEM_READ_ONLY | CL_MEM_EXT_PTR_XILINX | CL_MEM_HOST_WRITE_ONLY,
+            SLOTS * max_batch_size * sizeof(T), &host_ext,
+            &err
+        );
+        clCheckErrorMsg(err, "fx::PersistentStreamGenerator: failed to create device buffer (ring_d)");
+        ring_h = (T *)clEnqueueMapBuffer(
+            queue, ring_d, CL_TRUE,
+            CL_MAP_WRITE,
+            0, SLOTS * max_batch_size * sizeof(T),
+            0, nullptr, nullptr, &err
+        );
+        clCheckErrorMsg(err, "fx::PersistentStreamGenerator: failed to map device buffer (ring_d)");
+
+        ctrl_d = clCreateBuffer(
+            ocl.context,
+            CL_MEM_READ_WRITE | CL_MEM_EXT_PTR_XILINX,
+            RING::WORDS * sizeof(cl_int), &host_ext,
+            &err
+        );
+        clCheckErrorMsg(err, "fx::PersistentStreamGenerator: failed to create device buffer (ctrl_d)");
+        ctrl_h = (cl_int *)clEnqueueMapBuffer(
+            queue, ctrl_d, CL_TRUE,
+            CL_MAP_READ | CL_MAP_WRITE,
+            0, RING::WORDS * sizeof(cl_int),
+            0, nullptr, nullptr, &err
+        );
+        clCheckErrorMsg(err, "fx::PersistentStreamGenerator: failed to map device buffer (ctrl_d)");
+        for (int w = 0; w < RING::WORDS; ++w) {
+            ctrl_h[w] = 0;
+        }
+        clCheckError(clFinish(queue));
+
+        producer = RingProducer<T, SLOTS>(ring_h, ctrl_h, max_batch_size);
+
+        // TODO: (512 / 8) should be calculated at runtime based on the width of the bus selected for the memory reader
+        const cl_int slot_lines = static_cast<cl_int>(max_batch_size * sizeof(T) / (512 / 8));
+        clCheckError(clSetKernelArg(kernel, ring_argi, sizeof(ring_d), &ring_d));
+        clCheckError(clSetKernelArg(kernel, ctrl_argi, sizeof(ctrl_d), &ctrl_d));
+        clCheckError(clSetKernelArg(kernel, slot_lines_argi, sizeof(slot_lines), &slot_lines));
+
+        clCheckError(clEnqueueTask(queue, kernel, 0, nullptr, &kernel_event));
+    }
+
+    // waits for a free slot of the ring
+    T * get_batch()
+    {
+        return producer.get_batch();
+    }
+
+    void push(
+        T * batch,
+        const size_t batch_size,
+        const bool last = false
+    )
+    {
+        if (batch != ring_h + RING::slot(producer.head) * max_batch_size) {
+            std::cerr << "fx::PersistentStreamGenerator: batch pointer mismatch!" << '\n';
+        }
+
+        size_t size = batch_size;
+        if (size > max_batch_size) {
+            std::cerr
+                << "fx::PersistentStreamGenerator: batch_size is larger than max_batch_size!"
+                << "Only " << max_batch_size << " elements are processed."
+                << '\n';
+
+            size = max_batch_size;
+        }
+
+        // TODO: (512 / 8) should be calculated at runtime based on the width of the bus selected for the memory reader
+        const size_t line_items = (512 / 8) / sizeof(T);
+        if (size % line_items != 0) {
+            std::cerr
+                << "fx::PersistentStreamGenerator: batch_size is not a multiple of the items in a line (" << line_items << ")! "
+                << "Only " << (size - size % line_items) << " elements are processed."
+                << '\n';
+        }
+
+        producer.push(static_cast<int>(size / line_items), last);
+    }
+
+    void launch_kernels() {}
+
+    // waits for the kernel, i.e. for the batch pushed with `last`
+    void finish()
+    {
+        if (kernel_event == nullptr) return;
+
+        clCheckError(clWaitForEvents(1, &kernel_event));
+        clCheckError(clReleaseEvent(kernel_event));
+        kernel_event = nullptr;
+    }
+
+    ~PersistentStreamGenerator()
+    {
+        finish();
+
+        clCheckError(clEnqueueUnmapMemObject(queue, ring_d, ring_h, 0, nullptr, nullptr));
+        clCheckError(clEnqueueUnmapMemObject(queue, ctrl_d, ctrl_h, 0, nullptr, nullptr));
+        clCheckError(clFinish(queue));
+
+        clCheckError(clReleaseMemObject(ring_d));
+        clCheckError(clReleaseMemObject(ctrl_d));
+        clCheckError(clReleaseKernel(kernel));
+        clCheckError(clReleaseCommandQueue(queue));
+    }
+};
+
+
+// Zero-copy counterpart of StreamGenerator for a MappedFile: every batch is a
+// window of the mapping registered as a CL_MEM_USE_HOST_PTR buffer, so the
+// kernel reads the tuples where the file is mapped and the host copies
+// nothing. The next `readahead` batches are read in the background and the
+// pages of the completed ones are released. The file is pushed `loops` times,
+// eos with its last batch; the tuples after the last whole 512-bit line are
+// skipped, and with nothing to push a single empty batch carries the eos. Batches should be page aligned (batch_size * sizeof(T) a multiple
+// of 4 KiB), or the runtime may copy them.
+template <typename T>
+struct FileStreamGenerator
+{
+    struct Slot
+    {
+        cl_kernel kernel;
+        cl_mem batch_d;
+        cl_event migrate_event;
+        cl_event kernel_event;
+        size_t end;             // offset in the file after the batch
+        size_t loop;            // loop of the batch
+    };
+
+    OCL & ocl;
+    cl_command_queue queue;
+    MappedFile<T> & file;
+
+    size_t max_batch_size;
+    size_t number_of_buffers;
+    size_t replica_id;
+    size_t readahead;
+    size_t loops;
+    size_t iterations;
+
+    size_t line_items;          // tuples in a 512-bit line
+    size_t file_items;          // tuples pushed per loop
+    size_t offset;              // next tuple of the file
+    size_t loop;
+    bool ended;
+
+    std::vector<Slot> slots;
+    cl_event last_kernel_event;     // kernel of the last batch pushed
+
+    const int batch_argi = 0;
+    const int count_argi = 1;
+    const int eos_argi = 2;
+
+    FileStreamGenerator(
+        OCL & ocl,
+        MappedFile<T> & file,
+        const size_t batch_size,
+        const size_t N = 2,
+        const size_t replica_id = 0,
+        const size_t readahead = 4,
+        const size_t loops = 1
+    )
+    : ocl(ocl)
+    , queue(ocl.createCommandQueue(true, true))
+    , file(file)
+    , max_batch_size(next_pow2(batch_size))
+    , number_of_buffers(N)
+    , replica_id(replica_id)
+    , readahead(readahead)
+    , loops(loops)
+    , iterations(0)
+    , line_items(((512 / 8) / sizeof(T)) ? ((512 / 8) / sizeof(T)) : 1)
+    , file_items(0)
+    , offset(0)
+    , loop(0)
+    , ended(false)
+    , slots(N)
+    , last_kernel_event(nullptr)
+    {
+        if (batch_size != max_batch_size) {
+            std::cout << "fx::FileStreamGenerator: `batch_size` is rounded to the next power of 2 ("
+                      << batch_size << " -> " << max_batch_size << ")" << '\n';
+        }
+
+        if ((max_batch_size * sizeof(T)) % 4096 != 0) {
+            std::cerr << "fx::FileStreamGenerator: batches are not page aligned, "
+                      << "the runtime may copy them" << '\n';
+        }
+
+        file_items = file.size() / line_items * line_items;
+        if (file_items != file.size()) {
+            std::cerr << "fx::FileStreamGenerator: the last " << (file.size() - file_items)
+                      << " tuples do not fill a line and are skipped" << '\n';
+        }
+        if (file_items == 0 || loops == 0) {
+            std::cerr << "fx::FileStreamGenerator: nothing to push, only the eos is sent" << '\n';
+            file_items = 0;
+            this->loops = 1;
+        }
+
+        for (Slot & slot : slots) {
+            slot.kernel = ocl.createKernel("memory_reader:{memory_reader_" + std::to_string(replica_id) + "}");
+            slot.batch_d = nullptr;
+            slot.migrate_event = nullptr;
+            slot.kernel_event = nullptr;
+            slot.end = 0;
+            slot.loop = 0;
+        }
+
+        file.advise(0, readahead * max_batch_size);
+    }
+
+    // pushes the next batch of the file, false once the last one is pushed
+    bool next()
+    {
+        if (ended) return false;
+
+        Slot & slot = slots[iterations % number_of_buffers];
+        wait(slot);
+
+        const size_t size = std::min(max_batch_size, file_items - offset);
+        const bool last = (offset + size == file_items) && (loop + 1 == loops);
+
+        // an empty batch (the eos alone) cannot wrap the mapping, a buffer
+        // cannot be empty: it gets a line of its own that is never read
+        cl_int err;
+        if (size > 0) {
+            slot.batch_d = clCreateBuffer(
+                ocl.context,
+                CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR | CL_MEM_HOST_NO_ACCESS,
+                size * sizeof(T), file.data + offset,
+                &err
+            );
+        } else {
+            slot.batch_d = clCreateBuffer(
+                ocl.context,
+                CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS,
+                line_items * sizeof(T), nullptr,
+                &err
+            );
+        }
+        clCheckErrorMsg(err, "fx::FileStreamGenerator: failed to create device buffer (batch_d)");
+
+        const cl_int count_int = static_cast<cl_int>(size / line_items);
+        const cl_int eos_int = static_cast<cl_int>(last);
+        clCheckError(clSetKernelArg(slot.kernel, batch_argi, sizeof(slot.batch_d), &slot.batch_d));
+        clCheckError(clSetKernelArg(slot.kernel, count_argi, sizeof(count_int), &count_int));
+        clCheckError(clSetKernelArg(slot.kernel, eos_argi,   sizeof(eos_int),   &eos_int));
+
+        clCheckError(clEnqueueMigrateMemObjects(
+            queue,
+            1, &slot.batch_d, 0,
+            0, nullptr, &slot.migrate_event
+        ));
+
+        // the queue is out of order: every kernel waits for the previous one,
+        // so the batches (and the eos of the last one) reach the kernel in order
+        if (last_kernel_event != nullptr) {
+            cl_event wait_list[] = {slot.migrate_event, last_kernel_event};
+            clCheckError(clEnqueueTask(queue, slot.kernel, 2, wait_list, &slot.kernel_event));
+            clCheckError(clReleaseEvent(last_kernel_event));
+        } else {
+            clCheckError(clEnqueueTask(queue, slot.kernel, 1, &slot.migrate_event, &slot.kernel_event));
+        }
+        clCheckError(clRetainEvent(slot.kernel_event));
+        last_kernel_event = slot.kernel_event;
+
+        offset += size;
+        slot.end = offset;
+        slot.loop = loop;
+        ended = last;
+        if (!last) {
+            if (offset == file_items) {
+                offset = 0;
+                loop++;
+                file.rewind();
+            }
+            file.advise(offset, readahead * max_batch_size);
+        }
+        iterations++;
+
+        return true;
+    }
+
+    // waits for the batch of the slot and releases its buffer and pages; the
+    // batches of a previous loop release nothing, their pages are the ones
+    // the current loop reads or will read
+    void wait(Slot & slot)
+    {
+        if (slot.kernel_event == nullptr) return;
+
+        clCheckError(clWaitForEvents(1, &slot.kernel_event));
+        clCheckError(clReleaseEvent(slot.kernel_event));
+        clCheckError(clReleaseEvent(slot.migrate_event));
+        clCheckError(clReleaseMemObject(slot.batch_d));
+        slot.kernel_event = nullptr;
+        slot.migrate_event = nullptr;
+        slot.batch_d = nullptr;
+
+        if (slot.loop == loop) {
+            file.release(slot.end);
+        }
+    }
+
+    void launch_kernels() {}
+
+    void finish()
+    {
+        for (size_t n = 0; n < number_of_buffers; ++n) {
+            wait(slots[(iterations + n) % number_of_buffers]);
+        }
+    }
+
+    ~FileStreamGenerator()
+    {
+        finish();
+
+        for (Slot & slot : slots) {
+            clCheckError(clReleaseKernel(slot.kernel));
+        }
+
+        if (last_kernel_event != nullptr) {
+            clCheckError(clReleaseEvent(last_kernel_event));
+        }
+        clCheckError(clReleaseCommandQueue(queue));
+    }
+};
+
 } // namespace fx
 
 #endif // __STREAM_GENERATOR__
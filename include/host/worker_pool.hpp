@@ -0,0 +1,81 @@
+#ifndef __HOST_WORKER_POOL__
+#define __HOST_WORKER_POOL__
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+
+namespace fx {
+
+// Fixed pool of threads running the submitted tasks in FIFO order; the
+// destructor runs the tasks still queued and joins the threads.
+struct WorkerPool
+{
+    std::deque< std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop;
+    std::vector<std::thread> workers;
+
+    WorkerPool(const size_t size = 1)
+    : stop(false)
+    {
+        for (size_t w = 0; w < (size ? size : 1); ++w) {
+            workers.emplace_back([this]() { run(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool & operator=(const WorkerPool &) = delete;
+
+    void run()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]() { return stop || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+    size_t size() const
+    {
+        return workers.size();
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto & w : workers) {
+            w.join();
+        }
+    }
+};
+
+}
+
+#endif // __HOST_WORKER_POOL__
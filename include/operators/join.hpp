@@ -0,0 +1,703 @@
+#ifndef __JOIN_HPP__
+#define __JOIN_HPP__
+
+#include "ap_int.h"
+#include "../common.hpp"
+#include "../streams/streams.hpp"
+#include "../connectors/generic.hpp"
+#include "../datastructures/hash.hpp"
+#include "flatmap.hpp"
+
+
+namespace fx {
+
+template <typename T_LEFT, typename T_RIGHT>
+struct join_item_t
+{
+    T_LEFT left;
+    T_RIGHT right;
+    bool is_left;
+};
+
+// Merges the two sides by timestamp (the left side first on ties), so that
+// the join sees the tuples in the same order whatever the rate of the two
+// inputs. A tuple is forwarded once the other side has a tuple with a later
+// timestamp or has ended.
+template <
+    typename STREAM_LEFT,
+    typename STREAM_RIGHT,
+    typename STREAM_OUT
+>
+void join_merge(
+    STREAM_LEFT & lstrm,
+    STREAM_RIGHT & rstrm,
+    STREAM_OUT & ostrm
+)
+{
+    using T_LEFT = typename STREAM_LEFT::data_t;
+    using T_RIGHT = typename STREAM_RIGHT::data_t;
+    using T_ITEM = typename STREAM_OUT::data_t;
+
+    T_LEFT head_l;
+    T_RIGHT head_r;
+    bool valid_l = false;
+    bool valid_r = false;
+
+    bool last_l = lstrm.read_eos();
+    bool last_r = rstrm.read_eos();
+
+JOIN_MERGE:
+    while (!last_l || !last_r || valid_l || valid_r) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+
+        if (!valid_l && !last_l && !lstrm.empty() && !lstrm.empty_eos()) {
+            head_l = lstrm.read();
+            last_l = lstrm.read_eos();
+            valid_l = true;
+        }
+
+        if (!valid_r && !last_r && !rstrm.empty() && !rstrm.empty_eos()) {
+            head_r = rstrm.read();
+            last_r = rstrm.read_eos();
+            valid_r = true;
+        }
+
+        const bool emit_l = valid_l && (valid_r ? (head_l.timestamp <= head_r.timestamp) : last_r);
+        const bool emit_r = valid_r && !emit_l && (valid_l || last_l);
+
+        T_ITEM item;
+        if (emit_l) {
+            item.left = head_l;
+            item.is_left = true;
+            ostrm.write(item);
+            valid_l = false;
+        } else if (emit_r) {
+            item.right = head_r;
+            item.is_left = false;
+            ostrm.write(item);
+            valid_r = false;
+        }
+    }
+
+    ostrm.write_eos();
+}
+
+
+// Keeps, for every key, the last BUFFER tuples of each side. A left tuple `l`
+// matches a right tuple `r` with the same key when
+//     l.timestamp + LOWER <= r.timestamp <= l.timestamp + UPPER
+// Entries that can no longer match (the opposite side has moved past their
+// bound) are expired and their slot is not probed anymore. Both inputs are
+// expected to be ordered by timestamp and are interleaved by join_merge, so
+// the oldest entry of a key, the one overwritten when its ring is full, can
+// no longer match as long as the key has at most BUFFER tuples per side
+// within UPPER (left) or -LOWER (right) of the current timestamp.
+template <
+    typename T_LEFT,
+    typename T_RIGHT,
+    unsigned int KEYS,
+    unsigned int BUFFER,
+    int LOWER,
+    int UPPER
+>
+struct _keyed_interval_join_t
+{
+    HW_STATIC_ASSERT(LOWER <= UPPER, "FX: KeyedIntervalJoin requires LOWER <= UPPER");
+
+    using KEY_T   = unsigned int;
+    using TIME_T  = unsigned int;
+    using IDX_T   = unsigned int;
+    using BOUND_T = long long;
+    using MASK_T  = ap_uint<BUFFER>;
+
+    bool is_initialized[KEYS];
+    T_LEFT left[BUFFER][KEYS];
+    T_RIGHT right[BUFFER][KEYS];
+    MASK_T left_valid[KEYS];
+    MASK_T right_valid[KEYS];
+    IDX_T left_head[KEYS];
+    IDX_T right_head[KEYS];
+    TIME_T left_max_timestamp[KEYS];
+    TIME_T right_max_timestamp[KEYS];
+
+    KEY_T curr_key;
+    T_LEFT curr_left[BUFFER];
+    T_RIGHT curr_right[BUFFER];
+    MASK_T curr_left_valid;
+    MASK_T curr_right_valid;
+    IDX_T curr_left_head;
+    IDX_T curr_right_head;
+    TIME_T curr_left_max_timestamp;
+    TIME_T curr_right_max_timestamp;
+
+    _keyed_interval_join_t()
+    : curr_key(-1)
+    , curr_left_valid(0)
+    , curr_right_valid(0)
+    , curr_left_head(0)
+    , curr_right_head(0)
+    , curr_left_max_timestamp(0)
+    , curr_right_max_timestamp(0)
+    {
+        #pragma HLS array_partition variable=is_initialized      type=complete
+        #pragma HLS array_partition variable=left_valid          type=complete
+        #pragma HLS array_partition variable=right_valid         type=complete
+        #pragma HLS array_partition variable=left_head           type=complete
+        #pragma HLS array_partition variable=right_head          type=complete
+        #pragma HLS array_partition variable=left_max_timestamp  type=complete
+        #pragma HLS array_partition variable=right_max_timestamp type=complete
+
+        #pragma HLS bind_storage    variable=left                type=RAM_S2P  impl=BRAM
+        #pragma HLS array_partition variable=left                type=complete dim=1
+        #pragma HLS bind_storage    variable=right               type=RAM_S2P  impl=BRAM
+        #pragma HLS array_partition variable=right               type=complete dim=1
+
+        #pragma HLS array_partition variable=curr_left           type=complete
+        #pragma HLS array_partition variable=curr_right          type=complete
+
+        KEYED_INTERVAL_JOIN_INIT:
+        for (KEY_T k = 0; k < KEYS; ++k) {
+        #pragma HLS UNROLL
+            is_initialized[k] = false;
+        }
+    }
+
+    static bool left_expired(const TIME_T timestamp, const TIME_T right_max_timestamp)
+    {
+    #pragma HLS INLINE
+        return BOUND_T(timestamp) + UPPER < BOUND_T(right_max_timestamp);
+    }
+
+    static bool right_expired(const TIME_T timestamp, const TIME_T left_max_timestamp)
+    {
+    #pragma HLS INLINE
+        return BOUND_T(timestamp) - LOWER < BOUND_T(left_max_timestamp);
+    }
+
+    static IDX_T next(const IDX_T idx)
+    {
+    #pragma HLS INLINE
+        return (idx + 1 == BUFFER) ? 0 : (idx + 1);
+    }
+
+    void switch_key(const KEY_T key)
+    {
+    #pragma HLS INLINE
+        if (curr_key != KEY_T(-1)) {
+            // store values for old key
+            is_initialized[curr_key]      = true;
+            left_valid[curr_key]          = curr_left_valid;
+            right_valid[curr_key]         = curr_right_valid;
+            left_head[curr_key]           = curr_left_head;
+            right_head[curr_key]          = curr_right_head;
+            left_max_timestamp[curr_key]  = curr_left_max_timestamp;
+            right_max_timestamp[curr_key] = curr_right_max_timestamp;
+
+            SWITCH_KEY_STORE:
+            for (IDX_T i = 0; i < BUFFER; ++i) {
+            #pragma HLS UNROLL
+                left[i][curr_key]  = curr_left[i];
+                right[i][curr_key] = curr_right[i];
+            }
+        }
+
+        curr_key = key;
+
+        const bool _is_initialized = is_initialized[key];
+        curr_left_valid          = (_is_initialized) ? left_valid[key]          : MASK_T(0);
+        curr_right_valid         = (_is_initialized) ? right_valid[key]         : MASK_T(0);
+        curr_left_head           = (_is_initialized) ? left_head[key]           : IDX_T(0);
+        curr_right_head          = (_is_initialized) ? right_head[key]          : IDX_T(0);
+        curr_left_max_timestamp  = (_is_initialized) ? left_max_timestamp[key]  : TIME_T(0);
+        curr_right_max_timestamp = (_is_initialized) ? right_max_timestamp[key] : TIME_T(0);
+
+        SWITCH_KEY_LOAD:
+        for (IDX_T i = 0; i < BUFFER; ++i) {
+        #pragma HLS UNROLL
+            curr_left[i]  = left[i][key];
+            curr_right[i] = right[i][key];
+        }
+    }
+
+    template <typename FUNCTOR_T, typename STREAM_OUT>
+    void _process_left(const T_LEFT & l, FUNCTOR_T & func, STREAM_OUT ostrms[BUFFER])
+    {
+    #pragma HLS INLINE
+        const TIME_T ts = l.timestamp;
+        curr_left_max_timestamp = (ts > curr_left_max_timestamp) ? ts : curr_left_max_timestamp;
+
+        PROBE_RIGHT:
+        for (IDX_T i = 0; i < BUFFER; ++i) {
+        #pragma HLS UNROLL
+            const T_RIGHT r = curr_right[i];
+            const BOUND_T r_ts = r.timestamp;
+            const bool in_range = (r_ts >= BOUND_T(ts) + LOWER) && (r_ts <= BOUND_T(ts) + UPPER);
+
+            if (curr_right_valid[i] && in_range) {
+                FlatMapShipper<STREAM_OUT> shipper(ostrms[i]);
+                func(l, r, shipper);
+            }
+
+            if (right_expired(r.timestamp, curr_left_max_timestamp)) {
+                curr_right_valid[i] = 0;
+            }
+        }
+
+        if (!left_expired(ts, curr_right_max_timestamp)) {
+            curr_left[curr_left_head] = l;
+            curr_left_valid[curr_left_head] = 1;
+            curr_left_head = next(curr_left_head);
+        }
+    }
+
+    template <typename FUNCTOR_T, typename STREAM_OUT>
+    void _process_right(const T_RIGHT & r, FUNCTOR_T & func, STREAM_OUT ostrms[BUFFER])
+    {
+    #pragma HLS INLINE
+        const TIME_T ts = r.timestamp;
+        curr_right_max_timestamp = (ts > curr_right_max_timestamp) ? ts : curr_right_max_timestamp;
+
+        PROBE_LEFT:
+        for (IDX_T i = 0; i < BUFFER; ++i) {
+        #pragma HLS UNROLL
+            const T_LEFT l = curr_left[i];
+            const BOUND_T l_ts = l.timestamp;
+            const bool in_range = (BOUND_T(ts) >= l_ts + LOWER) && (BOUND_T(ts) <= l_ts + UPPER);
+
+            if (curr_left_valid[i] && in_range) {
+                FlatMapShipper<STREAM_OUT> shipper(ostrms[i]);
+                func(l, r, shipper);
+            }
+
+            if (left_expired(l.timestamp, curr_right_max_timestamp)) {
+                curr_left_valid[i] = 0;
+            }
+        }
+
+        if (!right_expired(ts, curr_left_max_timestamp)) {
+            curr_right[curr_right_head] = r;
+            curr_right_valid[curr_right_head] = 1;
+            curr_right_head = next(curr_right_head);
+        }
+    }
+
+    template <
+        typename FUNCTOR_T,
+        typename STREAM_IN,
+        typename STREAM_OUT,
+        typename LEFT_KEY_EXTRACTOR_T,
+        typename RIGHT_KEY_EXTRACTOR_T
+    >
+    void process(
+        STREAM_IN & istrm,
+        STREAM_OUT ostrms[BUFFER],
+        FUNCTOR_T & func,
+        LEFT_KEY_EXTRACTOR_T && left_key_extractor,
+        RIGHT_KEY_EXTRACTOR_T && right_key_extractor
+    )
+    {
+    #pragma HLS dependence variable=left  type=intra direction=RAW false
+    #pragma HLS dependence variable=right type=intra direction=RAW false
+        using T_ITEM = typename STREAM_IN::data_t;
+
+        bool last = istrm.read_eos();
+        KEYED_INTERVAL_JOIN:
+        while (!last) {
+        #pragma HLS PIPELINE II = 1
+        #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+
+            const T_ITEM item = istrm.read();
+            last = istrm.read_eos();
+
+            const KEY_T key = item.is_left ? KEY_T(left_key_extractor(item.left))
+                                           : KEY_T(right_key_extractor(item.right));
+            if (curr_key != key) {
+                switch_key(key);
+            }
+
+            if (item.is_left) {
+                _process_left(item.left, func, ostrms);
+            } else {
+                _process_right(item.right, func, ostrms);
+            }
+        }
+
+        KEYED_INTERVAL_JOIN_EOS:
+        for (IDX_T i = 0; i < BUFFER; ++i) {
+        #pragma HLS UNROLL
+            ostrms[i].write_eos();
+        }
+    }
+};
+
+// FUNCTOR_T is invoked as `func(left, right, shipper)` for every matching
+// pair and may send at most one result per pair through the shipper.
+template <
+    typename FUNCTOR_T,
+    unsigned int KEYS,
+    unsigned int BUFFER,
+    int LOWER,
+    int UPPER,
+    typename STREAM_LEFT,
+    typename STREAM_RIGHT,
+    typename STREAM_OUT,
+    typename LEFT_KEY_EXTRACTOR_T,
+    typename RIGHT_KEY_EXTRACTOR_T,
+    typename... Args
+>
+void KeyedIntervalJoin(
+    STREAM_LEFT & lstrm,
+    STREAM_RIGHT & rstrm,
+    STREAM_OUT & ostrm,
+    LEFT_KEY_EXTRACTOR_T && left_key_extractor,
+    RIGHT_KEY_EXTRACTOR_T && right_key_extractor,
+    Args&&... args
+)
+{
+    using T_LEFT  = typename STREAM_LEFT::data_t;
+    using T_RIGHT = typename STREAM_RIGHT::data_t;
+    using T_OUT   = typename STREAM_OUT::data_t;
+    using T_ITEM  = join_item_t<T_LEFT, T_RIGHT>;
+
+    // a probe sends up to BUFFER matches at once, one per stream, while
+    // SNtoS_LB forwards one per cycle: 16 slots absorb the bursts of 16 tuples
+    using STREAM_MATCH_T = fx::stream<T_OUT, 16>;
+
+    FUNCTOR_T func(std::forward<Args>(args)...);
+
+    fx::stream<T_ITEM, 2> _istrm("_istrm");
+    STREAM_MATCH_T match_strms[BUFFER];
+
+    _keyed_interval_join_t<T_LEFT, T_RIGHT, KEYS, BUFFER, LOWER, UPPER> join;
+
+    #pragma HLS DATAFLOW
+    FX_DATAFLOW;
+    FX_PROCESS(join_merge(lstrm, rstrm, _istrm));
+    FX_PROCESS(join.process(_istrm, match_strms, func,
+                            std::forward<LEFT_KEY_EXTRACTOR_T>(left_key_extractor),
+                            std::forward<RIGHT_KEY_EXTRACTOR_T>(right_key_extractor)));
+    FX_PROCESS(fx::SNtoS_LB<BUFFER>(match_strms, ostrm));
+}
+
+
+// Set-associative hash table: TABLE_SIZE entries split into HASH_WAYS ways of
+// TABLE_SIZE / HASH_WAYS sets, the set of a key is chosen by HASH_T. When a
+// set is full, its ways are replaced in turn (every set has its own victim)
+// and the evicted rows are counted. The last write is forwarded to the next
+// access to hide the read-after-write latency of the memory.
+template <
+    typename T_ROW,
+    unsigned int TABLE_SIZE,
+    unsigned int HASH_WAYS,
+    typename HASH_T
+>
+struct _lookup_table_t
+{
+    static constexpr unsigned int SETS = TABLE_SIZE / HASH_WAYS;
+
+    HW_STATIC_ASSERT(TABLE_SIZE % HASH_WAYS == 0, "FX: LookupJoin TABLE_SIZE must be a multiple of HASH_WAYS");
+    HW_STATIC_ASSERT(IS_POW2(SETS), "FX: LookupJoin TABLE_SIZE / HASH_WAYS must be a power of 2");
+
+    using KEY_T   = unsigned int;
+    using SET_T   = unsigned int;
+    using WAY_T   = unsigned int;
+    using MASK_T  = ap_uint<HASH_WAYS>;
+    using COUNT_T = unsigned int;
+
+    const HASH_T hash;
+
+    KEY_T keys[HASH_WAYS][SETS];
+    T_ROW rows[HASH_WAYS][SETS];
+    MASK_T valid[SETS];
+    WAY_T victim[SETS];
+
+    COUNT_T evictions;
+
+    bool fwd_valid;
+    SET_T fwd_set;
+    WAY_T fwd_way;
+    KEY_T fwd_key;
+    T_ROW fwd_row;
+    MASK_T fwd_mask;
+    WAY_T fwd_victim;
+
+    _lookup_table_t()
+    : hash()
+    , evictions(0)
+    , fwd_valid(false)
+    , fwd_set(0)
+    , fwd_way(0)
+    , fwd_key(0)
+    , fwd_mask(0)
+    , fwd_victim(0)
+    {
+        #pragma HLS bind_storage    variable=keys   type=RAM_2P   impl=BRAM
+        #pragma HLS array_partition variable=keys   type=complete dim=1
+        #pragma HLS bind_storage    variable=rows   type=RAM_2P   impl=BRAM
+        #pragma HLS array_partition variable=rows   type=complete dim=1
+        #pragma HLS bind_storage    variable=valid  type=RAM_2P   impl=BRAM
+        #pragma HLS bind_storage    variable=victim type=RAM_2P   impl=BRAM
+    }
+
+    void clear()
+    {
+    LOOKUP_TABLE_CLEAR:
+        for (SET_T s = 0; s < SETS; ++s) {
+        #pragma HLS PIPELINE II = 1
+            valid[s] = 0;
+            victim[s] = 0;
+        }
+        evictions = 0;
+        fwd_valid = false;
+    }
+
+    SET_T set_of(const KEY_T key) const
+    {
+    #pragma HLS INLINE
+        return hash.template index<SETS>(key);
+    }
+
+    void read_set(const SET_T s, KEY_T k[HASH_WAYS], T_ROW r[HASH_WAYS], MASK_T & m, WAY_T & v)
+    {
+    #pragma HLS INLINE
+    #pragma HLS dependence variable=keys   type=inter direction=RAW false
+    #pragma HLS dependence variable=rows   type=inter direction=RAW false
+    #pragma HLS dependence variable=valid  type=inter direction=RAW false
+    #pragma HLS dependence variable=victim type=inter direction=RAW false
+        READ_SET:
+        for (WAY_T w = 0; w < HASH_WAYS; ++w) {
+        #pragma HLS UNROLL
+            k[w] = keys[w][s];
+            r[w] = rows[w][s];
+        }
+        m = valid[s];
+        v = victim[s];
+
+        if (fwd_valid && fwd_set == s) {
+            k[fwd_way] = fwd_key;
+            r[fwd_way] = fwd_row;
+            m = fwd_mask;
+            v = fwd_victim;
+        }
+    }
+
+    void insert(const KEY_T key, const T_ROW & row)
+    {
+    #pragma HLS INLINE
+        const SET_T s = set_of(key);
+
+        KEY_T k[HASH_WAYS];
+        T_ROW r[HASH_WAYS];
+        MASK_T m;
+        WAY_T v;
+        #pragma HLS array_partition variable=k type=complete
+        #pragma HLS array_partition variable=r type=complete
+        read_set(s, k, r, m, v);
+
+        // priority: same key, then first free way, then the victim of the set
+        bool hit = false;
+        bool free = false;
+        WAY_T hit_way = 0;
+        WAY_T free_way = 0;
+        INSERT_FIND_WAY:
+        for (WAY_T w = 0; w < HASH_WAYS; ++w) {
+        #pragma HLS UNROLL
+            if (!hit && m[w] && k[w] == key) {
+                hit = true;
+                hit_way = w;
+            }
+            if (!free && !m[w]) {
+                free = true;
+                free_way = w;
+            }
+        }
+
+        const WAY_T way = hit ? hit_way : (free ? free_way : v);
+        if (!hit && !free) {
+            v = (v + 1 == HASH_WAYS) ? 0 : (v + 1);
+            ++evictions;
+        }
+
+        m[way] = 1;
+        keys[way][s] = key;
+        rows[way][s] = row;
+        valid[s] = m;
+        victim[s] = v;
+
+        fwd_valid = true;
+        fwd_set = s;
+        fwd_way = way;
+        fwd_key = key;
+        fwd_row = row;
+        fwd_mask = m;
+        fwd_victim = v;
+    }
+
+    void lookup(const KEY_T key, T_ROW & row, bool & found)
+    {
+    #pragma HLS INLINE
+        const SET_T s = set_of(key);
+
+        KEY_T k[HASH_WAYS];
+        T_ROW r[HASH_WAYS];
+        MASK_T m;
+        WAY_T v;
+        #pragma HLS array_partition variable=k type=complete
+        #pragma HLS array_partition variable=r type=complete
+        read_set(s, k, r, m, v);
+
+        found = false;
+        LOOKUP_FIND_WAY:
+        for (WAY_T w = 0; w < HASH_WAYS; ++w) {
+        #pragma HLS UNROLL
+            if (m[w] && k[w] == key) {
+                row = r[w];
+                found = true;
+            }
+        }
+    }
+};
+
+template <
+    bool PRELOAD,
+    typename STREAM_IN,
+    typename STREAM_TABLE,
+    typename STREAM_OUT,
+    typename TABLE_T,
+    typename FUNCTOR_T,
+    typename KEY_EXTRACTOR_T,
+    typename TABLE_KEY_EXTRACTOR_T
+>
+void _lookup_join(
+    STREAM_IN & istrm,
+    STREAM_TABLE & tstrm,
+    STREAM_OUT & ostrm,
+    TABLE_T & table,
+    FUNCTOR_T & func,
+    KEY_EXTRACTOR_T && key_extractor,
+    TABLE_KEY_EXTRACTOR_T && table_key_extractor
+)
+{
+#pragma HLS INLINE
+    using T_IN  = typename STREAM_IN::data_t;
+    using T_ROW = typename STREAM_TABLE::data_t;
+    using T_OUT = typename STREAM_OUT::data_t;
+    using KEY_T = unsigned int;
+
+    table.clear();
+
+    bool last_t = tstrm.read_eos();
+    bool last = istrm.read_eos();
+
+LookupJoin:
+    while (!last || !last_t) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+
+        const bool ready_t = !last_t && !tstrm.empty() && !tstrm.empty_eos();
+        const bool ready_i = !last && (!PRELOAD || last_t) && !istrm.empty() && !istrm.empty_eos();
+
+        if (ready_t) {
+            const T_ROW row = tstrm.read();
+            last_t = tstrm.read_eos();
+
+            table.insert(KEY_T(table_key_extractor(row)), row);
+        } else if (ready_i) {
+            const T_IN in = istrm.read();
+            last = istrm.read_eos();
+
+            T_ROW row;
+            bool found;
+            table.lookup(KEY_T(key_extractor(in)), row, found);
+
+            T_OUT out;
+            func(in, row, found, out);
+            ostrm.write(out);
+        }
+    }
+    ostrm.write_eos();
+}
+
+// Enriches every tuple of `istrm` with the table row having the same key.
+// The table is filled from `tstrm`: rows can be loaded from memory at kernel
+// start (e.g. with WMtoS) or sent incrementally. When PRELOAD is true the
+// whole table stream is consumed before the first lookup, otherwise updates
+// are interleaved with lookups and take priority over them. A row whose set
+// is full evicts another row of the set, whose key is then not found: use
+// LookupJoinEvictions to count them.
+// FUNCTOR_T is invoked as `func(in, row, found, out)`.
+template <
+    typename FUNCTOR_T,
+    unsigned int TABLE_SIZE,
+    unsigned int HASH_WAYS = 1,
+    bool PRELOAD = true,
+    typename HASH_T = multiply_shift_hash_t,
+    typename STREAM_IN,
+    typename STREAM_TABLE,
+    typename STREAM_OUT,
+    typename KEY_EXTRACTOR_T,
+    typename TABLE_KEY_EXTRACTOR_T,
+    typename... Args
+>
+void LookupJoin(
+    STREAM_IN & istrm,
+    STREAM_TABLE & tstrm,
+    STREAM_OUT & ostrm,
+    KEY_EXTRACTOR_T && key_extractor,
+    TABLE_KEY_EXTRACTOR_T && table_key_extractor,
+    Args&&... args
+)
+{
+    using T_ROW = typename STREAM_TABLE::data_t;
+
+    FUNCTOR_T func(std::forward<Args>(args)...);
+
+    _lookup_table_t<T_ROW, TABLE_SIZE, HASH_WAYS, HASH_T> table;
+
+    _lookup_join<PRELOAD>(istrm, tstrm, ostrm, table, func,
+                          std::forward<KEY_EXTRACTOR_T>(key_extractor),
+                          std::forward<TABLE_KEY_EXTRACTOR_T>(table_key_extractor));
+}
+
+// LookupJoin that writes the number of rows evicted from the table to
+// `estrm` at EOS.
+template <
+    typename FUNCTOR_T,
+    unsigned int TABLE_SIZE,
+    unsigned int HASH_WAYS = 1,
+    bool PRELOAD = true,
+    typename HASH_T = multiply_shift_hash_t,
+    typename STREAM_IN,
+    typename STREAM_TABLE,
+    typename STREAM_OUT,
+    typename STREAM_COUNT,
+    typename KEY_EXTRACTOR_T,
+    typename TABLE_KEY_EXTRACTOR_T,
+    typename... Args
+>
+void LookupJoinEvictions(
+    STREAM_IN & istrm,
+    STREAM_TABLE & tstrm,
+    STREAM_OUT & ostrm,
+    STREAM_COUNT & estrm,
+    KEY_EXTRACTOR_T && key_extractor,
+    TABLE_KEY_EXTRACTOR_T && table_key_extractor,
+    Args&&... args
+)
+{
+    using T_ROW = typename STREAM_TABLE::data_t;
+
+    FUNCTOR_T func(std::forward<Args>(args)...);
+
+    _lookup_table_t<T_ROW, TABLE_SIZE, HASH_WAYS, HASH_T> table;
+
+    _lookup_join<PRELOAD>(istrm, tstrm, ostrm, table, func,
+                          std::forward<KEY_EXTRACTOR_T>(key_extractor),
+                          std::forward<TABLE_KEY_EXTRACTOR_T>(table_key_extractor));
+    estrm.write(table.evictions);
+}
+
+}
+
+#endif // __JOIN_HPP__
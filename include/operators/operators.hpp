@@ -4,7 +4,11 @@
 #include "map.hpp"
 #include "filter.hpp"
 #include "flatmap.hpp"
+#include "split.hpp"
+#include "join.hpp"
+#include "probe.hpp"
 #include "generator.hpp"
+#include "workload.hpp"
 #include "drainer.hpp"
 #include "window.hpp"
 
@@ -0,0 +1,109 @@
+#ifndef __PROBE_HPP__
+#define __PROBE_HPP__
+
+#include "ap_int.h"
+#include "../common.hpp"
+#include "../streams/streams.hpp"
+
+#if !defined(__SYNTHESIS__)
+#include <ostream>
+#endif
+
+
+namespace fx {
+
+struct probe_stats_t
+{
+    using CYCLE_T = ap_uint<64>;
+
+    CYCLE_T cycles;         // cycles spent in the probe loop
+    CYCLE_T tuples;         // tuples forwarded
+    CYCLE_T empty_cycles;   // cycles with the input FIFO empty
+    CYCLE_T full_cycles;    // cycles with the output FIFO full
+    CYCLE_T stall_cycles;   // cycles with a tuple ready but the output FIFO full
+
+    probe_stats_t()
+    : cycles(0)
+    , tuples(0)
+    , empty_cycles(0)
+    , full_cycles(0)
+    , stall_cycles(0)
+    {}
+
+    #if !defined(__SYNTHESIS__)
+    friend std::ostream & operator<<(std::ostream & os, const probe_stats_t & stats)
+    {
+        os << "(cycles: "   << stats.cycles.to_uint64()
+           << ", tuples: "  << stats.tuples.to_uint64()
+           << ", empty: "   << stats.empty_cycles.to_uint64()
+           << ", full: "    << stats.full_cycles.to_uint64()
+           << ", stall: "   << stats.stall_cycles.to_uint64()
+           << ")";
+        return os;
+    }
+    #endif
+};
+
+// Pass-through probe: forwards istrm to ostrm one tuple per cycle without
+// blocking, so that every loop iteration is a clock cycle and can be
+// classified. The leading EOS flag is polled too, so counting starts with the
+// process and not with the first tuple. The counters are written to `sstrm`
+// at EOS. Each probe counts the cycles of its own loop, the counters of two
+// probes do not share a time base: the end-to-end latency is measured on the
+// host (see fx::LatencyTracker). In csim the loop iterations are not cycles
+// and only the tuple count is meaningful.
+template <
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename STREAM_STATS
+>
+void Probe(
+    STREAM_IN & istrm,
+    STREAM_OUT & ostrm,
+    STREAM_STATS & sstrm
+)
+{
+    using T = typename STREAM_IN::data_t;
+
+    probe_stats_t stats;
+    bool first = true;
+    bool last = false;
+
+Probe:
+    while (!last) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        const bool eos_ready = !istrm.empty_eos();
+        const bool in_ready = !first && eos_ready && !istrm.empty();
+        const bool out_full = ostrm.full();
+
+        if (first) {
+            if (eos_ready) {
+                last = istrm.read_eos();
+                first = false;
+            }
+        } else if (in_ready && !out_full) {
+            T t = istrm.read();
+            last = istrm.read_eos();
+            ostrm.write(t);
+            ++stats.tuples;
+        }
+
+        if (!in_ready) {
+            ++stats.empty_cycles;
+        }
+        if (out_full) {
+            ++stats.full_cycles;
+        }
+        if (in_ready && out_full) {
+            ++stats.stall_cycles;
+        }
+        ++stats.cycles;
+    }
+    ostrm.write_eos();
+    sstrm.write(stats);
+}
+
+}
+
+#endif // __PROBE_HPP__
@@ -0,0 +1,63 @@
+#ifndef __SPLIT_HPP__
+#define __SPLIT_HPP__
+
+#include "ap_int.h"
+#include "../common.hpp"
+#include "../streams/streams.hpp"
+
+
+namespace fx {
+
+// FUNCTOR_T sets bit i of the mask to route the tuple to ostrms[i].
+// A tuple can be routed to several branches at once (mask with multiple
+// bits set) or to none of them (mask equal to zero). To route by index
+// simply set `mask[index] = 1`.
+template <
+    int N,
+    typename FUNCTOR_T,
+    typename STREAM_IN,
+    typename STREAM_OUT,
+    typename... Args
+>
+void Split(
+    STREAM_IN & istrm,
+    STREAM_OUT ostrms[N],
+    Args&&... args
+)
+{
+    using T = typename STREAM_IN::data_t;
+    using MASK_T = ap_uint<N>;
+
+    bool last = istrm.read_eos();
+
+    FUNCTOR_T func(std::forward<Args>(args)...);
+
+Split:
+    while (!last) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        T t = istrm.read();
+        last = istrm.read_eos();
+
+        MASK_T mask = 0;
+        func(t, mask);
+
+    Split_WRITE:
+        for (int i = 0; i < N; ++i) {
+        #pragma HLS UNROLL
+            if (mask[i]) {
+                ostrms[i].write(t);
+            }
+        }
+    }
+
+Split_EOS:
+    for (int i = 0; i < N; ++i) {
+    #pragma HLS UNROLL
+        ostrms[i].write_eos();
+    }
+}
+
+}
+
+#endif // __SPLIT_HPP__
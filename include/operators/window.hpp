@@ -328,7 +328,10 @@ struct _keyed_late_bucket_t
 
             last = istrm.read_eos();
 
-            _process(key, in.value, in.timestamp, valid, ostrms);
+            // the bubbles of send_and_flush (key -1) belong to no key
+            if (key < KEYS) {
+                _process(key, in.value, in.timestamp, valid, ostrms);
+            }
         }
 
         TIME_BUCKET_EOS:
@@ -503,7 +506,10 @@ struct _keyed_late_sliding_bucket_t
 
             last = istrm.read_eos();
 
-            _process(key, in.value, in.timestamp, valid, ostrms);
+            // the bubbles of send_and_flush (key -1) belong to no key
+            if (key < KEYS) {
+                _process(key, in.value, in.timestamp, valid, ostrms);
+            }
         }
 
         TIME_BUCKET_EOS:
@@ -514,6 +520,9 @@ struct _keyed_late_sliding_bucket_t
 };
 
 
+// The results of the window operators are built from the window state and
+// carry no field of the input tuples: a latency stamp (fx::LatencyTracker)
+// does not reach them.
 template <
     typename OP,
     unsigned int SIZE = 1,
@@ -538,9 +547,10 @@ void TimeTumblingWindowOperator(
     _late_bucket_t<OP, SIZE, LATENESS> bucket;
 
     #pragma HLS DATAFLOW
-    send_and_flush<OP, 1>(istrm, _istrm, vstrm);
-    bucket.process(_istrm, vstrm, result_strms);
-    fx::SNtoS_LB<N>(result_strms, ostrm);
+    FX_DATAFLOW;
+    FX_PROCESS(send_and_flush<OP, 1>(istrm, _istrm, vstrm));
+    FX_PROCESS(bucket.process(_istrm, vstrm, result_strms));
+    FX_PROCESS(fx::SNtoS_LB<N>(result_strms, ostrm));
 }
 
 template <
@@ -575,13 +585,14 @@ void KeyedTimeTumblingWindowOperator(
     _keyed_late_bucket_t<OP, KEYS, SIZE, LATENESS> bucket;
 
     #pragma HLS DATAFLOW
-    send_and_flush<OP, KEYS>(istrm, _istrm, vstrm);
-    bucket.process(_istrm, vstrm, result_strms, std::forward<KEY_EXTRACTOR_T>(key_extractor));
-    fx::route_min_rec<N>(result_strms, ostrm,
+    FX_DATAFLOW;
+    FX_PROCESS(send_and_flush<OP, KEYS>(istrm, _istrm, vstrm));
+    FX_PROCESS(bucket.process(_istrm, vstrm, result_strms, std::forward<KEY_EXTRACTOR_T>(key_extractor)));
+    FX_PROCESS(fx::route_min_rec<N>(result_strms, ostrm,
         [](const RESULT_T & a, const RESULT_T & b) {
             return (a.sequence < b.sequence) || ((a.sequence == b.sequence) && (a.timestamp < b.timestamp));
         }
-    );
+    ));
 }
 
 template <
@@ -616,9 +627,10 @@ void KeyedTimeSlidingWindowOperator(
     _keyed_late_sliding_bucket_t<OP, KEYS, SIZE, STEP, LATENESS> bucket;
 
     #pragma HLS DATAFLOW
-    send_and_flush<OP, KEYS>(istrm, _istrm, vstrm);
-    bucket.process(_istrm, vstrm, result_strms, std::forward<KEY_EXTRACTOR_T>(key_extractor));
-    fx::route_min_rec<N>(result_strms, ostrm,
+    FX_DATAFLOW;
+    FX_PROCESS(send_and_flush<OP, KEYS>(istrm, _istrm, vstrm));
+    FX_PROCESS(bucket.process(_istrm, vstrm, result_strms, std::forward<KEY_EXTRACTOR_T>(key_extractor)));
+    FX_PROCESS(fx::route_min_rec<N>(result_strms, ostrm,
         [](const RESULT_T & a, const RESULT_T & b) {
 
             // return true to keep the minimum
@@ -637,7 +649,7 @@ void KeyedTimeSlidingWindowOperator(
 
             // return (a.sequence < b.sequence) || ((a.sequence == b.sequence) && (a.timestamp < b.timestamp)) || ((a.sequence == b.sequence) && (a.timestamp == b.timestamp) && (a.wid < b.wid));
         }
-    );
+    ));
     // fx::SNtoS_LB<N>(result_strms, ostrm);
 }
 
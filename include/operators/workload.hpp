@@ -0,0 +1,70 @@
+#ifndef __WORKLOAD_HPP__
+#define __WORKLOAD_HPP__
+
+#include "../common.hpp"
+#include "../streams/streams.hpp"
+#include "../datastructures/distributions.hpp"
+
+
+namespace fx {
+
+// Synthetic source for benchmarks: emits `count` tuples at a target rate of
+// RATE_NUM / RATE_DEN tuples per cycle. Keys are drawn from `keys` (e.g.
+// uniform_keys_t or zipf_keys_t) and the event time of the i-th tuple is i
+// moved back by at most DISORDER. FUNCTOR_T is invoked as
+// `func(index, key, timestamp, out)` to build the tuple.
+// The same seed always produces the same stream, both in csim and on device.
+template <
+    typename FUNCTOR_T,
+    unsigned int DISORDER = 0,
+    unsigned int RATE_NUM = 1,
+    unsigned int RATE_DEN = 1,
+    typename STREAM_OUT,
+    typename KEY_DIST_T,
+    typename... Args
+>
+void WorkloadGenerator(
+    STREAM_OUT & ostrm,
+    const unsigned int count,
+    const unsigned int seed,
+    KEY_DIST_T & keys,
+    Args&&... args
+)
+{
+    HW_STATIC_ASSERT(RATE_NUM > 0 && RATE_NUM <= RATE_DEN,
+                     "FX: WorkloadGenerator rate must be in (0, 1] tuples per cycle");
+
+    using T_OUT  = typename STREAM_OUT::data_t;
+    using TIME_T = unsigned int;
+
+    FUNCTOR_T func(std::forward<Args>(args)...);
+    bounded_jitter_t<DISORDER> jitter(seed);
+
+    unsigned int index = 0;
+    unsigned int credit = 0;
+
+WorkloadGenerator:
+    while (index < count) {
+    #pragma HLS PIPELINE II = 1
+    #pragma HLS LOOP_TRIPCOUNT min = 1 max = 1024
+        credit += RATE_NUM;
+
+        if (credit >= RATE_DEN) {
+            credit -= RATE_DEN;
+
+            const auto key = keys.next();
+            const TIME_T timestamp = jitter.next(index);
+
+            T_OUT out;
+            func(index, key, timestamp, out);
+            ostrm.write(out);
+
+            ++index;
+        }
+    }
+    ostrm.write_eos();
+}
+
+}
+
+#endif // __WORKLOAD_HPP__
@@ -3,8 +3,8 @@
 
 #include "ap_int.h"
 #include "ap_axi_sdata.h"
-#include "hls_stream.h"
 #include "../common.hpp"
+#include "stream.hpp"
 
 
 namespace fx {
@@ -16,8 +16,8 @@ struct axis_stream
     using wdata_t = hls::axis<T, 0, 0, 0>;
     using weos_t = hls::axis<bool, 0, 0, 0>;
 
-    hls::stream<wdata_t> data;
-    hls::stream<weos_t> e_data;
+    fifo<wdata_t, DEPTH> data;
+    fifo<weos_t, DEPTH> e_data;
 
     axis_stream() {
         #pragma HLS INTERFACE mode=axis port=data
@@ -58,6 +58,18 @@ struct axis_stream
         return e.data;
     }
 
+    // non-blocking read_eos, false if the flag of the next item is not there yet
+    bool read_eos_nb(bool & eos)
+    {
+    #pragma HLS INLINE
+        weos_t e;
+        if (e_data.read_nb(e)) {
+            eos = e.data;
+            return true;
+        }
+        return false;
+    }
+
     void write_eos()
     {
     #pragma HLS INLINE
@@ -0,0 +1,71 @@
+#ifndef __STREAMS_DATAFLOW_HPP__
+#define __STREAMS_DATAFLOW_HPP__
+
+#include "../common.hpp"
+
+
+// Processes of a dataflow region. In HLS and csim FX_PROCESS(call) is the call
+// itself and FX_DATAFLOW expands to nothing. With FX_CPU_BACKEND every process
+// is started in its own thread and the threads are joined when the region
+// goes out of scope, so FX_DATAFLOW must follow the local streams of the
+// region. FX_PROCESS_I(i, call) is the form for the unrolled loops: the index
+// `i` is captured by value.
+//
+//     fx::stream<T> s;
+//     FX_DATAFLOW;
+//     FX_PROCESS(producer(in, s));
+//     FX_PROCESS(consumer(s, out));
+//
+// This holds for the top function of the user kernel too: processes called
+// one after the other, as `#pragma HLS DATAFLOW` alone allows, run in
+// sequence on the CPU backend, and the first one blocks for good as soon as
+// a stream between them holds more than FX_CPU_STREAM_DEPTH tuples. Wrap them
+// in FX_DATAFLOW/FX_PROCESS as the operators of the library do.
+
+#ifdef FX_CPU_BACKEND
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fx {
+
+struct cpu_dataflow_t
+{
+    std::vector<std::thread> threads;
+
+    template <typename F>
+    void spawn(F && f)
+    {
+        threads.emplace_back(std::forward<F>(f));
+    }
+
+    void join()
+    {
+        for (auto & t : threads) {
+            t.join();
+        }
+        threads.clear();
+    }
+
+    ~cpu_dataflow_t()
+    {
+        join();
+    }
+};
+
+}
+
+#define FX_DATAFLOW             fx::cpu_dataflow_t _fx_dataflow
+#define FX_PROCESS(...)         _fx_dataflow.spawn([&]() { __VA_ARGS__; })
+#define FX_PROCESS_I(i, ...)    _fx_dataflow.spawn([&, i]() { __VA_ARGS__; })
+
+#else
+
+#define FX_DATAFLOW
+#define FX_PROCESS(...)         __VA_ARGS__
+#define FX_PROCESS_I(i, ...)    __VA_ARGS__
+
+#endif
+
+#endif // __STREAMS_DATAFLOW_HPP__
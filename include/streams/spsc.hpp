@@ -0,0 +1,132 @@
+#ifndef __STREAMS_SPSC_HPP__
+#define __STREAMS_SPSC_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include "../common.hpp"
+
+#ifndef FX_CPU_STREAM_DEPTH
+#define FX_CPU_STREAM_DEPTH 1024
+#endif
+
+
+namespace fx {
+
+// Bounded lock-free single-producer single-consumer queue with the interface
+// of hls::stream, used in place of it by the CPU backend (FX_CPU_BACKEND),
+// where every dataflow process runs in its own thread. The capacity is DEPTH
+// rounded to a power of 2, at least FX_CPU_STREAM_DEPTH: a larger FIFO never
+// changes the result of a dataflow region and saves context switches.
+// Blocking read and write yield the thread while the queue is empty/full.
+template <typename T, int DEPTH = 2>
+struct spsc_queue
+{
+    static constexpr size_t CAPACITY = POW2_CEIL<size_t>(MAX_VAL<size_t>(DEPTH, FX_CPU_STREAM_DEPTH));
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    // head is owned by the consumer and tail by the producer, each one keeps
+    // a cached copy of the other index to touch the shared line only when the
+    // queue looks empty (full)
+    alignas(64) std::atomic<size_t> head;
+    size_t tail_cache;
+    alignas(64) std::atomic<size_t> tail;
+    size_t head_cache;
+    alignas(64) std::unique_ptr<T[]> buffer;
+
+    spsc_queue()
+    : head(0)
+    , tail_cache(0)
+    , tail(0)
+    , head_cache(0)
+    , buffer(new T[CAPACITY])
+    {}
+
+    spsc_queue(const char *)
+    : spsc_queue()
+    {}
+
+    spsc_queue(const spsc_queue &) = delete;
+    spsc_queue & operator=(const spsc_queue &) = delete;
+
+    void set_name(const char *) {}
+
+    bool read_nb(T & t)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail_cache) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) {
+                return false;
+            }
+        }
+        t = buffer[h & MASK];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool write_nb(const T & t)
+    {
+        const size_t tl = tail.load(std::memory_order_relaxed);
+        if (tl - head_cache == CAPACITY) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (tl - head_cache == CAPACITY) {
+                return false;
+            }
+        }
+        buffer[tl & MASK] = t;
+        tail.store(tl + 1, std::memory_order_release);
+        return true;
+    }
+
+    void read(T & t)
+    {
+        while (!read_nb(t)) {
+            std::this_thread::yield();
+        }
+    }
+
+    T read()
+    {
+        T t;
+        read(t);
+        return t;
+    }
+
+    void write(const T & t)
+    {
+        while (!write_nb(t)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void operator>>(T & t)
+    {
+        read(t);
+    }
+
+    void operator<<(const T & t)
+    {
+        write(t);
+    }
+
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+    }
+
+    bool full() const
+    {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == CAPACITY;
+    }
+};
+
+}
+
+#endif // __STREAMS_SPSC_HPP__
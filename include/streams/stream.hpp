@@ -2,14 +2,34 @@
 #define __STREAMS_STREAM_HPP__
 
 #pragma GCC system_header
-#include "hls_stream.h"
 #include "../common.hpp"
+#include "dataflow.hpp"
+
+#ifdef FX_CPU_BACKEND
+#include "spsc.hpp"
+#else
+#include "hls_stream.h"
+#endif
 
 
 namespace fx {
 
+// Plain FIFO between the processes of a dataflow region: hls::stream or, with
+// FX_CPU_BACKEND, a lock-free spsc_queue. DEPTH only sizes the CPU queue, in
+// HLS the depth is set with the STREAM pragma as usual.
+#ifdef FX_CPU_BACKEND
+template <typename T, int DEPTH = 2>
+using fifo = spsc_queue<T, DEPTH>;
+
+template <typename T, int DEPTH = 2>
+using stream_single = spsc_queue<T, DEPTH>;
+#else
+template <typename T, int DEPTH = 2>
+using fifo = hls::stream<T>;
+
 template <typename T, int DEPTH = 2>
 using stream_single = hls::stream<T, DEPTH>;
+#endif
 
 
 template <typename T, int DEPTH = 2>
@@ -17,8 +37,8 @@ struct stream
 {
     using data_t = T;
 
-    hls::stream<T> data;
-    hls::stream<bool> e_data;
+    fifo<T, DEPTH> data;
+    fifo<bool, DEPTH> e_data;
 
     stream() {
         #pragma HLS STREAM variable=data   depth=DEPTH
@@ -50,6 +70,13 @@ struct stream
         return e_data.read();
     }
 
+    // non-blocking read_eos, false if the flag of the next item is not there yet
+    bool read_eos_nb(bool & eos)
+    {
+    #pragma HLS INLINE
+        return e_data.read_nb(eos);
+    }
+
     void write_eos()
     {
     #pragma HLS INLINE
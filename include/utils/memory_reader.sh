@@ -66,4 +66,17 @@ generate_sp_host() {
         idx=$((idx + 1))
     done
     echo $sp
-}
\ No newline at end of file
+}
+
+# PERSISTENT KERNELS, ring and control block in HOST MEMORY (--connectivity.sp)
+generate_sp_ring() {
+    local sp=""
+    local idx=0
+    while [ $idx -lt $1 ]
+    do
+        sp="${sp} --connectivity.sp=${mr_kernel}_${idx}.ring:HOST[0]"
+        sp="${sp} --connectivity.sp=${mr_kernel}_${idx}.ctrl:HOST[0]"
+        idx=$((idx + 1))
+    done
+    echo $sp
+}
@@ -71,3 +71,17 @@ generate_sp_host() {
     done
     echo $sp
 }
+
+
+# PERSISTENT KERNELS, ring and control block in HOST MEMORY (--connectivity.sp)
+generate_sp_ring() {
+    local sp=""
+    local idx=0
+    while [ $idx -lt $1 ]
+    do
+        sp="${sp} --connectivity.sp=${mw_kernel}_${idx}.ring:HOST[0]"
+        sp="${sp} --connectivity.sp=${mw_kernel}_${idx}.ctrl:HOST[0]"
+        idx=$((idx + 1))
+    done
+    echo $sp
+}
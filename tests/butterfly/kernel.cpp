@@ -0,0 +1,18 @@
+#include "kernel.hpp"
+
+void kernel(
+    stream_t br_in[N],
+    stream_t br_out[N],
+    stream_t lb_in[N],
+    stream_t lb_out[N],
+    stream_t kb_in[N],
+    stream_t kb_out[N]
+)
+{
+    #pragma HLS DATAFLOW
+
+    FX_DATAFLOW;
+    FX_PROCESS(fx::A2A::Butterfly<fx::A2A::BR, N>(br_in, br_out));
+    FX_PROCESS(fx::A2A::Butterfly<fx::A2A::LB, N>(lb_in, lb_out));
+    FX_PROCESS(fx::A2A::Butterfly<fx::A2A::KB, N>(kb_in, kb_out, [](const data_t & d) { return d.key; }));
+}
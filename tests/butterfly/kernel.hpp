@@ -0,0 +1,28 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int producer;
+    unsigned int seq;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int producer, unsigned int seq)
+        : key(key), producer(producer), seq(seq)
+    {}
+};
+
+static constexpr int N = 4;
+
+using stream_t = fx::stream<data_t, 2>;
+
+// the same producers and consumers connected by a broadcast, a load
+// balancing and a key-by butterfly
+void kernel(
+    stream_t br_in[N],
+    stream_t br_out[N],
+    stream_t lb_in[N],
+    stream_t lb_out[N],
+    stream_t kb_in[N],
+    stream_t kb_out[N]
+);
@@ -0,0 +1,188 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#define _DEBUG 0
+
+using input_t = std::vector<std::vector<data_t>>;
+using output_t = std::vector<std::vector<data_t>>;
+
+
+// `n` tuples per producer, keys drawn from [0, keys) and multiplied by
+// `stride`: a stride of N sends every tuple to replica 0 under KB
+input_t generate_input(int n, unsigned int keys, unsigned int stride = 1)
+{
+    fx::xorshift32_t rng(42);
+
+    input_t data(N);
+    for (int p = 0; p < N; ++p) {
+        for (int i = 0; i < n; ++i) {
+            data[p].push_back(data_t(rng.next_below(keys) * stride, p, i));
+        }
+    }
+    return data;
+}
+
+void write_input(stream_t in[N], const input_t & data)
+{
+    for (int p = 0; p < N; ++p) {
+        for (const auto & d : data[p]) {
+            in[p].write(d);
+        }
+        in[p].write_eos();
+    }
+}
+
+output_t read_output(stream_t out[N])
+{
+    output_t result(N);
+    for (int r = 0; r < N; ++r) {
+        bool last = out[r].read_eos();
+        while (!last) {
+            data_t d = out[r].read();
+            last = out[r].read_eos();
+            result[r].push_back(d);
+        }
+    }
+    return result;
+}
+
+size_t count(const input_t & data)
+{
+    size_t total = 0;
+    for (const auto & v : data) {
+        total += v.size();
+    }
+    return total;
+}
+
+// the tuples of a replica are a subsequence of the stream of their producer
+// (per key with `by_key`): same contents and increasing seq
+bool check_order(const std::vector<data_t> & out, const input_t & input, const bool by_key, const std::string & name)
+{
+    std::map<std::pair<unsigned int, unsigned int>, long> next_seq;
+    for (const auto & d : out) {
+        if (d.producer >= N || d.seq >= input[d.producer].size() || input[d.producer][d.seq].key != d.key) {
+            std::cerr << "Error: " << name << " received a tuple never sent (producer " << d.producer << ", seq " << d.seq << ")" << std::endl;
+            return false;
+        }
+        const auto id = std::make_pair(d.producer, by_key ? d.key : 0u);
+        auto it = next_seq.find(id);
+        if (it != next_seq.end() && long(d.seq) <= it->second) {
+            std::cerr << "Error: " << name << " received seq " << d.seq << " of producer " << d.producer
+                      << (by_key ? " and key " + std::to_string(d.key) : std::string(""))
+                      << " after seq " << it->second << std::endl;
+            return false;
+        }
+        next_seq[id] = d.seq;
+    }
+    return true;
+}
+
+bool check_br(const output_t & output, const input_t & input)
+{
+    bool success = true;
+    for (int r = 0; r < N; ++r) {
+        const std::string name = "BR replica " + std::to_string(r);
+        if (output[r].size() != count(input)) {
+            std::cerr << "Error: " << name << " received " << output[r].size() << " tuples, expected " << count(input) << std::endl;
+            success = false;
+        }
+        success &= check_order(output[r], input, false, name);
+    }
+    return success;
+}
+
+bool check_lb(const output_t & output, const input_t & input)
+{
+    bool success = true;
+    std::set<std::pair<unsigned int, unsigned int>> seen;
+    for (int r = 0; r < N; ++r) {
+        for (const auto & d : output[r]) {
+            // the switches forward whichever head has a free output: no order
+            if (d.producer >= N || d.seq >= input[d.producer].size() || input[d.producer][d.seq].key != d.key) {
+                std::cerr << "Error: LB replica " << r << " received a tuple never sent (producer " << d.producer << ", seq " << d.seq << ")" << std::endl;
+                success = false;
+            } else if (!seen.insert(std::make_pair(d.producer, d.seq)).second) {
+                std::cerr << "Error: LB delivered seq " << d.seq << " of producer " << d.producer << " twice" << std::endl;
+                success = false;
+            }
+        }
+    }
+    if (seen.size() != count(input)) {
+        std::cerr << "Error: LB delivered " << seen.size() << " distinct tuples, expected " << count(input) << std::endl;
+        success = false;
+    }
+    return success;
+}
+
+bool check_kb(const output_t & output, const input_t & input)
+{
+    bool success = true;
+    size_t total = 0;
+    for (int r = 0; r < N; ++r) {
+        const std::string name = "KB replica " + std::to_string(r);
+        for (const auto & d : output[r]) {
+            if (d.key % N != unsigned(r)) {
+                std::cerr << "Error: " << name << " received key " << d.key << std::endl;
+                success = false;
+            }
+        }
+        success &= check_order(output[r], input, true, name);
+        total += output[r].size();
+    }
+    if (total != count(input)) {
+        std::cerr << "Error: KB delivered " << total << " tuples, expected " << count(input) << std::endl;
+        success = false;
+    }
+    return success;
+}
+
+void test(const input_t & input, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    stream_t br_in[N], br_out[N];
+    stream_t lb_in[N], lb_out[N];
+    stream_t kb_in[N], kb_out[N];
+
+    write_input(br_in, input);
+    write_input(lb_in, input);
+    write_input(kb_in, input);
+    kernel(br_in, br_out, lb_in, lb_out, kb_in, kb_out);
+
+    const output_t br = read_output(br_out);
+    const output_t lb = read_output(lb_out);
+    const output_t kb = read_output(kb_out);
+
+    #if _DEBUG
+    for (int r = 0; r < N; ++r) {
+        std::cout << "replica " << r << ": BR " << br[r].size() << ", LB " << lb[r].size() << ", KB " << kb[r].size() << std::endl;
+    }
+    #endif
+
+    bool success = true;
+    success &= check_br(br, input);
+    success &= check_lb(lb, input);
+    success &= check_kb(kb, input);
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test(generate_input(0, 1), "empty");
+    test(generate_input(1, 16), "single");
+    test(generate_input(256, 16), "uniform_keys");
+    test(generate_input(256, 4, N), "one_replica");
+
+    return 0;
+}
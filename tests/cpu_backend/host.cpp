@@ -0,0 +1,125 @@
+// End-to-end run of the tumbling_windows kernel on the CPU backend: batches
+// go through StreamGenerator, the memory_reader (WMtoS), the kernel, the
+// memory_writer (StoWM) and StreamDrainer, as on the card.
+//
+//     g++ -std=c++17 -DFX_CPU_BACKEND -pthread host.cpp ../tumbling_windows/kernel.cpp -o host
+
+#include "../tumbling_windows/kernel.hpp"
+#include "../../include/fspx_host.hpp"
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define _DEBUG 0
+
+static constexpr int LINE_BITS = 512;
+static constexpr size_t BATCH_SIZE = 1024;
+
+
+// keys in round robin, every key takes `per_window` tuples per timestamp
+std::vector<data_t> generate_input(int timestamps, int per_window)
+{
+    std::vector<data_t> data;
+    for (int t = 0; t < timestamps; ++t) {
+        for (int i = 0; i < per_window; ++i) {
+            for (unsigned int k = 0; k < MAX_KEYS; ++k) {
+                data.push_back(data_t(k, i, 0, t));
+            }
+        }
+    }
+    return data;
+}
+
+void test(const std::vector<data_t> & input, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+
+    in_stream_t in("in");
+    out_stream_t out("out");
+
+    fx::OCL ocl;
+    ocl.set_memory_reader(0, [&](void * batch, int count, int eos) {
+        fx::WMtoS<LINE_BITS>((ap_uint<LINE_BITS> *)batch, count, eos, in);
+    });
+    ocl.launch([&]() { ::test(in, out); });
+    ocl.set_memory_writer(0, [&](void * batch, int size, int * items_written, int * eos) {
+        fx::StoWM<LINE_BITS>(out, (ap_uint<LINE_BITS> *)batch, size, items_written, eos);
+    });
+
+    fx::StreamDrainer<data_t> drainer(ocl, BATCH_SIZE, 2);
+    drainer.prelaunch();
+
+    std::vector<data_t> output;
+    std::thread consumer([&]() {
+        bool last = false;
+        while (!last) {
+            size_t items = 0;
+            data_t * batch = drainer.pop(&items, &last);
+            output.insert(output.end(), batch, batch + items);
+            if (!last) {
+                drainer.put_batch(batch, BATCH_SIZE);
+            }
+        }
+    });
+
+    {
+        fx::StreamGenerator<data_t> generator(ocl, BATCH_SIZE, 2);
+        size_t i = 0;
+        do {
+            data_t * batch = generator.get_batch();
+            const size_t size = std::min(BATCH_SIZE, input.size() - i);
+            std::copy(input.begin() + i, input.begin() + i + size, batch);
+            i = i + size;
+            generator.push(batch, size, i == input.size());
+        } while (i < input.size());
+        generator.finish();
+    }
+
+    consumer.join();
+    drainer.finish();
+    ocl.finish();
+
+    // expected count of every (key, window)
+    std::map<std::pair<unsigned int, unsigned int>, float> expected;
+    for (const auto & d : input) {
+        expected[{d.key, d.timestamp / WINDOW_SIZE}] += 1;
+    }
+
+    bool success = true;
+    std::map<std::pair<unsigned int, unsigned int>, float> result;
+    for (const auto & d : output) {
+        #if _DEBUG
+        std::cout << std::setw(8) << d.key << ", " << std::setw(8) << d.aggregate << ", " << std::setw(8) << d.timestamp << std::endl;
+        #endif
+        result[{d.key, d.timestamp / WINDOW_SIZE}] += d.aggregate;
+    }
+    if (result != expected) {
+        std::cerr << "Error: expected " << expected.size() << " windows, but got " << result.size() << std::endl;
+        for (const auto & e : expected) {
+            if (result[e.first] != e.second) {
+                std::cerr << "Error: key " << e.first.first << " window " << e.first.second
+                          << " counted " << result[e.first] << " tuples, expected " << e.second << std::endl;
+                break;
+            }
+        }
+        success = false;
+    }
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test(generate_input(4, 1), "single_batch");
+    test(generate_input(64, 4), "many_batches");
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include "kernel.hpp"
+
+struct Joiner
+{
+    template <typename SHIPPER_T>
+    void operator()(const event_t & l, const event_t & r, SHIPPER_T & shipper) {
+    #pragma HLS INLINE
+        match_t m(l.key, l.value, r.value, l.timestamp, r.timestamp);
+        shipper.send(m);
+    }
+};
+
+void kernel(in_stream_t & left, in_stream_t & right, out_stream_t & out)
+{
+    #pragma HLS DATAFLOW
+
+    fx::KeyedIntervalJoin<Joiner, MAX_KEYS, JOIN_BUFFER, JOIN_LOWER, JOIN_UPPER>(
+        left, right, out,
+        [](const event_t & e) { return e.key; },
+        [](const event_t & e) { return e.key; }
+    );
+}
@@ -0,0 +1,42 @@
+#include "../../include/fspx.hpp"
+
+struct event_t {
+    unsigned int key;
+    float value;
+    unsigned int timestamp;
+
+    event_t() = default;
+
+    event_t(unsigned int key, float value, unsigned int timestamp)
+        : key(key), value(value), timestamp(timestamp)
+    {}
+};
+
+struct match_t {
+    unsigned int key;
+    float left_value;
+    float right_value;
+    unsigned int left_timestamp;
+    unsigned int right_timestamp;
+
+    match_t() = default;
+
+    match_t(unsigned int key, float left_value, float right_value, unsigned int left_timestamp, unsigned int right_timestamp)
+        : key(key), left_value(left_value), right_value(right_value), left_timestamp(left_timestamp), right_timestamp(right_timestamp)
+    {}
+};
+
+static constexpr int JOIN_LOWER = -2;
+static constexpr int JOIN_UPPER = 3;
+
+static constexpr unsigned int MAX_KEYS = 4;
+static constexpr unsigned int JOIN_BUFFER = 8;
+
+using in_stream_t = fx::axis_stream<event_t, 32>;
+using out_stream_t = fx::axis_stream<match_t, 32>;
+
+void kernel(
+    in_stream_t & left,
+    in_stream_t & right,
+    out_stream_t & out
+);
@@ -0,0 +1,140 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#define _DEBUG 0
+
+
+std::vector<event_t> generate_input(int n, int max_keys, int stride, float base)
+{
+    std::vector<event_t> data;
+    for (int i = 0; i < n; ++i) {
+        for (int k = 0; k < max_keys; ++k) {
+            data.push_back(event_t(k, base + i, i * stride));
+        }
+    }
+    return data;
+}
+
+// timestamps increase by 1 to max_step from a tuple to the next one, keys are
+// random: the stream is ordered by timestamp across keys
+std::vector<event_t> generate_input_random(int n, int max_keys, int max_step, int seed, float base)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<unsigned int> key_dist(0, max_keys - 1);
+    std::uniform_int_distribution<unsigned int> step_dist(1, max_step);
+
+    std::vector<event_t> data;
+    unsigned int timestamp = 0;
+    for (int i = 0; i < n; ++i) {
+        timestamp += step_dist(gen);
+        data.push_back(event_t(key_dist(gen), base + i, timestamp));
+    }
+    return data;
+}
+
+// reference nested-loop join; valid as long as a key has at most JOIN_BUFFER
+// tuples per side within the bounds of the join
+std::vector<match_t> expected_join(const std::vector<event_t> & left, const std::vector<event_t> & right)
+{
+    std::vector<match_t> result;
+    for (const auto & l : left) {
+        for (const auto & r : right) {
+            const long long lo = (long long)l.timestamp + JOIN_LOWER;
+            const long long hi = (long long)l.timestamp + JOIN_UPPER;
+            if (l.key == r.key && (long long)r.timestamp >= lo && (long long)r.timestamp <= hi) {
+                result.push_back(match_t(l.key, l.value, r.value, l.timestamp, r.timestamp));
+            }
+        }
+    }
+    return result;
+}
+
+void write_input(in_stream_t & in, const std::vector<event_t> & data)
+{
+    for (const auto & d : data) {
+        in.write(d);
+    }
+    in.write_eos();
+}
+
+std::vector<match_t> read_output(out_stream_t & out)
+{
+    std::vector<match_t> result;
+    bool last = out.read_eos();
+    while (!last) {
+        match_t m = out.read();
+        last = out.read_eos();
+        result.push_back(m);
+
+        #if _DEBUG
+        std::cout << std::setw(8) << m.key             << ", "
+                  << std::setw(8) << m.left_value      << ", "
+                  << std::setw(8) << m.right_value     << ", "
+                  << std::setw(8) << m.left_timestamp  << ", "
+                  << std::setw(8) << m.right_timestamp << std::endl;
+        #endif
+    }
+    return result;
+}
+
+bool check_results(const std::vector<match_t> data, const std::vector<match_t> expected)
+{
+    bool success = true;
+    if (data.size() != expected.size()) {
+        std::cerr << "Error: expected " << expected.size() << " elements, but got " << data.size() << std::endl;
+        success = false;
+    }
+
+    std::vector<match_t> expected_copy = expected;
+    for (const match_t d : data) {
+        auto it = std::find_if(expected_copy.begin(), expected_copy.end(), [&d](const match_t & e) {
+            return e.key == d.key && e.left_value == d.left_value && e.right_value == d.right_value;
+        });
+        if (it == expected_copy.end()) {
+            std::cerr << "Error: match {" << d.key << ", " << d.left_value << ", " << d.right_value << "} not found in expected results" << std::endl;
+            success = false;
+        } else {
+            expected_copy.erase(it);
+        }
+    }
+
+    return success;
+}
+
+void test(std::vector<event_t> left_data, std::vector<event_t> right_data, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    in_stream_t left("left");
+    in_stream_t right("right");
+    out_stream_t out("out");
+
+    write_input(left, left_data);
+    write_input(right, right_data);
+    kernel(left, right, out);
+    bool success = check_results(read_output(out), expected_join(left_data, right_data));
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, {}, "empty");
+    test(generate_input(10, 1, 1, 0), {}, "empty_right");
+    test(generate_input(10, 1, 1, 0), generate_input(10, 1, 1, 100), "single_key");
+    test(generate_input(10, MAX_KEYS, 1, 0), generate_input(10, MAX_KEYS, 2, 100), "multiple_keys");
+    test(generate_input_random(64, MAX_KEYS, 2, 42, 0), generate_input_random(64, MAX_KEYS, 2, 7, 1000), "random_multiple_keys");
+    // one side much faster than the other: the merge must wait for the slow
+    // side instead of running ahead of it
+    test(generate_input_random(512, MAX_KEYS, 1, 1, 0), generate_input_random(32, MAX_KEYS, 16, 2, 1000), "skewed_left");
+    test(generate_input_random(32, MAX_KEYS, 16, 3, 0), generate_input_random(512, MAX_KEYS, 1, 4, 1000), "skewed_right");
+
+    return 0;
+}
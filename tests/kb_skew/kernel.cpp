@@ -0,0 +1,10 @@
+#include "kernel.hpp"
+
+void kernel(stream_t & in, stream_t out[N])
+{
+    fx::StoSN_KB_skew<N, N, SLOTS, HOT_SHIFT, AGING_LOG>(
+        in, out,
+        [](const data_t & d) { return d.key; },
+        [](data_t & d, const bool split) { d.split = split; }
+    );
+}
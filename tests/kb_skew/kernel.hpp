@@ -0,0 +1,26 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int seq;
+    bool split;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int seq)
+        : key(key), seq(seq), split(false)
+    {}
+};
+
+static constexpr int N = 4;
+static constexpr int SLOTS = 16;
+static constexpr int HOT_SHIFT = 2;     // hot keys carry 1/4 of the traffic
+static constexpr int AGING_LOG = 8;
+
+using stream_t = fx::stream<data_t, 2>;
+
+// StoSN_KB_skew over N replicas, `split` is set on the tuples of hot keys
+void kernel(
+    stream_t & in,
+    stream_t out[N]
+);
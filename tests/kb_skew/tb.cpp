@@ -0,0 +1,218 @@
+#include "kernel.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <vector>
+
+#define _DEBUG 0
+
+static constexpr int KEYS = 64;
+static constexpr unsigned int AGING_PERIOD = 1u << AGING_LOG;
+
+using output_t = std::vector<std::vector<data_t>>;
+
+
+std::vector<data_t> generate_uniform(int n, unsigned int seed)
+{
+    fx::xorshift32_t rng(seed);
+
+    std::vector<data_t> data;
+    for (int i = 0; i < n; ++i) {
+        data.push_back(data_t(rng.next_below(KEYS), i));
+    }
+    return data;
+}
+
+std::vector<data_t> generate_zipf(int n, float s, unsigned int seed)
+{
+    fx::zipf_keys_t<KEYS> zipf(s, seed);
+
+    std::vector<data_t> data;
+    for (int i = 0; i < n; ++i) {
+        data.push_back(data_t(zipf.next(), i));
+    }
+    return data;
+}
+
+void write_input(stream_t & in, const std::vector<data_t> & data)
+{
+    for (const auto & d : data) {
+        in.write(d);
+    }
+    in.write_eos();
+}
+
+output_t read_output(stream_t out[N])
+{
+    output_t result(N);
+    for (int r = 0; r < N; ++r) {
+        bool last = out[r].read_eos();
+        while (!last) {
+            data_t d = out[r].read();
+            last = out[r].read_eos();
+            result[r].push_back(d);
+        }
+    }
+    return result;
+}
+
+// every tuple reaches one replica, in input order, and only the tuples of
+// hot keys leave the replica of their key
+bool check_delivery(const output_t & output, const std::vector<data_t> & input)
+{
+    bool success = true;
+    std::vector<int> seen(input.size(), 0);
+    for (int r = 0; r < N; ++r) {
+        long prev = -1;
+        for (const auto & d : output[r]) {
+            if (d.seq >= input.size() || input[d.seq].key != d.key) {
+                std::cerr << "Error: replica " << r << " received a tuple never sent (seq " << d.seq << ")" << std::endl;
+                success = false;
+                continue;
+            }
+            if (long(d.seq) <= prev) {
+                std::cerr << "Error: replica " << r << " received seq " << d.seq << " after " << prev << std::endl;
+                success = false;
+            }
+            if (!d.split && d.key % N != unsigned(r)) {
+                std::cerr << "Error: key " << d.key << " (seq " << d.seq << ") not split, but sent to replica " << r << std::endl;
+                success = false;
+            }
+            prev = d.seq;
+            seen[d.seq]++;
+        }
+    }
+    for (size_t i = 0; i < input.size(); ++i) {
+        if (seen[i] != 1) {
+            std::cerr << "Error: seq " << i << " delivered " << seen[i] << " times" << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+// the sketch overestimates a key by at most 1 / SLOTS of the traffic: a
+// tagged key carries at least 1 / 2^HOT_SHIFT - 1 / SLOTS of the input, and a
+// key above 1 / 2^HOT_SHIFT + 1 / SLOTS is split once the sketch is warm
+bool check_tags(const output_t & output, const std::vector<data_t> & input)
+{
+    std::map<unsigned int, size_t> frequency;
+    std::map<unsigned int, size_t> warm;
+    for (const auto & d : input) {
+        frequency[d.key]++;
+        if (d.seq >= AGING_PERIOD / 2) {
+            warm[d.key]++;
+        }
+    }
+
+    std::map<unsigned int, size_t> tagged;
+    std::map<unsigned int, std::vector<size_t>> spread;
+    for (int r = 0; r < N; ++r) {
+        for (const auto & d : output[r]) {
+            if (d.split) {
+                tagged[d.key]++;
+                spread[d.key].resize(N);
+                spread[d.key][r]++;
+            }
+        }
+    }
+
+    const double n = double(input.size());
+    const double hot = 1.0 / (1 << HOT_SHIFT);
+    const double error = 1.0 / SLOTS;
+
+    bool success = true;
+    for (const auto & kv : tagged) {
+        const double share = frequency[kv.first] / n;
+        if (share < hot - error) {
+            std::cerr << "Error: key " << kv.first << " carries " << share << " of the input, but "
+                      << kv.second << " of its tuples were split" << std::endl;
+            success = false;
+        }
+        for (int r = 0; r < N; ++r) {
+            if (spread[kv.first][r] == 0) {
+                std::cerr << "Error: the split key " << kv.first << " never reached replica " << r << std::endl;
+                success = false;
+            }
+        }
+    }
+    for (const auto & kv : frequency) {
+        if (kv.second / n >= hot + error && tagged[kv.first] < warm[kv.first]) {
+            std::cerr << "Error: key " << kv.first << " carries " << kv.second / n << " of the input, but only "
+                      << tagged[kv.first] << " of its " << warm[kv.first] << " tuples after the warm up were split" << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+// a key-by sends the hottest key to a single replica, the split keeps every
+// replica below it once the sketch is warm
+bool check_spread(const output_t & output, const std::vector<data_t> & input)
+{
+    if (input.size() < AGING_PERIOD) {
+        return true;
+    }
+
+    std::map<unsigned int, size_t> frequency;
+    size_t hottest = 0;
+    for (const auto & d : input) {
+        hottest = std::max(hottest, ++frequency[d.key]);
+    }
+
+    bool success = true;
+    for (int r = 0; r < N; ++r) {
+        if (hottest * 2 > input.size() && output[r].size() >= hottest) {
+            std::cerr << "Error: replica " << r << " received " << output[r].size() << " tuples, the hottest key alone has "
+                      << hottest << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+void test(const std::vector<data_t> & input, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    stream_t in("in");
+    stream_t out[N];
+
+    write_input(in, input);
+    kernel(in, out);
+    const output_t output = read_output(out);
+
+    #if _DEBUG
+    for (int r = 0; r < N; ++r) {
+        size_t split = 0;
+        for (const auto & d : output[r]) {
+            split += d.split;
+        }
+        std::cout << "replica " << r << ": " << std::setw(6) << output[r].size() << " tuples, " << std::setw(6) << split << " split" << std::endl;
+    }
+    #endif
+
+    bool success = true;
+    success &= check_delivery(output, input);
+    success &= check_tags(output, input);
+    success &= check_spread(output, input);
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, "empty");
+    test(generate_uniform(1, 1), "single");
+    test(generate_uniform(4096, 1), "uniform_keys");
+    // key 0 carries ~60% of the traffic, key 1 ~15%
+    test(generate_zipf(4096, 2.0f, 1), "zipf");
+    test(generate_zipf(4096, 2.0f, 7), "zipf_other_seed");
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Round trips of LatencyTracker stamps, from stamp (generator side) to record
+// (drainer side), with explicit times: STAMP_TIME and STAMP_SEQUENCE, with a
+// 16-bit field that wraps around between the stamp and the record.
+//
+//     g++ -std=c++17 -pthread host.cpp -o host
+
+#include "../../include/host/latency_tracker.hpp"
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+static constexpr uint64_t RESOLUTION = 1000;
+
+struct data_t {
+    unsigned int key;
+    uint32_t stamp;
+};
+
+struct small_data_t {
+    unsigned int key;
+    uint16_t stamp;
+};
+
+
+// the histogram of a Metric has a relative error below 1%
+bool check(fx::LatencyTracker & latency, const uint64_t samples, const uint64_t expired, const double max_ns, const std::string & name)
+{
+    fx::Metric m = latency.metric();
+
+    bool success = true;
+    if (latency.recorded != samples || m.getN() != samples) {
+        std::cerr << "Error: " << name << " recorded " << latency.recorded << " latencies ("
+                  << m.getN() << " in the metric), expected " << samples << std::endl;
+        success = false;
+    }
+    if (latency.expired != expired) {
+        std::cerr << "Error: " << name << " expired " << latency.expired << " stamps, expected " << expired << std::endl;
+        success = false;
+    }
+    if (samples > 0 && std::fabs(m.max() - max_ns) > max_ns * 0.01) {
+        std::cerr << "Error: " << name << " measured a max latency of " << m.max() << " ns, expected " << max_ns << std::endl;
+        success = false;
+    }
+    return success;
+}
+
+void report(const bool success, const std::string & test_name)
+{
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+// one tuple out of 16 is stamped at 5 units and recorded at 12 units
+void test_time(std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    fx::MetricGroup group;
+    fx::LatencyTracker latency("latency", 16, fx::STAMP_TIME, RESOLUTION, 4096, 0, group);
+
+    std::vector<data_t> batch(256);
+    latency.stamp(batch.data(), batch.size(), &data_t::stamp, latency.epoch + 5 * RESOLUTION);
+
+    bool success = true;
+    size_t stamped = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].stamp != 0) {
+            stamped++;
+            if (i % 16 != 0) {
+                std::cerr << "Error: tuple " << i << " stamped" << std::endl;
+                success = false;
+            }
+        }
+    }
+    if (stamped != 16 || latency.stamped != 16) {
+        std::cerr << "Error: " << stamped << " tuples stamped, expected 16" << std::endl;
+        success = false;
+    }
+
+    latency.record(batch.data(), batch.size(), &data_t::stamp, latency.epoch + 12 * RESOLUTION);
+    success &= check(latency, 16, 0, 7 * RESOLUTION, "STAMP_TIME");
+    report(success, test_name);
+}
+
+// a 16-bit field wraps around after 65535 units: stamped 2 units before the
+// wrap and recorded 3 units after it
+void test_time_wrap(std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    fx::MetricGroup group;
+    fx::LatencyTracker latency("latency", 1, fx::STAMP_TIME, RESOLUTION, 4096, 0, group);
+
+    const uint64_t range = fx::LatencyTracker::range<uint16_t>();
+    std::vector<small_data_t> batch(4);
+    latency.stamp(batch.data(), batch.size(), &small_data_t::stamp, latency.epoch + (range - 2) * RESOLUTION);
+
+    bool success = true;
+    for (const auto & d : batch) {
+        if (d.stamp == 0) {
+            std::cerr << "Error: a tuple was not stamped" << std::endl;
+            success = false;
+        }
+    }
+
+    latency.record(batch.data(), batch.size(), &small_data_t::stamp, latency.epoch + (range + 3) * RESOLUTION);
+    success &= check(latency, batch.size(), 0, 5 * RESOLUTION, "STAMP_TIME across the wrap");
+    report(success, test_name);
+}
+
+// more batches than a 16-bit field can number: every stamp is found in the
+// history until `history` more batches are pushed
+void test_sequence_wrap(std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    fx::MetricGroup group;
+    fx::LatencyTracker latency("latency", 1, fx::STAMP_SEQUENCE, RESOLUTION, 4, 0, group);
+
+    const uint64_t range = fx::LatencyTracker::range<uint16_t>();
+    const uint64_t batches = 2 * range + 10;
+
+    bool success = true;
+    uint64_t now = latency.epoch;
+    for (uint64_t b = 0; b < batches && success; ++b) {
+        small_data_t d;
+        latency.stamp(&d, 1, &small_data_t::stamp, now);
+        if (d.stamp == 0) {
+            std::cerr << "Error: batch " << b << " got a 0 stamp" << std::endl;
+            success = false;
+        }
+        latency.record(&d, 1, &small_data_t::stamp, now + (b % 7 + 1) * RESOLUTION);
+        now += RESOLUTION;
+    }
+    success &= check(latency, batches, 0, 7 * RESOLUTION, "STAMP_SEQUENCE across the wrap");
+
+    // the first of 5 batches is out of a history of 4
+    std::vector<small_data_t> pending(5);
+    for (auto & d : pending) {
+        latency.stamp(&d, 1, &small_data_t::stamp, now);
+    }
+    latency.record(pending.data(), pending.size(), &small_data_t::stamp, now + RESOLUTION);
+    success &= check(latency, batches + 4, 1, 7 * RESOLUTION, "STAMP_SEQUENCE history");
+    report(success, test_name);
+}
+
+int main() {
+
+    test_time("time");
+    test_time_wrap("time_wrap");
+    test_sequence_wrap("sequence_wrap");
+
+    return 0;
+}
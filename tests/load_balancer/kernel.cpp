@@ -0,0 +1,18 @@
+#include "kernel.hpp"
+
+void kernel(
+    stream_t & lb_in,
+    stream_t lb_out[N],
+    stream_t merge_in[N],
+    stream_t & merge_out,
+    stream_t merge_m_in[N][M],
+    stream_t & merge_m_out
+)
+{
+    #pragma HLS DATAFLOW
+
+    FX_DATAFLOW;
+    FX_PROCESS(fx::StoSN_LB<N>(lb_in, lb_out));
+    FX_PROCESS(fx::SNtoS_LB<N>(merge_in, merge_out));
+    FX_PROCESS(fx::SNMtoS_LB<N, M>(merge_m_in, merge_m_out, M - 1));
+}
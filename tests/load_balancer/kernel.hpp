@@ -0,0 +1,28 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int producer;
+    unsigned int seq;
+
+    data_t() = default;
+
+    data_t(unsigned int producer, unsigned int seq)
+        : producer(producer), seq(seq)
+    {}
+};
+
+static constexpr int N = 5;
+static constexpr int M = 2;
+
+using stream_t = fx::stream<data_t, 2>;
+
+// StoSN_LB over N replicas, SNtoS_LB and SNMtoS_LB (on the last of M
+// streams per source) from N independent sources
+void kernel(
+    stream_t & lb_in,
+    stream_t lb_out[N],
+    stream_t merge_in[N],
+    stream_t & merge_out,
+    stream_t merge_m_in[N][M],
+    stream_t & merge_m_out
+);
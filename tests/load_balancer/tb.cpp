@@ -0,0 +1,246 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define _DEBUG 0
+
+using input_t = std::vector<std::vector<data_t>>;
+using output_t = std::vector<std::vector<data_t>>;
+
+
+std::vector<data_t> generate_input(int n, unsigned int producer = 0)
+{
+    std::vector<data_t> data;
+    for (int i = 0; i < n; ++i) {
+        data.push_back(data_t(producer, i));
+    }
+    return data;
+}
+
+void write_input(stream_t & in, const std::vector<data_t> & data)
+{
+    for (const auto & d : data) {
+        in.write(d);
+    }
+    in.write_eos();
+}
+
+std::vector<data_t> read_output(stream_t & out)
+{
+    std::vector<data_t> result;
+    bool last = out.read_eos();
+    while (!last) {
+        data_t d = out.read();
+        last = out.read_eos();
+        result.push_back(d);
+    }
+    return result;
+}
+
+// every tuple reaches one replica, in input order; no replica is ever full in
+// csim, so the first ready replica after the last served is the next one and
+// tuple i goes to replica i % N
+bool check_lb(const output_t & output, const std::vector<data_t> & input)
+{
+    bool success = true;
+    std::vector<int> seen(input.size(), 0);
+    for (int r = 0; r < N; ++r) {
+        long prev = -1;
+        for (const auto & d : output[r]) {
+            if (d.seq >= input.size()) {
+                std::cerr << "Error: replica " << r << " received a tuple never sent (seq " << d.seq << ")" << std::endl;
+                success = false;
+                continue;
+            }
+            if (long(d.seq) <= prev) {
+                std::cerr << "Error: replica " << r << " received seq " << d.seq << " after " << prev << std::endl;
+                success = false;
+            }
+            if (d.seq % N != unsigned(r)) {
+                std::cerr << "Error: seq " << d.seq << " sent to replica " << r << ", expected " << d.seq % N << std::endl;
+                success = false;
+            }
+            prev = d.seq;
+            seen[d.seq]++;
+        }
+    }
+    for (size_t i = 0; i < input.size(); ++i) {
+        if (seen[i] != 1) {
+            std::cerr << "Error: seq " << i << " delivered " << seen[i] << " times" << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+// every source has its tuples and then its eos ready in csim: the merge
+// takes one step of each unfinished source in turn, starting from source 0,
+// and the step that reads the eos emits nothing
+std::vector<data_t> expected_merge(const input_t & sources)
+{
+    std::vector<data_t> result;
+    std::vector<size_t> next(N, 0);
+    std::vector<bool> ended(N, false);
+    int remaining = N;
+    while (remaining > 0) {
+        for (int s = 0; s < N; ++s) {
+            if (ended[s]) continue;
+            if (next[s] < sources[s].size()) {
+                result.push_back(sources[s][next[s]++]);
+            } else {
+                ended[s] = true;
+                remaining--;
+            }
+        }
+    }
+    return result;
+}
+
+bool check_merge(const std::vector<data_t> & output, const input_t & sources, const std::string & name)
+{
+    const std::vector<data_t> expected = expected_merge(sources);
+    for (size_t i = 0; i < output.size() && i < expected.size(); ++i) {
+        if (output[i].producer != expected[i].producer || output[i].seq != expected[i].seq) {
+            std::cerr << "Error: " << name << " emitted seq " << output[i].seq << " of source " << output[i].producer
+                      << " at position " << i << ", expected seq " << expected[i].seq << " of source "
+                      << expected[i].producer << std::endl;
+            return false;
+        }
+    }
+    if (output.size() != expected.size()) {
+        std::cerr << "Error: " << name << " emitted " << output.size() << " tuples, expected " << expected.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// reference of first_from: first bit set at or after `start`, wrapping around
+template <int W>
+bool first_from_reference(const ap_uint<W> mask, const int start, int & index)
+{
+    for (int i = 0; i < W; ++i) {
+        const int j = (start + i) % W;
+        if (mask[j]) {
+            index = j;
+            return true;
+        }
+    }
+    return false;
+}
+
+// random masks with one bit out of `density` set, from every start: above
+// G = 16 inputs the arbiter is hierarchical
+template <int W>
+bool check_first_from(const unsigned int density, const int masks)
+{
+    fx::xorshift32_t rng(W * density);
+
+    bool success = true;
+    for (int k = 0; k < masks && success; ++k) {
+        ap_uint<W> mask = 0;
+        for (int i = 0; i < W; ++i) {
+            mask[i] = (rng.next_below(density) == 0);
+        }
+        for (int start = 0; start < W; ++start) {
+            int index = -1;
+            int expected = -1;
+            const bool found = fx::first_from<W>(mask, start, index);
+            const bool expected_found = first_from_reference<W>(mask, start, expected);
+            if (found != expected_found || (found && index != expected)) {
+                std::cerr << "Error: first_from<" << W << "> of mask " << k << " (1 bit out of " << density << ") from "
+                          << start << " returned " << index << ", expected " << expected << std::endl;
+                success = false;
+                break;
+            }
+        }
+    }
+    return success;
+}
+
+void test_first_from(std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+
+    bool success = true;
+    for (const unsigned int density : {1u, 2u, 8u, 64u}) {
+        success &= check_first_from<N>(density, 64);
+        success &= check_first_from<16>(density, 64);
+        success &= check_first_from<17>(density, 64);
+        success &= check_first_from<40>(density, 64);
+        success &= check_first_from<64>(density, 64);
+        success &= check_first_from<300>(density, 16);
+    }
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+void test(const std::vector<data_t> & input, const input_t & sources, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    stream_t lb_in("lb_in");
+    stream_t lb_out[N];
+    stream_t merge_in[N];
+    stream_t merge_out("merge_out");
+    stream_t merge_m_in[N][M];
+    stream_t merge_m_out("merge_m_out");
+
+    write_input(lb_in, input);
+    for (int s = 0; s < N; ++s) {
+        write_input(merge_in[s], sources[s]);
+        write_input(merge_m_in[s][M - 1], sources[s]);
+    }
+    kernel(lb_in, lb_out, merge_in, merge_out, merge_m_in, merge_m_out);
+
+    output_t output(N);
+    for (int r = 0; r < N; ++r) {
+        output[r] = read_output(lb_out[r]);
+    }
+    const std::vector<data_t> merged = read_output(merge_out);
+    const std::vector<data_t> merged_m = read_output(merge_m_out);
+
+    #if _DEBUG
+    for (int r = 0; r < N; ++r) {
+        std::cout << "replica " << r << ": " << std::setw(6) << output[r].size() << " tuples" << std::endl;
+    }
+    #endif
+
+    bool success = true;
+    success &= check_lb(output, input);
+    success &= check_merge(merged, sources, "SNtoS_LB");
+    success &= check_merge(merged_m, sources, "SNMtoS_LB");
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+input_t generate_sources(const std::vector<int> & sizes)
+{
+    input_t data;
+    for (int s = 0; s < N; ++s) {
+        data.push_back(generate_input(sizes[s], s));
+    }
+    return data;
+}
+
+int main() {
+
+    test_first_from("first_from");
+
+    test({}, generate_sources({0, 0, 0, 0, 0}), "empty");
+    test(generate_input(1), generate_sources({0, 0, 1, 0, 0}), "single");
+    test(generate_input(N - 1), generate_sources({1, 2, 3, 4, 5}), "fewer_than_replicas");
+    // sources that end early leave the rotation
+    test(generate_input(1000), generate_sources({300, 0, 17, 300, 1}), "many");
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "kernel.hpp"
+
+struct Enricher
+{
+    void operator()(const event_t & in, const row_t & row, const bool found, enriched_t & out) {
+    #pragma HLS INLINE
+        out.key = in.key;
+        out.value = in.value;
+        out.attribute = found ? row.attribute : -1.0f;
+        out.found = found;
+        out.timestamp = in.timestamp;
+    }
+};
+
+void kernel(in_stream_t & in, table_stream_t & table, out_stream_t & out, count_stream_t & evictions)
+{
+    #pragma HLS DATAFLOW
+
+    fx::LookupJoinEvictions<Enricher, TABLE_SIZE, HASH_WAYS, true, hash_t>(
+        in, table, out, evictions,
+        [](const event_t & e) { return e.key; },
+        [](const row_t & r) { return r.key; }
+    );
+}
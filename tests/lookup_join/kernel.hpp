@@ -0,0 +1,48 @@
+#include "../../include/fspx.hpp"
+
+struct event_t {
+    unsigned int key;
+    float value;
+    unsigned int timestamp;
+
+    event_t() = default;
+
+    event_t(unsigned int key, float value, unsigned int timestamp)
+        : key(key), value(value), timestamp(timestamp)
+    {}
+};
+
+struct row_t {
+    unsigned int key;
+    float attribute;
+
+    row_t() = default;
+
+    row_t(unsigned int key, float attribute)
+        : key(key), attribute(attribute)
+    {}
+};
+
+struct enriched_t {
+    unsigned int key;
+    float value;
+    float attribute;
+    unsigned int found;
+    unsigned int timestamp;
+};
+
+static constexpr unsigned int TABLE_SIZE = 64;
+static constexpr unsigned int HASH_WAYS = 4;
+
+using in_stream_t = fx::axis_stream<event_t, 32>;
+using table_stream_t = fx::axis_stream<row_t, 32>;
+using out_stream_t = fx::axis_stream<enriched_t, 32>;
+using count_stream_t = fx::axis_stream<unsigned int, 2>;
+using hash_t = fx::multiply_shift_hash_t;
+
+void kernel(
+    in_stream_t & in,
+    table_stream_t & table,
+    out_stream_t & out,
+    count_stream_t & evictions
+);
@@ -0,0 +1,197 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <map>
+#include <deque>
+#include <algorithm>
+
+#define _DEBUG 0
+
+
+std::vector<row_t> generate_table(int n, int stride)
+{
+    std::vector<row_t> table;
+    for (int i = 0; i < n; ++i) {
+        table.push_back(row_t(i * stride, i * 10.0f));
+    }
+    return table;
+}
+
+// `n` keys that fall in the same set of the table
+std::vector<row_t> generate_table_same_set(int n)
+{
+    const hash_t hash;
+    std::vector<row_t> table;
+    for (unsigned int key = 0; (int)table.size() < n; ++key) {
+        if (hash.index<TABLE_SIZE / HASH_WAYS>(key) == 0) {
+            table.push_back(row_t(key, key * 10.0f));
+        }
+    }
+    return table;
+}
+
+std::vector<event_t> keys_of(const std::vector<row_t> & table)
+{
+    std::vector<event_t> data;
+    for (size_t i = 0; i < table.size(); ++i) {
+        data.push_back(event_t(table[i].key, i, i));
+    }
+    return data;
+}
+
+std::vector<event_t> generate_input_random(int n, int max_key, int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<unsigned int> key_dist(0, max_key);
+
+    std::vector<event_t> data;
+    for (int i = 0; i < n; ++i) {
+        data.push_back(event_t(key_dist(gen), i, i));
+    }
+    return data;
+}
+
+template <typename STREAM_T, typename T>
+void write_input(STREAM_T & strm, const std::vector<T> & data)
+{
+    for (const auto & d : data) {
+        strm.write(d);
+    }
+    strm.write_eos();
+}
+
+std::vector<enriched_t> read_output(out_stream_t & out)
+{
+    std::vector<enriched_t> result;
+    bool last = out.read_eos();
+    while (!last) {
+        enriched_t r = out.read();
+        last = out.read_eos();
+        result.push_back(r);
+
+        #if _DEBUG
+        std::cout << std::setw(8) << r.key       << ", "
+                  << std::setw(8) << r.value     << ", "
+                  << std::setw(8) << r.attribute << ", "
+                  << std::setw(8) << r.found     << std::endl;
+        #endif
+    }
+    return result;
+}
+
+// reference table: every set keeps its last HASH_WAYS keys in order of
+// insertion, a new key in a full set evicts the oldest one
+struct reference_table_t
+{
+    std::map<unsigned int, std::deque<row_t>> sets;
+    unsigned int evictions = 0;
+
+    reference_table_t(const std::vector<row_t> & table)
+    {
+        const hash_t hash;
+        for (const auto & r : table) {
+            auto & set = sets[hash.index<TABLE_SIZE / HASH_WAYS>(r.key)];
+            auto it = std::find_if(set.begin(), set.end(), [&r](const row_t & e) { return e.key == r.key; });
+            if (it != set.end()) {
+                *it = r;
+                continue;
+            }
+            if (set.size() == HASH_WAYS) {
+                set.pop_front();
+                evictions++;
+            }
+            set.push_back(r);
+        }
+    }
+
+    bool find(const unsigned int key, float & attribute) const
+    {
+        for (const auto & set : sets) {
+            for (const auto & r : set.second) {
+                if (r.key == key) {
+                    attribute = r.attribute;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+bool check_results(const std::vector<event_t> & input, const std::vector<row_t> & table, const std::vector<enriched_t> & output, unsigned int evictions)
+{
+    // the last row inserted for a key wins, unless evicted
+    const reference_table_t reference(table);
+
+    if (input.size() != output.size()) {
+        std::cerr << "Error: expected " << input.size() << " elements, but got " << output.size() << std::endl;
+        return false;
+    }
+
+    bool success = true;
+    if (evictions != reference.evictions) {
+        std::cerr << "Error: expected " << reference.evictions << " evictions, but got " << evictions << std::endl;
+        success = false;
+    }
+
+    for (size_t i = 0; i < input.size(); ++i) {
+        float attribute = -1.0f;
+        const bool found = reference.find(input[i].key, attribute);
+
+        if (output[i].key != input[i].key || output[i].value != input[i].value ||
+            (bool)output[i].found != found || output[i].attribute != attribute) {
+            std::cerr << "Error: element " << i << " {" << output[i].key << ", " << output[i].attribute << ", " << output[i].found
+                      << "} expected {" << input[i].key << ", " << attribute << ", " << found << "}" << std::endl;
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+void test(std::vector<event_t> input_data, std::vector<row_t> table_data, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    in_stream_t in("in");
+    table_stream_t table("table");
+    out_stream_t out("out");
+    count_stream_t evictions("evictions");
+
+    write_input(in, input_data);
+    write_input(table, table_data);
+    kernel(in, table, out, evictions);
+    std::vector<enriched_t> output = read_output(out);
+    bool success = check_results(input_data, table_data, output, evictions.read());
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, {}, "empty");
+    test(generate_input_random(32, 16, 42), {}, "empty_table");
+    test(generate_input_random(128, 64, 42), generate_table(32, 1), "dense_keys");
+    test(generate_input_random(128, 2 * TABLE_SIZE, 42), generate_table(TABLE_SIZE, 1), "full_table");
+
+    // update existing keys: the second row for a key replaces the first one
+    std::vector<row_t> table_updates = generate_table(16, 1);
+    for (int i = 0; i < 16; i += 2) {
+        table_updates.push_back(row_t(i, 1000.0f + i));
+    }
+    test(generate_input_random(64, 32, 7), table_updates, "updates");
+
+    // twice as many keys as ways in a single set, then a few keys spread over
+    // the table: the first HASH_WAYS keys of the set are evicted
+    std::vector<row_t> overflow = generate_table_same_set(2 * HASH_WAYS);
+    std::vector<row_t> others = generate_table(8, 1000);
+    overflow.insert(overflow.end(), others.begin(), others.end());
+    test(keys_of(overflow), overflow, "set_overflow");
+
+    return 0;
+}
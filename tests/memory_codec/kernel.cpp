@@ -0,0 +1,6 @@
+#include "kernel.hpp"
+
+void kernel(in_stream_t & in, line_t * out, int out_size, int * items_written, int * eos)
+{
+    fx::StoWM_codec<LINE_BITS, codec_t, BURST_LENGTH>(in, out, out_size, items_written, eos);
+}
@@ -0,0 +1,38 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int value;
+    unsigned int timestamp;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int value, unsigned int timestamp)
+        : key(key), value(value), timestamp(timestamp)
+    {}
+};
+
+// 4 + 16 + 8 = 28 bits per record, 4 records per line
+using codec_t = fx::record_codec_t<
+    data_t,
+    fx::field_codec_t<&data_t::key, fx::for_codec_t<unsigned int, 4>>,
+    fx::field_codec_t<&data_t::value, fx::raw_codec_t<unsigned int, 16>>,
+    fx::field_codec_t<&data_t::timestamp, fx::delta_codec_t<unsigned int, 8>>
+>;
+
+static constexpr int LINE_BITS = 128;
+static constexpr int BURST_LENGTH = 4;
+static constexpr int BUFFER_LINES = 16;
+static constexpr int BUFFER_SIZE = BUFFER_LINES * (LINE_BITS / 8);  // bytes
+static constexpr int BUFFER_ITEMS = 1 + (BUFFER_LINES - 1) * (LINE_BITS / codec_t::BITS);
+
+using line_t = ap_uint<LINE_BITS>;
+using in_stream_t = fx::axis_stream<data_t, 32>;
+
+void kernel(
+    in_stream_t & in,
+    line_t * out,
+    int out_size,
+    int * items_written,
+    int * eos
+);
@@ -0,0 +1,100 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define _DEBUG 0
+
+
+std::vector<data_t> generate_input(int n)
+{
+    std::vector<data_t> data;
+    unsigned int timestamp = 0;
+    for (int i = 0; i < n; ++i) {
+        timestamp += i % 7;
+        data.push_back(data_t(i % 16, (i * 37) % 65536, timestamp));
+    }
+    return data;
+}
+
+void write_input(in_stream_t & in, const std::vector<data_t> & data)
+{
+    for (const auto & d : data) {
+        in.write(d);
+    }
+    in.write_eos();
+}
+
+// invokes the kernel, one buffer at a time, until it returns eos, and
+// decodes every buffer with WMtoS_codec
+std::vector<data_t> drain(in_stream_t & in, int & invocations)
+{
+    std::vector<data_t> result;
+    line_t buffer[BUFFER_LINES];
+    int items_written = 0;
+    int eos = 0;
+
+    invocations = 0;
+    while (!eos) {
+        kernel(in, buffer, BUFFER_SIZE, &items_written, &eos);
+        invocations++;
+
+        #if _DEBUG
+        std::cout << "invocation " << invocations << ": " << items_written << " items, eos " << eos << std::endl;
+        #endif
+
+        fx::stream<data_t, BUFFER_ITEMS> out("out");
+        fx::WMtoS_codec<LINE_BITS, codec_t>(buffer, items_written, false, out);
+        for (int i = 0; i < items_written; ++i) {
+            result.push_back(out.read());
+        }
+    }
+    return result;
+}
+
+void test(const std::vector<data_t> & input, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    in_stream_t in("in");
+
+    write_input(in, input);
+    int invocations = 0;
+    std::vector<data_t> output = drain(in, invocations);
+
+    bool success = true;
+    if (output.size() != input.size()) {
+        std::cerr << "Error: expected " << input.size() << " elements, but got " << output.size() << std::endl;
+        success = false;
+    }
+    for (size_t i = 0; i < output.size() && i < input.size(); ++i) {
+        if (output[i].key != input[i].key || output[i].value != input[i].value || output[i].timestamp != input[i].timestamp) {
+            std::cerr << "Error: element " << i << " not decoded" << std::endl;
+            success = false;
+        }
+    }
+    // a full buffer leaves the eos to the next invocation
+    const int expected = input.size() / BUFFER_ITEMS + 1;
+    if (invocations != expected) {
+        std::cerr << "Error: expected " << expected << " invocations, but got " << invocations << std::endl;
+        success = false;
+    }
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, "empty");
+    test(generate_input(1), "single");
+    test(generate_input(BUFFER_ITEMS - 1), "partial_buffer");
+    test(generate_input(BUFFER_ITEMS), "full_buffer");
+    test(generate_input(2 * BUFFER_ITEMS), "two_full_buffers");
+    test(generate_input(3 * BUFFER_ITEMS + 17), "multiple_buffers");
+
+    return 0;
+}
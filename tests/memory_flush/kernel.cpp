@@ -0,0 +1,6 @@
+#include "kernel.hpp"
+
+void kernel(in_stream_t & in, line_t * out, int out_size, int * items_written, int * eos, int idle_cycles)
+{
+    fx::StoWM<LINE_BITS, BURST_LENGTH>(in, out, out_size, items_written, eos, idle_cycles);
+}
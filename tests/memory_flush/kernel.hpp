@@ -0,0 +1,33 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int value;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int value)
+        : key(key), value(value)
+    {}
+};
+
+static constexpr int LINE_BITS = 128;
+static constexpr int LINE_ITEMS = LINE_BITS / (8 * sizeof(data_t));
+static constexpr int BURST_LENGTH = 4;
+static constexpr int BUFFER_LINES = 16;
+static constexpr int BUFFER_SIZE = BUFFER_LINES * (LINE_BITS / 8);  // bytes
+static constexpr int BUFFER_ITEMS = BUFFER_LINES * LINE_ITEMS;
+
+using line_t = ap_uint<LINE_BITS>;
+using in_stream_t = fx::stream<data_t, 256>;
+
+// StoWM with a flush timeout: a buffer is returned without eos once no item
+// arrives for idle_cycles polls
+void kernel(
+    in_stream_t & in,
+    line_t * out,
+    int out_size,
+    int * items_written,
+    int * eos,
+    int idle_cycles
+);
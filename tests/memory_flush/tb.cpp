@@ -0,0 +1,151 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define _DEBUG 0
+
+static constexpr int IDLE_CYCLES = 8;
+
+
+// the items of the input arrive in chunks, with the stream idle in between
+std::vector<std::vector<data_t>> generate_input(const std::vector<int> & chunks)
+{
+    std::vector<std::vector<data_t>> data;
+    unsigned int key = 0;
+    for (const int n : chunks) {
+        std::vector<data_t> chunk;
+        for (int i = 0; i < n; ++i, ++key) {
+            chunk.push_back(data_t(key, key * 37));
+        }
+        data.push_back(chunk);
+    }
+    return data;
+}
+
+// one invocation of the kernel, its buffer decoded with WMtoS
+std::vector<data_t> invoke(in_stream_t & in, int & eos)
+{
+    line_t buffer[BUFFER_LINES];
+    int items_written = 0;
+    eos = 0;
+
+    kernel(in, buffer, BUFFER_SIZE, &items_written, &eos, IDLE_CYCLES);
+
+    #if _DEBUG
+    std::cout << "invocation: " << items_written << " items, eos " << eos << std::endl;
+    #endif
+
+    fx::stream<data_t, BUFFER_ITEMS> out("out");
+    fx::WMtoS<LINE_BITS>(buffer, (items_written + LINE_ITEMS - 1) / LINE_ITEMS, false, out);
+    std::vector<data_t> result;
+    for (int i = 0; i < items_written; ++i) {
+        result.push_back(out.read());
+    }
+    return result;
+}
+
+// every chunk is drained before the next one is written: the kernel returns
+// the items of the chunk without eos once the input is idle, the eos comes
+// with the last chunk (`eos_with_last`) or alone, after it
+void test(const std::vector<int> & chunks, const bool eos_with_last, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    in_stream_t in("in");
+
+    const std::vector<std::vector<data_t>> input = generate_input(chunks);
+
+    bool success = true;
+    std::vector<data_t> expected;
+    std::vector<data_t> output;
+    int eos = 0;
+    int partials = 0;
+
+    for (size_t c = 0; c < input.size() && success; ++c) {
+        for (const auto & d : input[c]) {
+            in.write(d);
+            expected.push_back(d);
+        }
+        const bool last = eos_with_last && (c + 1 == input.size());
+        if (last) {
+            in.write_eos();
+        }
+
+        // a full buffer leaves the flag of the next item to the next
+        // invocation, an idle input returns a partial buffer
+        while (output.size() < expected.size() && success) {
+            const std::vector<data_t> result = invoke(in, eos);
+            output.insert(output.end(), result.begin(), result.end());
+
+            if (result.empty() && !eos) {
+                std::cerr << "Error: an invocation returned no item and no eos, " << output.size()
+                          << " of " << expected.size() << " items drained" << std::endl;
+                success = false;
+            }
+            if (eos && (!last || output.size() != expected.size())) {
+                std::cerr << "Error: eos returned after " << output.size() << " of "
+                          << expected.size() << " items" << std::endl;
+                success = false;
+            }
+            if (!eos && result.size() < size_t(BUFFER_ITEMS)) {
+                partials++;
+            }
+        }
+    }
+
+    if (success && !eos) {
+        in.write_eos();
+        const std::vector<data_t> result = invoke(in, eos);
+        if (!result.empty() || !eos) {
+            std::cerr << "Error: the last invocation returned " << result.size() << " items and eos " << eos
+                      << ", expected only the eos" << std::endl;
+            success = false;
+        }
+        output.insert(output.end(), result.begin(), result.end());
+    }
+
+    if (output.size() != expected.size()) {
+        std::cerr << "Error: expected " << expected.size() << " elements, but got " << output.size() << std::endl;
+        success = false;
+    }
+    for (size_t i = 0; i < output.size() && i < expected.size(); ++i) {
+        if (output[i].key != expected[i].key || output[i].value != expected[i].value) {
+            std::cerr << "Error: element " << i << " is " << output[i].key << ", expected " << expected[i].key << std::endl;
+            success = false;
+            break;
+        }
+    }
+    // every chunk that does not end on a buffer boundary is flushed
+    int expected_partials = 0;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        const bool last = eos_with_last && (c + 1 == chunks.size());
+        if (!last && chunks[c] % BUFFER_ITEMS != 0) {
+            expected_partials++;
+        }
+    }
+    if (partials != expected_partials) {
+        std::cerr << "Error: " << partials << " partial buffers returned without eos, expected "
+                  << expected_partials << std::endl;
+        success = false;
+    }
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, false, "empty");
+    test({1}, false, "single");
+    test({1}, true, "single_with_eos");
+    test({3, 1, 5, 2}, false, "sparse");
+    test({LINE_ITEMS, BUFFER_ITEMS - 1, 1}, false, "line_and_buffer_ends");
+    test({BUFFER_ITEMS, 2 * BUFFER_ITEMS}, false, "full_buffers");
+    test({BUFFER_ITEMS + 3, 7, 2 * BUFFER_ITEMS + 1}, true, "sparse_with_eos");
+
+    return 0;
+}
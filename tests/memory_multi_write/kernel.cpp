@@ -0,0 +1,6 @@
+#include "kernel.hpp"
+
+void kernel(stream_t in[SOURCES], line_t * out, int out_size, int items_written[SOURCES], int eos[SOURCES])
+{
+    fx::SNtoWM<LINE_BITS, SOURCES, BURST_LENGTH>(in, out, out_size, items_written, eos);
+}
@@ -0,0 +1,33 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int value;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int value)
+        : key(key), value(value)
+    {}
+};
+
+static constexpr int LINE_BITS = 256;
+static constexpr int LINE_ITEMS = LINE_BITS / (8 * sizeof(data_t));
+static constexpr int SOURCES = 3;
+static constexpr int BURST_LENGTH = 2;
+static constexpr int REGION_LINES = 4;
+static constexpr int REGION_ITEMS = REGION_LINES * LINE_ITEMS;
+static constexpr int BUFFER_LINES = SOURCES * REGION_LINES;
+static constexpr int BUFFER_SIZE = BUFFER_LINES * (LINE_BITS / 8);  // bytes
+
+using line_t = ap_uint<LINE_BITS>;
+using stream_t = fx::stream<data_t, 2>;
+
+// SNtoWM: SOURCES streams written to their own region of one buffer
+void kernel(
+    stream_t in[SOURCES],
+    line_t * out,
+    int out_size,
+    int items_written[SOURCES],
+    int eos[SOURCES]
+);
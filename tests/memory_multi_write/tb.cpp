@@ -0,0 +1,137 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define _DEBUG 0
+
+static constexpr int T_BITS = TypeHandler<data_t>::WIDTH;
+
+using input_t = std::vector<std::vector<data_t>>;
+
+
+input_t generate_input(const std::vector<int> & sizes)
+{
+    input_t data;
+    for (int j = 0; j < SOURCES; ++j) {
+        std::vector<data_t> source;
+        for (int i = 0; i < sizes[j]; ++i) {
+            source.push_back(data_t(j, i));
+        }
+        data.push_back(source);
+    }
+    return data;
+}
+
+void write_input(stream_t & in, const std::vector<data_t> & data)
+{
+    for (const auto & d : data) {
+        in.write(d);
+    }
+    in.write_eos();
+}
+
+// invokes the kernel until the sources return eos and decodes the region of
+// every source; a full region leaves the eos to the next invocation, so all
+// the sources must fill the same number of regions and end together
+input_t drain(stream_t in[SOURCES], int & invocations, bool & success)
+{
+    input_t result(SOURCES);
+    line_t buffer[BUFFER_LINES];
+    int items_written[SOURCES];
+    int eos[SOURCES];
+
+    invocations = 0;
+    bool last = false;
+    while (!last && success) {
+        for (int l = 0; l < BUFFER_LINES; ++l) {
+            buffer[l] = ~line_t(0);
+        }
+        kernel(in, buffer, BUFFER_SIZE, items_written, eos);
+        invocations++;
+
+        last = (eos[0] != 0);
+        for (int j = 0; j < SOURCES; ++j) {
+            #if _DEBUG
+            std::cout << "invocation " << invocations << ", source " << j << ": " << items_written[j] << " items, eos " << eos[j] << std::endl;
+            #endif
+
+            if ((eos[j] != 0) != last) {
+                std::cerr << "Error: source " << j << " returned eos " << eos[j] << ", source 0 " << eos[0] << std::endl;
+                success = false;
+            }
+            if (items_written[j] < 0 || items_written[j] > REGION_ITEMS || (!eos[j] && items_written[j] != REGION_ITEMS)) {
+                std::cerr << "Error: source " << j << " wrote " << items_written[j] << " items without eos " << eos[j] << std::endl;
+                success = false;
+                continue;
+            }
+            // a source writes only the lines it fills, in its own region
+            for (int l = (items_written[j] + LINE_ITEMS - 1) / LINE_ITEMS; l < REGION_LINES; ++l) {
+                if (buffer[j * REGION_LINES + l] != ~line_t(0)) {
+                    std::cerr << "Error: line " << l << " of the region of source " << j << " overwritten" << std::endl;
+                    success = false;
+                }
+            }
+            for (int i = 0; i < items_written[j]; ++i) {
+                const line_t line = buffer[j * REGION_LINES + i / LINE_ITEMS];
+                const int k = i % LINE_ITEMS;
+                result[j].push_back(TypeHandler<data_t>::from_ap(line.range(T_BITS * (k + 1) - 1, T_BITS * k)));
+            }
+        }
+    }
+    return result;
+}
+
+void test(const input_t & input, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    stream_t in[SOURCES];
+
+    for (int j = 0; j < SOURCES; ++j) {
+        write_input(in[j], input[j]);
+    }
+
+    bool success = true;
+    int invocations = 0;
+    const input_t output = drain(in, invocations, success);
+
+    for (int j = 0; j < SOURCES && success; ++j) {
+        if (output[j].size() != input[j].size()) {
+            std::cerr << "Error: source " << j << " wrote " << output[j].size() << " tuples, expected " << input[j].size() << std::endl;
+            success = false;
+        }
+        for (size_t i = 0; i < output[j].size() && i < input[j].size(); ++i) {
+            if (output[j][i].key != input[j][i].key || output[j][i].value != input[j][i].value) {
+                std::cerr << "Error: tuple " << i << " of source " << j << " is (" << output[j][i].key << ", "
+                          << output[j][i].value << ")" << std::endl;
+                success = false;
+                break;
+            }
+        }
+    }
+    const int expected = input[0].size() / REGION_ITEMS + 1;
+    if (success && invocations != expected) {
+        std::cerr << "Error: expected " << expected << " invocations, but got " << invocations << std::endl;
+        success = false;
+    }
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test(generate_input({0, 0, 0}), "empty");
+    // partial lines and an empty source in the same buffer
+    test(generate_input({1, 0, LINE_ITEMS + 3}), "partial_lines");
+    test(generate_input({REGION_ITEMS - 1, BURST_LENGTH * LINE_ITEMS, 5}), "partial_regions");
+    // full regions leave the eos to the next invocation
+    test(generate_input({REGION_ITEMS, REGION_ITEMS, REGION_ITEMS}), "full_regions");
+    test(generate_input({3 * REGION_ITEMS + 7, 3 * REGION_ITEMS, 4 * REGION_ITEMS - 1}), "multiple_buffers");
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include "kernel.hpp"
+
+void kernel(line_t * in_ring, volatile int * in_ctrl, line_t * out_ring, volatile int * out_ctrl)
+{
+    #pragma HLS DATAFLOW
+
+    fx::stream<data_t, 64> s("s");
+
+    FX_DATAFLOW;
+    FX_PROCESS(fx::WMtoS_ring<LINE_BITS, SLOTS>(in_ring, in_ctrl, IN_SLOT_LINES, s));
+    FX_PROCESS(fx::StoWM_ring<LINE_BITS, SLOTS, 4>(s, out_ring, out_ctrl, OUT_SLOT_LINES));
+}
@@ -0,0 +1,30 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int value;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int value)
+        : key(key), value(value)
+    {}
+};
+
+static constexpr int LINE_BITS = 128;
+static constexpr int LINE_ITEMS = LINE_BITS / (8 * sizeof(data_t));
+static constexpr int SLOTS = 4;
+static constexpr int IN_SLOT_LINES = 4;
+static constexpr int OUT_SLOT_LINES = 8;
+static constexpr int OUT_SLOT_ITEMS = OUT_SLOT_LINES * LINE_ITEMS;
+
+using line_t = ap_uint<LINE_BITS>;
+using ring_t = fx::ring_ctrl_t<SLOTS>;
+
+// WMtoS_ring feeding StoWM_ring, both launched once for the whole stream
+void kernel(
+    line_t * in_ring,
+    volatile int * in_ctrl,
+    line_t * out_ring,
+    volatile int * out_ctrl
+);
@@ -0,0 +1,149 @@
+#include "kernel.hpp"
+#include "../../include/host/ring.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#define _DEBUG 0
+
+static constexpr int T_BITS = TypeHandler<data_t>::WIDTH;
+
+
+std::vector<data_t> generate_input(int n)
+{
+    std::vector<data_t> data;
+    for (int i = 0; i < n; ++i) {
+        data.push_back(data_t(i % 8, i * 3));
+    }
+    return data;
+}
+
+// publishes the input in slots of IN_SLOT_LINES lines, waiting for the kernel
+// whenever the ring is full; the size of `data` is a multiple of LINE_ITEMS
+void produce(fx::RingProducer<line_t, SLOTS> & producer, const std::vector<data_t> & data)
+{
+    const int lines = data.size() / LINE_ITEMS;
+    int l = 0;
+    do {
+        line_t * slot = producer.get_batch();
+        const int count = std::min(IN_SLOT_LINES, lines - l);
+        for (int j = 0; j < count; ++j, ++l) {
+            line_t line = 0;
+            for (int k = 0; k < LINE_ITEMS; ++k) {
+                line.range(T_BITS * (k + 1) - 1, T_BITS * k) = TypeHandler<data_t>::to_ap(data[l * LINE_ITEMS + k]);
+            }
+            slot[j] = line;
+        }
+        producer.push(count, l == lines);
+    } while (l < lines);
+}
+
+// waits for StoWM_ring to fill the whole ring, then drains it
+std::vector<data_t> consume(fx::RingConsumer<line_t, SLOTS> & consumer, int * ctrl, int & slots, bool & full)
+{
+    std::vector<data_t> result;
+
+    // the kernel stops on a full ring: HEAD must not move until a slot is given back
+    full = true;
+    while (fx::ring_load(&ctrl[ring_t::HEAD]) != SLOTS) {
+        if (fx::ring_load(&ctrl[ring_t::EOS + ring_t::slot(fx::ring_load(&ctrl[ring_t::HEAD]) - 1)]) != 0) {
+            full = false;   // the stream ended first
+            break;
+        }
+        std::this_thread::yield();
+    }
+    if (full) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        full = (fx::ring_load(&ctrl[ring_t::HEAD]) == SLOTS);
+    }
+
+    slots = 0;
+    bool last = false;
+    while (!last) {
+        size_t items = 0;
+        const line_t * slot = consumer.pop(&items, &last);
+        slots++;
+
+        #if _DEBUG
+        std::cout << "slot " << slots << ": " << items << " items, last " << last << std::endl;
+        #endif
+
+        for (size_t i = 0; i < items; ++i) {
+            const line_t line = slot[i / LINE_ITEMS];
+            const int k = i % LINE_ITEMS;
+            result.push_back(TypeHandler<data_t>::from_ap(line.range(T_BITS * (k + 1) - 1, T_BITS * k)));
+        }
+        consumer.put_batch();
+    }
+    return result;
+}
+
+void test(const std::vector<data_t> & input, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+
+    std::vector<line_t> in_ring(SLOTS * IN_SLOT_LINES);
+    std::vector<line_t> out_ring(SLOTS * OUT_SLOT_LINES);
+    int in_ctrl[ring_t::WORDS] = {};
+    int out_ctrl[ring_t::WORDS] = {};
+
+    fx::RingProducer<line_t, SLOTS> producer(in_ring.data(), in_ctrl, IN_SLOT_LINES);
+    fx::RingConsumer<line_t, SLOTS> consumer(out_ring.data(), out_ctrl, OUT_SLOT_LINES);
+
+    std::thread k([&]() { kernel(in_ring.data(), in_ctrl, out_ring.data(), out_ctrl); });
+    std::thread p([&]() { produce(producer, input); });
+
+    int slots = 0;
+    bool full = false;
+    std::vector<data_t> output = consume(consumer, out_ctrl, slots, full);
+
+    p.join();
+    k.join();
+
+    bool success = true;
+    if (output.size() != input.size()) {
+        std::cerr << "Error: expected " << input.size() << " elements, but got " << output.size() << std::endl;
+        success = false;
+    }
+    for (size_t i = 0; i < output.size() && i < input.size(); ++i) {
+        if (output[i].key != input[i].key || output[i].value != input[i].value) {
+            std::cerr << "Error: element " << i << " not forwarded in order" << std::endl;
+            success = false;
+        }
+    }
+    // a full slot leaves the eos to the next one
+    const int expected_slots = input.size() / OUT_SLOT_ITEMS + 1;
+    if (slots != expected_slots) {
+        std::cerr << "Error: expected " << expected_slots << " slots, but got " << slots << std::endl;
+        success = false;
+    }
+    if (expected_slots > SLOTS && !full) {
+        std::cerr << "Error: the kernel did not wait on a full ring" << std::endl;
+        success = false;
+    }
+    if (in_ctrl[ring_t::TAIL] != in_ctrl[ring_t::HEAD] || out_ctrl[ring_t::TAIL] != out_ctrl[ring_t::HEAD]) {
+        std::cerr << "Error: slots left in the rings" << std::endl;
+        success = false;
+    }
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, "empty");
+    test(generate_input(LINE_ITEMS), "single_line");
+    test(generate_input(SLOTS * IN_SLOT_LINES * LINE_ITEMS), "one_round");
+    test(generate_input(5 * SLOTS * IN_SLOT_LINES * LINE_ITEMS + 3 * LINE_ITEMS), "wrap_around");
+    test(generate_input(4 * SLOTS * OUT_SLOT_ITEMS), "full_ring");
+
+    return 0;
+}
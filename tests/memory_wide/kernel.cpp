@@ -0,0 +1,6 @@
+#include "kernel.hpp"
+
+void kernel(line_t * in, int count, int eos, stream_t out[LINE_ITEMS])
+{
+    fx::WMtoSN<LINE_BITS>(in, count, eos, out);
+}
@@ -0,0 +1,26 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int value;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int value)
+        : key(key), value(value)
+    {}
+};
+
+static constexpr int LINE_BITS = 256;
+static constexpr int LINE_ITEMS = LINE_BITS / (8 * sizeof(data_t));
+
+using line_t = ap_uint<LINE_BITS>;
+using stream_t = fx::stream<data_t, 2>;
+
+// WMtoSN: item j of every line goes to out[j]
+void kernel(
+    line_t * in,
+    int count,
+    int eos,
+    stream_t out[LINE_ITEMS]
+);
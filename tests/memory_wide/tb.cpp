@@ -0,0 +1,114 @@
+#include "kernel.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define _DEBUG 0
+
+static constexpr int T_BITS = TypeHandler<data_t>::WIDTH;
+
+using output_t = std::vector<std::vector<data_t>>;
+
+
+// `lines` full lines of tuples
+std::vector<data_t> generate_input(int lines)
+{
+    std::vector<data_t> data;
+    for (int i = 0; i < lines * LINE_ITEMS; ++i) {
+        data.push_back(data_t(i, i * 3));
+    }
+    return data;
+}
+
+std::vector<line_t> pack_lines(const std::vector<data_t> & data)
+{
+    std::vector<line_t> lines(data.size() / LINE_ITEMS);
+    for (size_t l = 0; l < lines.size(); ++l) {
+        line_t line = 0;
+        for (int k = 0; k < LINE_ITEMS; ++k) {
+            line.range(T_BITS * (k + 1) - 1, T_BITS * k) = TypeHandler<data_t>::to_ap(data[l * LINE_ITEMS + k]);
+        }
+        lines[l] = line;
+    }
+    return lines;
+}
+
+output_t read_output(stream_t out[LINE_ITEMS])
+{
+    output_t result(LINE_ITEMS);
+    for (int j = 0; j < LINE_ITEMS; ++j) {
+        bool last = out[j].read_eos();
+        while (!last) {
+            data_t d = out[j].read();
+            last = out[j].read_eos();
+            result[j].push_back(d);
+        }
+    }
+    return result;
+}
+
+// the lines are read in batches of `batch_lines`, the last one with eos: a
+// stream sees item j of every line, in order, then a single eos
+void test(const std::vector<data_t> & input, const int batch_lines, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    stream_t out[LINE_ITEMS];
+
+    std::vector<line_t> lines = pack_lines(input);
+    const int count = lines.size();
+    line_t dummy = 0;
+
+    int invocations = 0;
+    int l = 0;
+    do {
+        const int batch = std::min(batch_lines, count - l);
+        kernel(batch ? &lines[l] : &dummy, batch, (l + batch == count) ? 1 : 0, out);
+        l += batch;
+        invocations++;
+    } while (l < count);
+
+    const output_t output = read_output(out);
+
+    #if _DEBUG
+    std::cout << invocations << " invocations" << std::endl;
+    #endif
+
+    bool success = true;
+    for (int j = 0; j < LINE_ITEMS; ++j) {
+        if (output[j].size() != lines.size()) {
+            std::cerr << "Error: stream " << j << " received " << output[j].size() << " tuples, expected " << lines.size() << std::endl;
+            success = false;
+        }
+        for (size_t i = 0; i < output[j].size() && i < lines.size(); ++i) {
+            const data_t & expected = input[i * LINE_ITEMS + j];
+            if (output[j][i].key != expected.key || output[j][i].value != expected.value) {
+                std::cerr << "Error: stream " << j << " received key " << output[j][i].key << " at " << i
+                          << ", expected " << expected.key << std::endl;
+                success = false;
+                break;
+            }
+        }
+        if (!out[j].empty() || !out[j].empty_eos()) {
+            std::cerr << "Error: stream " << j << " has data or flags left after its eos" << std::endl;
+            success = false;
+        }
+    }
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, 4, "empty");
+    test(generate_input(1), 4, "single_line");
+    test(generate_input(4), 4, "one_batch");
+    test(generate_input(37), 8, "multiple_batches");
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+#include "kernel.hpp"
+
+struct TimestampOrder
+{
+    bool operator()(const data_t & a, const data_t & b) const {
+    #pragma HLS INLINE
+        return a.timestamp <= b.timestamp;
+    }
+};
+
+struct IsWatermark
+{
+    bool operator()(const data_t & d) const {
+    #pragma HLS INLINE
+        return d.watermark != 0;
+    }
+};
+
+void kernel(
+    stream_t & shared_in,
+    stream_t & shared_out,
+    stream_t in[N],
+    stream_t & out
+)
+{
+    #pragma HLS DATAFLOW
+
+    stream_t lines[SHARED_N];
+
+    FX_DATAFLOW;
+    FX_PROCESS(fx::StoSN_RR<SHARED_N>(shared_in, lines));
+    FX_PROCESS(fx::SNtoS_Ordered<SHARED_N>(lines, shared_out, TimestampOrder(), IsWatermark()));
+    FX_PROCESS(fx::SNtoS_Ordered<N>(in, out, TimestampOrder(), IsWatermark()));
+}
@@ -0,0 +1,27 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int timestamp;
+    unsigned int watermark;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int timestamp, unsigned int watermark = 0)
+        : key(key), timestamp(timestamp), watermark(watermark)
+    {}
+};
+
+static constexpr int SHARED_N = 3;
+static constexpr int N = 4;
+
+using stream_t = fx::stream<data_t, 2>;
+
+// shared_in is dealt round robin to SHARED_N sorted streams merged back into
+// shared_out, the N sorted streams of in are merged into out
+void kernel(
+    stream_t & shared_in,
+    stream_t & shared_out,
+    stream_t in[N],
+    stream_t & out
+);
@@ -0,0 +1,146 @@
+#include "kernel.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define _DEBUG 0
+
+using input_t = std::vector<std::vector<data_t>>;
+
+
+// `n` tuples with non-decreasing timestamps (gaps in [0, max_gap]), one out
+// of `watermark_every` is a watermark (0: none)
+std::vector<data_t> generate_sorted(int n, unsigned int seed, int watermark_every = 0, unsigned int max_gap = 3)
+{
+    fx::xorshift32_t rng(seed);
+
+    std::vector<data_t> data;
+    unsigned int timestamp = 0;
+    for (int i = 0; i < n; ++i) {
+        timestamp += rng.next_below(max_gap + 1);
+        const bool watermark = (watermark_every > 0) && (i % watermark_every == watermark_every - 1);
+        data.push_back(data_t(seed * 1000 + i, timestamp, watermark));
+    }
+    return data;
+}
+
+void write_input(stream_t & in, const std::vector<data_t> & data)
+{
+    for (const auto & d : data) {
+        in.write(d);
+    }
+    in.write_eos();
+}
+
+std::vector<data_t> read_output(stream_t & out)
+{
+    std::vector<data_t> result;
+    bool last = out.read_eos();
+    while (!last) {
+        data_t d = out.read();
+        last = out.read_eos();
+        result.push_back(d);
+    }
+    return result;
+}
+
+// output holds the tuples of the inputs but the watermarks, in timestamp order
+bool check_merge(const std::vector<data_t> & output, const input_t & inputs, const std::string & name)
+{
+    std::vector<unsigned int> expected;
+    for (const auto & input : inputs) {
+        for (const auto & d : input) {
+            if (!d.watermark) {
+                expected.push_back(d.key);
+            }
+        }
+    }
+
+    bool success = true;
+    std::vector<unsigned int> got;
+    for (size_t i = 0; i < output.size(); ++i) {
+        if (output[i].watermark) {
+            std::cerr << "Error: " << name << " forwarded the watermark " << output[i].key << std::endl;
+            success = false;
+        }
+        if (i > 0 && output[i].timestamp < output[i - 1].timestamp) {
+            std::cerr << "Error: " << name << " emitted timestamp " << output[i].timestamp
+                      << " after " << output[i - 1].timestamp << std::endl;
+            success = false;
+        }
+        got.push_back(output[i].key);
+    }
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(got.begin(), got.end());
+    if (got != expected) {
+        std::cerr << "Error: " << name << " emitted " << got.size() << " tuples, expected the "
+                  << expected.size() << " tuples of its inputs" << std::endl;
+        success = false;
+    }
+    return success;
+}
+
+void test(const std::vector<data_t> & shared, const input_t & inputs, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    stream_t shared_in("shared_in");
+    stream_t shared_out("shared_out");
+    stream_t in[N];
+    stream_t out("out");
+
+    write_input(shared_in, shared);
+    for (int i = 0; i < N; ++i) {
+        write_input(in[i], inputs[i]);
+    }
+    kernel(shared_in, shared_out, in, out);
+    const std::vector<data_t> shared_result = read_output(shared_out);
+    const std::vector<data_t> result = read_output(out);
+
+    #if _DEBUG
+    for (const auto & d : result) {
+        std::cout << std::setw(8) << d.key << ", " << std::setw(8) << d.timestamp << std::endl;
+    }
+    #endif
+
+    bool success = true;
+    success &= check_merge(shared_result, input_t{shared}, "shared producer");
+    success &= check_merge(result, inputs, "independent producers");
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, input_t(N), "empty");
+
+    test(generate_sorted(1, 1), {generate_sorted(1, 1), {}, {}, {}}, "single");
+
+    test(
+        generate_sorted(512, 1),
+        {generate_sorted(256, 1), generate_sorted(256, 2), generate_sorted(256, 3), generate_sorted(256, 4)},
+        "sorted"
+    );
+
+    // equal timestamps: the merge must not wait for the input it prefers
+    test(
+        generate_sorted(512, 1, 0, 0),
+        {generate_sorted(256, 1, 0, 0), generate_sorted(256, 2, 0, 0), generate_sorted(256, 3, 0, 0), generate_sorted(256, 4, 0, 0)},
+        "equal_timestamps"
+    );
+
+    // input 2 is idle and only sends watermarks, input 3 ends at once
+    test(
+        generate_sorted(512, 1, 8),
+        {generate_sorted(256, 1, 16), generate_sorted(256, 2), generate_sorted(32, 3, 1), {}},
+        "watermarks"
+    );
+
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "kernel.hpp"
+
+struct Increment
+{
+    void operator()(const data_t & in, data_t & out) {
+    #pragma HLS INLINE
+        out = in;
+        out.value = in.value + 1;
+    }
+};
+
+void kernel(in_stream_t & in, out_stream_t & out, stats_stream_t & in_stats, stats_stream_t & out_stats)
+{
+    #pragma HLS DATAFLOW
+
+    fx::stream<data_t, 2> probed("probed");
+    fx::stream<data_t, 2> mapped("mapped");
+
+    FX_DATAFLOW;
+    FX_PROCESS(fx::Probe(in, probed, in_stats));
+    FX_PROCESS(fx::Map<Increment>(probed, mapped));
+    FX_PROCESS(fx::Probe(mapped, out, out_stats));
+}
@@ -0,0 +1,24 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    float value;
+    unsigned int timestamp;
+
+    data_t() = default;
+
+    data_t(unsigned int key, float value, unsigned int timestamp)
+        : key(key), value(value), timestamp(timestamp)
+    {}
+};
+
+using in_stream_t = fx::axis_stream<data_t, 32>;
+using out_stream_t = fx::axis_stream<data_t, 32>;
+using stats_stream_t = fx::stream<fx::probe_stats_t, 2>;
+
+void kernel(
+    in_stream_t & in,
+    out_stream_t & out,
+    stats_stream_t & in_stats,
+    stats_stream_t & out_stats
+);
@@ -0,0 +1,102 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define _DEBUG 0
+
+
+std::vector<data_t> generate_input(int n)
+{
+    std::vector<data_t> data;
+    for (int i = 0; i < n; ++i) {
+        data.push_back(data_t(i % 4, i, i));
+    }
+    return data;
+}
+
+void write_input(in_stream_t & in, const std::vector<data_t> & data)
+{
+    for (const auto & d : data) {
+        in.write(d);
+    }
+    in.write_eos();
+}
+
+std::vector<data_t> read_output(out_stream_t & out)
+{
+    std::vector<data_t> result;
+    bool last = out.read_eos();
+    while (!last) {
+        data_t d = out.read();
+        last = out.read_eos();
+        result.push_back(d);
+    }
+    return result;
+}
+
+bool check_stats(const fx::probe_stats_t & stats, const size_t tuples, const std::string & name)
+{
+    #if _DEBUG
+    std::cout << name << ": " << stats << std::endl;
+    #endif
+
+    bool success = true;
+    if (stats.tuples != tuples) {
+        std::cerr << "Error: " << name << " counted " << stats.tuples.to_uint64() << " tuples, expected " << tuples << std::endl;
+        success = false;
+    }
+    // every tuple takes a cycle, plus the one reading the leading EOS
+    if (stats.cycles < tuples + 1) {
+        std::cerr << "Error: " << name << " counted " << stats.cycles.to_uint64() << " cycles for " << tuples << " tuples" << std::endl;
+        success = false;
+    }
+    if (stats.empty_cycles > stats.cycles || stats.full_cycles > stats.cycles || stats.stall_cycles > stats.full_cycles) {
+        std::cerr << "Error: " << name << " inconsistent counters " << stats << std::endl;
+        success = false;
+    }
+    return success;
+}
+
+void test(const std::vector<data_t> & input, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    in_stream_t in("in");
+    out_stream_t out("out");
+    stats_stream_t in_stats("in_stats");
+    stats_stream_t out_stats("out_stats");
+
+    write_input(in, input);
+    kernel(in, out, in_stats, out_stats);
+    std::vector<data_t> output = read_output(out);
+
+    bool success = true;
+    if (output.size() != input.size()) {
+        std::cerr << "Error: expected " << input.size() << " elements, but got " << output.size() << std::endl;
+        success = false;
+    }
+    for (size_t i = 0; i < output.size() && i < input.size(); ++i) {
+        if (output[i].key != input[i].key || output[i].value != input[i].value + 1 || output[i].timestamp != input[i].timestamp) {
+            std::cerr << "Error: element " << i << " not forwarded in order" << std::endl;
+            success = false;
+        }
+    }
+    success &= check_stats(in_stats.read(), input.size(), "ingress");
+    success &= check_stats(out_stats.read(), input.size(), "egress");
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, "empty");
+    test(generate_input(1), "single");
+    test(generate_input(256), "pass_through");
+
+    return 0;
+}
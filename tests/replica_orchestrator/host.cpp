@@ -0,0 +1,138 @@
+// Run of a ReplicaOrchestrator with 2 replicas of a Map kernel on the CPU
+// backend, under ROUND_ROBIN and KEY_PARTITIONED: every tuple pushed reaches
+// the handler once, incremented, from the replica of its key when keyed.
+//
+//     g++ -std=c++17 -DFX_CPU_BACKEND -pthread host.cpp -o host
+
+#include "../../include/fspx.hpp"
+#include "../../include/fspx_host.hpp"
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+static constexpr int LINE_BITS = 512;
+static constexpr size_t REPLICAS = 2;
+static constexpr size_t BATCH_SIZE = 1024;
+
+struct data_t {
+    unsigned int key;
+    unsigned int value;
+};
+
+using stream_t = fx::stream<data_t, 2>;
+
+static constexpr size_t GRANULE = (LINE_BITS / 8) / sizeof(data_t);
+
+struct Increment
+{
+    void operator()(const data_t & in, data_t & out) {
+        out = in;
+        out.value = in.value + 1;
+    }
+};
+
+
+void test(const fx::ReplicaPolicy policy, const size_t total, const size_t push_size, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+
+    stream_t in[REPLICAS];
+    stream_t out[REPLICAS];
+
+    fx::OCL ocl;
+    for (size_t r = 0; r < REPLICAS; ++r) {
+        ocl.set_memory_reader(r, [&, r](void * batch, int count, int eos) {
+            fx::WMtoS<LINE_BITS>((ap_uint<LINE_BITS> *)batch, count, eos, in[r]);
+        });
+        ocl.launch([&, r]() { fx::Map<Increment>(in[r], out[r]); });
+        ocl.set_memory_writer(r, [&, r](void * batch, int size, int * items_written, int * eos) {
+            fx::StoWM<LINE_BITS>(out[r], (ap_uint<LINE_BITS> *)batch, size, items_written, eos);
+        });
+    }
+
+    std::vector<std::atomic<int>> seen(total);
+    std::atomic<size_t> lasts(0);
+    std::atomic<bool> success(true);
+    uint64_t items_in = 0;
+    uint64_t items_out = 0;
+    uint64_t dropped = 0;
+    {
+        fx::ReplicaOrchestrator<data_t> orchestrator(
+            ocl, REPLICAS, BATCH_SIZE,
+            [&](size_t replica, const data_t * batch, size_t items, bool last) {
+                for (size_t i = 0; i < items; ++i) {
+                    const data_t & d = batch[i];
+                    if (d.key >= total || d.value != d.key + 1) {
+                        std::cerr << "Error: replica " << replica << " returned a tuple never pushed (key " << d.key << ")" << std::endl;
+                        success = false;
+                        continue;
+                    }
+                    if (policy == fx::KEY_PARTITIONED && d.key % REPLICAS != replica) {
+                        std::cerr << "Error: key " << d.key << " processed by replica " << replica << std::endl;
+                        success = false;
+                    }
+                    seen[d.key]++;
+                }
+                if (last) {
+                    lasts++;
+                }
+            },
+            policy,
+            [](const data_t & d) { return size_t(d.key); },
+            2, 4, -1
+        );
+
+        size_t key = 0;
+        while (key < total) {
+            std::vector<data_t> tuples;
+            for (size_t i = 0; i < push_size && key < total; ++i, ++key) {
+                tuples.push_back(data_t{unsigned(key), unsigned(key)});
+            }
+            orchestrator.push(std::move(tuples));
+        }
+        orchestrator.finish();
+
+        items_in = orchestrator.items_in();
+        items_out = orchestrator.items_out();
+        dropped = orchestrator.items_dropped();
+    }
+    ocl.finish();
+
+    size_t delivered = 0;
+    for (size_t k = 0; k < total; ++k) {
+        if (seen[k] > 1) {
+            std::cerr << "Error: key " << k << " delivered " << seen[k] << " times" << std::endl;
+            success = false;
+        }
+        delivered += seen[k];
+    }
+    if (lasts != REPLICAS) {
+        std::cerr << "Error: " << lasts << " replicas sent their last batch, expected " << REPLICAS << std::endl;
+        success = false;
+    }
+    // at most one partial line is dropped, and it is not counted as ingested
+    if (dropped >= GRANULE || delivered + dropped != total || items_in != delivered || items_out != delivered) {
+        std::cerr << "Error: pushed " << total << ", ingested " << items_in << ", drained " << items_out
+                  << ", delivered " << delivered << ", dropped " << dropped << std::endl;
+        success = false;
+    }
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test(fx::ROUND_ROBIN, REPLICAS * GRANULE * 1000, 64 * GRANULE, "round_robin");
+    // pushes of 5 tuples leave 3 + 6 tuples on the replicas, gathered by the
+    // last one to close: one line is pushed and 1 tuple is dropped
+    test(fx::ROUND_ROBIN, 5 * 1005, 5, "round_robin_tails");
+    // consecutive keys: every replica gets whole lines
+    test(fx::KEY_PARTITIONED, REPLICAS * GRANULE * 1000, 100, "key_partitioned");
+
+    return 0;
+}
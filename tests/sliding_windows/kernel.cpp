@@ -22,11 +22,12 @@ void kernel(in_stream_t & in, out_stream_t & out)
 
     #pragma HLS DATAFLOW
 
-    fx::KeyedTimeSlidingWindowOperator<OP, MAX_KEYS, WINDOW_SIZE, WINDOW_STEP, WINDOW_LATENESS>(
+    FX_DATAFLOW;
+    FX_PROCESS(fx::KeyedTimeSlidingWindowOperator<OP, MAX_KEYS, WINDOW_SIZE, WINDOW_STEP, WINDOW_LATENESS>(
         in, result_stream, [](const data_t & d) { return d.key; }
-    );
+    ));
 
-    fx::Map<Drainer<OP, KEY_T>>(
+    FX_PROCESS(fx::Map<Drainer<OP, KEY_T>>(
         result_stream, out
-    );
+    ));
 }
\ No newline at end of file
@@ -0,0 +1,6 @@
+#include "kernel.hpp"
+
+void kernel(stream_t & in, stream_t out[N])
+{
+    fx::Split<N, KeyMask>(in, out);
+}
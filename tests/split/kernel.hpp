@@ -0,0 +1,31 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    unsigned int seq;
+
+    data_t() = default;
+
+    data_t(unsigned int key, unsigned int seq)
+        : key(key), seq(seq)
+    {}
+};
+
+static constexpr int N = 4;
+
+using stream_t = fx::stream<data_t, 2>;
+
+// the low N bits of the key are the branch mask: a tuple can go to several
+// branches at once or to none
+struct KeyMask
+{
+    void operator()(const data_t & in, ap_uint<N> & mask) {
+    #pragma HLS INLINE
+        mask = in.key;
+    }
+};
+
+void kernel(
+    stream_t & in,
+    stream_t out[N]
+);
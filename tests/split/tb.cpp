@@ -0,0 +1,116 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define _DEBUG 0
+
+static constexpr unsigned int MASKS = 1u << N;
+
+using output_t = std::vector<std::vector<data_t>>;
+
+
+// `n` tuples with masks drawn from [0, masks), or all equal to `mask`
+std::vector<data_t> generate_input(int n, unsigned int masks, int mask = -1)
+{
+    fx::xorshift32_t rng(42);
+
+    std::vector<data_t> data;
+    for (int i = 0; i < n; ++i) {
+        const unsigned int m = (mask >= 0) ? unsigned(mask) : rng.next_below(masks);
+        data.push_back(data_t(m, i));
+    }
+    return data;
+}
+
+void write_input(stream_t & in, const std::vector<data_t> & data)
+{
+    for (const auto & d : data) {
+        in.write(d);
+    }
+    in.write_eos();
+}
+
+output_t read_output(stream_t out[N])
+{
+    output_t result(N);
+    for (int b = 0; b < N; ++b) {
+        bool last = out[b].read_eos();
+        while (!last) {
+            data_t d = out[b].read();
+            last = out[b].read_eos();
+            result[b].push_back(d);
+        }
+    }
+    return result;
+}
+
+// every branch receives, in order, the tuples with its bit set in the mask,
+// then a single eos
+bool check_branches(stream_t out[N], const output_t & output, const std::vector<data_t> & input)
+{
+    bool success = true;
+    for (int b = 0; b < N; ++b) {
+        std::vector<unsigned int> expected;
+        for (const auto & d : input) {
+            if ((d.key >> b) & 1) {
+                expected.push_back(d.seq);
+            }
+        }
+
+        std::vector<unsigned int> got;
+        for (const auto & d : output[b]) {
+            got.push_back(d.seq);
+        }
+
+        if (got != expected) {
+            std::cerr << "Error: branch " << b << " received " << got.size() << " tuples, expected "
+                      << expected.size() << " (or a different order)" << std::endl;
+            success = false;
+        }
+        if (!out[b].empty() || !out[b].empty_eos()) {
+            std::cerr << "Error: branch " << b << " has data or flags left after its eos" << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+void test(const std::vector<data_t> & input, std::string test_name = "")
+{
+    std::cout << "Running test: " << test_name << std::endl;
+    stream_t in("in");
+    stream_t out[N];
+
+    write_input(in, input);
+    kernel(in, out);
+    const output_t output = read_output(out);
+
+    #if _DEBUG
+    for (int b = 0; b < N; ++b) {
+        std::cout << "branch " << b << ": " << std::setw(6) << output[b].size() << " tuples" << std::endl;
+    }
+    #endif
+
+    const bool success = check_branches(out, output, input);
+
+    if (success) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    test({}, "empty");
+    // the tuple is dropped, every branch gets only its eos
+    test(generate_input(1, MASKS, 0), "empty_mask");
+    test(generate_input(1, MASKS, MASKS - 1), "all_branches");
+    // branches 0, 1 and 3 see no tuple but still end
+    test(generate_input(64, MASKS, 1 << 2), "one_branch");
+    test(generate_input(1024, MASKS), "random_masks");
+
+    return 0;
+}
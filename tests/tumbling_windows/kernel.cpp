@@ -596,13 +596,14 @@ void test(in_stream_t & in, out_stream_t & out)
 
     #pragma HLS DATAFLOW
 
-    fx::KeyedTimeTumblingWindowOperator<OP, MAX_KEYS, WINDOW_SIZE, WINDOW_LATENESS>(
+    FX_DATAFLOW;
+    FX_PROCESS(fx::KeyedTimeTumblingWindowOperator<OP, MAX_KEYS, WINDOW_SIZE, WINDOW_LATENESS>(
         in, result_stream, [](const data_t & d) { return d.key; }
-    );
+    ));
 
-    fx::Map<Drainer<OP, KEY_T>>(
+    FX_PROCESS(fx::Map<Drainer<OP, KEY_T>>(
         result_stream, out
-    );
+    ));
 }
 #endif
 
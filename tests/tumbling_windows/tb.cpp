@@ -2,7 +2,6 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
-#include <random>
 #include <map>
 
 #define _DEBUG 1
@@ -27,13 +26,8 @@ std::vector<data_t> generate_test_even_timestamps(int n, int max_keys)
 
 std::vector<data_t> generate_test_random_timestamps(int n, int max_keys)
 {
-    // random generator with a given seed
-    // std::mt19937 gen(42);
-
-    // random generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<unsigned int> dist(0, 16);
+    // seeded generator of the library, timestamps in [0, 16]
+    fx::xorshift32_t rng(42);
 
     std::vector<data_t> data;
     for (int i = 0; i < n; ++i) {
@@ -42,7 +36,7 @@ std::vector<data_t> generate_test_random_timestamps(int n, int max_keys)
             d.key = k;
             d.value = i;
             d.aggregate = 0;
-            d.timestamp = dist(gen);
+            d.timestamp = rng.next_below(17);
 
             data.push_back(d);
         }
@@ -0,0 +1,23 @@
+#include "kernel.hpp"
+
+struct Builder
+{
+    void operator()(const unsigned int index, const unsigned int key, const unsigned int timestamp, data_t & out) {
+    #pragma HLS INLINE
+        out.key = key;
+        out.value = index;
+        out.aggregate = 0;
+        out.timestamp = timestamp;
+    }
+};
+
+void kernel(out_stream_t & uniform_out, out_stream_t & zipf_out, unsigned int count, unsigned int seed)
+{
+    fx::uniform_keys_t<MAX_KEYS> uniform_keys(seed);
+    fx::zipf_keys_t<MAX_KEYS> zipf_keys(ZIPF_EXPONENT, seed);
+
+    #pragma HLS DATAFLOW
+
+    fx::WorkloadGenerator<Builder, DISORDER, RATE_NUM, RATE_DEN>(uniform_out, count, seed, uniform_keys);
+    fx::WorkloadGenerator<Builder, DISORDER>(zipf_out, count, seed, zipf_keys);
+}
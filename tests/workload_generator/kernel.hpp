@@ -0,0 +1,29 @@
+#include "../../include/fspx.hpp"
+
+struct data_t {
+    unsigned int key;
+    float value;
+    float aggregate;
+    unsigned int timestamp;
+
+    data_t() = default;
+
+    data_t(unsigned int key, float value, float aggregate, unsigned int timestamp)
+        : key(key), value(value), aggregate(aggregate), timestamp(timestamp)
+    {}
+};
+
+static constexpr unsigned int MAX_KEYS = 64;
+static constexpr unsigned int DISORDER = 8;
+static constexpr unsigned int RATE_NUM = 1;
+static constexpr unsigned int RATE_DEN = 2;
+static constexpr float ZIPF_EXPONENT = 1.2f;
+
+using out_stream_t = fx::axis_stream<data_t, 32>;
+
+void kernel(
+    out_stream_t & uniform_out,
+    out_stream_t & zipf_out,
+    unsigned int count,
+    unsigned int seed
+);
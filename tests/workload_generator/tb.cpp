@@ -0,0 +1,107 @@
+#include "kernel.hpp"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+
+std::vector<data_t> read_output(out_stream_t & out)
+{
+    std::vector<data_t> result;
+    bool last = out.read_eos();
+    while (!last) {
+        result.push_back(out.read());
+        last = out.read_eos();
+    }
+    return result;
+}
+
+bool same_stream(const std::vector<data_t> & a, const std::vector<data_t> & b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].key != b[i].key || a[i].timestamp != b[i].timestamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool check_stream(const std::vector<data_t> & data, unsigned int count)
+{
+    bool success = true;
+    if (data.size() != count) {
+        std::cerr << "Error: expected " << count << " elements, but got " << data.size() << std::endl;
+        success = false;
+    }
+
+    unsigned int max_timestamp = 0;
+    for (const auto & d : data) {
+        if (d.key >= MAX_KEYS) {
+            std::cerr << "Error: key " << d.key << " out of range" << std::endl;
+            success = false;
+        }
+        if (d.timestamp + DISORDER < max_timestamp) {
+            std::cerr << "Error: timestamp " << d.timestamp << " is more than " << DISORDER << " behind " << max_timestamp << std::endl;
+            success = false;
+        }
+        max_timestamp = std::max(max_timestamp, d.timestamp);
+    }
+    return success;
+}
+
+std::vector<unsigned int> histogram(const std::vector<data_t> & data)
+{
+    std::vector<unsigned int> h(MAX_KEYS, 0);
+    for (const auto & d : data) {
+        h[d.key]++;
+    }
+    return h;
+}
+
+void run(unsigned int count, unsigned int seed, std::vector<data_t> & uniform, std::vector<data_t> & zipf)
+{
+    out_stream_t uniform_out("uniform_out");
+    out_stream_t zipf_out("zipf_out");
+    kernel(uniform_out, zipf_out, count, seed);
+    uniform = read_output(uniform_out);
+    zipf = read_output(zipf_out);
+}
+
+void check(bool condition, std::string test_name)
+{
+    if (condition) {
+        std::cout << "Test " << test_name << " PASSED" << std::endl;
+    } else {
+        std::cerr << "Test " << test_name << " FAILED" << std::endl;
+        exit(1);
+    }
+}
+
+int main() {
+
+    const unsigned int count = 4096;
+
+    std::vector<data_t> uniform_a, zipf_a, uniform_b, zipf_b, uniform_c, zipf_c;
+    run(0, 42, uniform_a, zipf_a);
+    check(uniform_a.empty() && zipf_a.empty(), "empty");
+
+    run(count, 42, uniform_a, zipf_a);
+    run(count, 42, uniform_b, zipf_b);
+    run(count, 7, uniform_c, zipf_c);
+
+    check(check_stream(uniform_a, count) && check_stream(zipf_a, count), "bounded_disorder");
+    check(same_stream(uniform_a, uniform_b) && same_stream(zipf_a, zipf_b), "same_seed");
+    check(!same_stream(uniform_a, uniform_c) && !same_stream(zipf_a, zipf_c), "different_seed");
+
+    // uniform: no key gets more than twice its fair share
+    const auto hu = histogram(uniform_a);
+    check(*std::max_element(hu.begin(), hu.end()) < 2 * count / MAX_KEYS, "uniform_keys");
+
+    // zipf: the first key is the most frequent one and is heavily skewed
+    const auto hz = histogram(zipf_a);
+    check(std::max_element(hz.begin(), hz.end()) == hz.begin() && hz[0] > 4 * count / MAX_KEYS, "zipf_keys");
+
+    return 0;
+}